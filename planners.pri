@@ -0,0 +1,45 @@
+# Planner core: shared by the GUI application (rastersim.pro) and the
+# headless benchmark tool (rastersim-bench.pro)
+
+QMAKE_CXXFLAGS += -std=c++11
+
+# search effort counters (AbstractPlanner::counters()), compiled out in release builds
+CONFIG(debug, debug|release)|CONFIG(counters): DEFINES += PLANNER_COUNTERS
+# heap allocation counters (AllocationCounters), replace malloc() and free() of the whole application
+CONFIG(alloccounters): DEFINES += ALLOCATION_COUNTERS
+
+HEADERS +=  src/data.h \
+			src/abstractplanner.h \
+			src/plannerobserver.h \
+			src/stephistory.h \
+			src/deltastepping.h \
+			src/astarplanner.h \
+			src/dstarplanner.h \
+			src/fdstarplanner.h \
+			src/dstarliteplanner.h \
+			src/hdastarplanner.h \
+			src/bidirectionalastarplanner.h \
+			src/plannerfactory.h \
+			src/maputils.h \
+			src/sessionlog.h \
+			src/metricsexporter.h \
+			src/trace.h \
+			src/perfcounters.h \
+			src/allocationcounters.h
+
+SOURCES += 	src/data.cpp \
+			src/abstractplanner.cpp \
+			src/deltastepping.cpp \
+			src/astarplanner.cpp \
+			src/dstarplanner.cpp \
+			src/fdstarplanner.cpp \
+			src/dstarliteplanner.cpp \
+			src/hdastarplanner.cpp \
+			src/bidirectionalastarplanner.cpp \
+			src/plannerfactory.cpp \
+			src/maputils.cpp \
+			src/sessionlog.cpp \
+			src/metricsexporter.cpp \
+			src/trace.cpp \
+			src/perfcounters.cpp \
+			src/allocationcounters.cpp
@@ -0,0 +1,49 @@
+TEMPLATE = app
+TARGET = rastersim-bench
+CONFIG += console
+CONFIG -= app_bundle
+
+DEPENDPATH += .
+INCLUDEPATH += .
+
+unix:DESTDIR = bin_unix
+win32:DESTDIR = bin_win
+
+unix:MOC_DIR = tmp_unix/bench/
+win32:MOC_DIR = tmp_win/bench/
+unix:OBJECTS_DIR = tmp_unix/bench/
+win32:OBJECTS_DIR = tmp_win/bench/
+
+unix:MAKEFILE = Makefile.bench
+win32:MAKEFILE = Makefile.bench.win
+QMAKE_CXXFLAGS += -g
+
+# always count search effort and heap allocations in the benchmark tool
+CONFIG += counters alloccounters
+
+# Input
+include(planners.pri)
+
+HEADERS +=  src/plannerbench.h \
+			src/benchreport.h \
+			src/plannercheck.h \
+			src/scenario.h \
+			src/mapedit.h \
+			src/mapgenerator.h \
+			src/xorshift.h
+
+SOURCES += 	src/benchmain.cpp \
+			src/plannerbench.cpp \
+			src/benchreport.cpp \
+			src/plannercheck.cpp \
+			src/scenario.cpp \
+			src/mapedit.cpp \
+			src/mapgenerator.cpp
+
+# "make -f Makefile.bench check": all planners must find paths of equal cost on the bundled and some generated maps
+# and must not allocate after the first query on a map,
+# pass CHECK_ARGS="--baseline <file>" to also fail on regressions against a baseline saved with --save-baseline
+check.commands = $$DESTDIR/$$TARGET --quiet --check --alloc-free -n 20 maps/office.png maps/hall.png maps/BAR-S-Gang.png \
+				 gen:maze:size=256 gen:rooms:size=512 gen:field:size=512:density=0.1 $(CHECK_ARGS)
+check.depends = $$DESTDIR/$$TARGET
+QMAKE_EXTRA_TARGETS += check
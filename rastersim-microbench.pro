@@ -0,0 +1,31 @@
+TEMPLATE = app
+TARGET = rastersim-microbench
+CONFIG += console
+CONFIG -= app_bundle
+
+DEPENDPATH += .
+INCLUDEPATH += .
+
+unix:DESTDIR = bin_unix
+win32:DESTDIR = bin_win
+
+unix:MOC_DIR = tmp_unix/microbench/
+win32:MOC_DIR = tmp_win/microbench/
+unix:OBJECTS_DIR = tmp_unix/microbench/
+win32:OBJECTS_DIR = tmp_win/microbench/
+
+unix:MAKEFILE = Makefile.microbench
+win32:MAKEFILE = Makefile.microbench.win
+
+# kernels are measured as built for release, without search effort counters
+CONFIG -= debug
+CONFIG += release
+
+# Input
+include(planners.pri)
+
+HEADERS +=  src/microbench.h \
+			src/xorshift.h
+
+SOURCES += 	src/microbench.cpp \
+			src/plannermicrobench.cpp
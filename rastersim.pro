@@ -23,32 +23,31 @@ win32:MAKEFILE = Makefile.win
 QMAKE_CXXFLAGS += -g
 
 # Input
-HEADERS +=  src/data.h \
-			src/robot.h \
-			src/abstractplanner.h \
-			src/astarplanner.h \
-			src/dstarplanner.h \
-			src/fdstarplanner.h \
-			src/dstarliteplanner.h \
+include(planners.pri)
+
+HEADERS +=  src/robot.h \
 			src/simmainwindow.h \
 			src/simwidget.h \
 			src/zoomablewidget.h \
 			src/visualizationwidget.h \
 			src/flowlayout.h \
+			src/performancewidget.h \
+			src/comparisonwidget.h \
+			src/comparisonworker.h \
+			src/plannerbench.h \
+			src/xorshift.h \
 			src/rlcpens.h
 
 
 SOURCES += 	src/main.cpp \
-			src/data.cpp \
 			src/robot.cpp \
-			src/abstractplanner.cpp \
-			src/astarplanner.cpp \
-			src/dstarplanner.cpp \
-			src/fdstarplanner.cpp \
-			src/dstarliteplanner.cpp \
 			src/zoomablewidget.cpp \
 			src/visualizationwidget.cpp \
 			src/flowlayout.cpp \
+			src/performancewidget.cpp \
+			src/comparisonwidget.cpp \
+			src/comparisonworker.cpp \
+			src/plannerbench.cpp \
 			src/simwidget.cpp \
 			src/simmainwindow.cpp \
 			src/rlcpens.cpp
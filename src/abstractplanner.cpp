@@ -17,59 +17,232 @@
  */
 
 #include "abstractplanner.h"
+#include "trace.h"
+#include <QThread>
+#include <QWaitCondition>
+#include <QAction>
+#include <QPainter>
 #include <QRectF>
-#include <QTime>
 #include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <atomic>
+
+static inline int64_t timestampNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// counts the expansions of the heat map
+class AbstractPlanner::HeatMapObserver: public PlannerObserver {
+public:
+	HeatMapObserver(AbstractPlanner *planner): planner(planner) { }
+	void expanded(int x, int y) {
+		int idx = y * planner->_mapSize.width() + x;
+		planner->_heatQuery[idx]++;
+		planner->_heatTotal[idx]++;
+		planner->heatImagesValid = false;
+	}
+private:
+	AbstractPlanner *planner;
+};
+
+// merged inputs of the next call in background mode, see setBackgroundPlanning()
+struct AbstractPlanner::PendingInputs {
+	PendingInputs() { clear(); }
+	void clear() {
+		newMap = hasStart = hasGoal = resume = false;
+		map = QImage();
+		updateRegion = QRect();
+	}
+	bool isEmpty() const { return !newMap && updateRegion.isEmpty() && !hasStart && !hasGoal && !resume; }
+	
+	bool newMap;			// map is a new map, otherwise updateRegion of map has changed (if not empty)
+	QImage map;
+	QRect updateRegion;
+	bool hasStart, hasGoal;
+	Pose2D start, goal;
+	bool resume; // continuePlanning() has been called
+};
+
+/* takes the pending inputs, plans them with planInputs() and waits until the result has been published
+ * by publishResult() in the planner's thread
+ */
+class AbstractPlanner::PlanningThread: public QThread {
+public:
+	PlanningThread(AbstractPlanner *planner): planner(planner), running(false), publishing(false), quit(false) { }
+	
+	void setMap(const QImage &map) {
+		QMutexLocker locker(&mutex);
+		inputs.newMap = true;
+		inputs.map = map;
+		inputs.updateRegion = QRect();
+		inputs.hasStart = inputs.hasGoal = false; // a new map invalidates start and goal
+		inputPosted.wakeOne();
+	}
+	void updateMap(const QImage &map, const QRect &updateRegion) {
+		QMutexLocker locker(&mutex);
+		if(inputs.newMap || inputs.updateRegion.isEmpty() || map.size() == inputs.map.size()) {
+			if(!inputs.newMap) inputs.updateRegion |= updateRegion;
+			if(inputs.newMap && map.size() != inputs.map.size()) inputs.hasStart = inputs.hasGoal = false;
+			inputs.map = map;
+		} else {
+			// the size has changed since the last pending update, set as new map like AbstractPlanner::updateMap()
+			inputs.clear();
+			inputs.newMap = true;
+			inputs.map = map;
+		}
+		inputPosted.wakeOne();
+	}
+	void setStart(const Pose2D &start) {
+		QMutexLocker locker(&mutex);
+		inputs.hasStart = true;
+		inputs.start = start;
+		inputPosted.wakeOne();
+	}
+	void setGoal(const Pose2D &goal) {
+		QMutexLocker locker(&mutex);
+		inputs.hasGoal = true;
+		inputs.goal = goal;
+		inputPosted.wakeOne();
+	}
+	void setStartGoal(const Pose2D &start, const Pose2D &goal) {
+		QMutexLocker locker(&mutex);
+		inputs.hasStart = inputs.hasGoal = true;
+		inputs.start = start;
+		inputs.goal = goal;
+		inputPosted.wakeOne();
+	}
+	
+	void resume() {
+		QMutexLocker locker(&mutex);
+		inputs.resume = true;
+		inputPosted.wakeOne();
+	}
+	
+	bool isPlanning() const {
+		QMutexLocker locker(&mutex);
+		return running || !inputs.isEmpty();
+	}
+	void cancel() {
+		QMutexLocker locker(&mutex);
+		if(running) planner->_cancelRequested = true;
+	}
+	void published() {
+		QMutexLocker locker(&mutex);
+		publishing = false;
+		resultPublished.wakeOne();
+	}
+	// cancels the running call and drops pending inputs
+	void stop() {
+		mutex.lock();
+		quit = true;
+		inputs.clear();
+		if(running) planner->_cancelRequested = true;
+		inputPosted.wakeOne();
+		resultPublished.wakeOne();
+		mutex.unlock();
+		wait();
+	}
+	
+protected:
+	void run() {
+		Trace::setThreadName("Planner");
+		mutex.lock();
+		while(true) {
+			while(inputs.isEmpty() && !quit) inputPosted.wait(&mutex);
+			if(quit) break;
+			PendingInputs batch = inputs;
+			inputs.clear();
+			running = true;
+			planner->_cancelRequested = false;
+			mutex.unlock();
+			
+			bool publish = planner->planInputs(batch);
+			
+			mutex.lock();
+			running = false;
+			planner->_cancelRequested = false; // stepping between calls is not to be interrupted
+			if(publish && !quit) {
+				publishing = true;
+				QMetaObject::invokeMethod(planner, "publishResult", Qt::QueuedConnection);
+				while(publishing && !quit) resultPublished.wait(&mutex);
+			}
+		}
+		mutex.unlock();
+	}
+	
+private:
+	AbstractPlanner *planner;
+	mutable QMutex mutex; // guards the members below
+	QWaitCondition inputPosted, resultPublished;
+	PendingInputs inputs;
+	bool running, publishing, quit;
+};
 
 AbstractPlanner::AbstractPlanner(QObject *parent): 
 	QObject(parent),
 	_start(Pose2D::invalid()), _goal(Pose2D::invalid()),
-	_calcTimeMs(-1), 
+	_calcTimeNs(-1), _callCount(0), _allocationFree(false), _warmedUp(false), _pathReserve(1 << 20), _allocationViolations(0),
+	_phaseStartNs(0), _currentPhase(Phase_Search),
 	inDestructor(false),
-	accumulatedInputUpdates(NoInputUpdates)
+	searchLayerObserver(NULL), searchLayersAction(NULL), _searchLayersEnabled(false), heatMapObserver(NULL),
+	queryHeatLayer(NULL), totalHeatLayer(NULL), _heatQuery(NULL), _heatTotal(NULL), heatImagesValid(false),
+	accumulatedInputUpdates(NoInputUpdates), _lastInputUpdates(NoInputUpdates), _keepInputUpdates(false),
+	planningThread(NULL), _dataMutex(QMutex::Recursive), _cancelRequested(false), _callRunning(false),
+	_timeBudgetNs(0), _expansionBudget(0), _budgetLimited(false), _budgetExhausted(false), _planComplete(true),
+	_budgetDeadlineNs(0), _budgetSteps(0),
+	deferConfigChanges(false)
 {
+	_lastError[0] = 0;
+	for(int i = 0; i < NumTimingPhases; i++) _phaseTimeNs[i] = 0;
+	for(int i = 0; i < NumMemoryComponents; i++) _memoryUsage[i] = _peakMemoryUsage[i] = 0;
+	_peakTotalMemoryUsage = 0;
+	_stepHistoryBudget = 64 << 20;
 	
+	heatMapAction = new QAction(tr("Heat map"), this);
+	heatMapAction->setCheckable(true);
+	heatMapAction->setToolTip(tr("Count cell expansions per call and since the heat map was enabled"));
+	connect(heatMapAction, SIGNAL(toggled(bool)), this, SLOT(setHeatMapEnabled(bool)));
+	addAction(heatMapAction);
 }
 
 AbstractPlanner::~AbstractPlanner() {	
+	setBackgroundPlanning(false); // should have been stopped before the subclass data was freed
 	inDestructor = true;
+	delete heatMapObserver;
 	while(!_debugLayers.empty()) delete _debugLayers.takeLast();
 }
 
 void AbstractPlanner::setStart(const Pose2D &start) {	
-	if(!start.isValid()) {
-		_start = start; 
-		_path.clear();
-		emit dataChanged();
+	if(planningThread) {
+		planningThread->setStart(start);
 		return;
 	}
-	if(QRect(QPoint(0, 0), _mapSize).contains(start.pos().toPoint())) {
-		_start = start;
-		accumulatedInputUpdates |= UpdatedStart;
-		callPlanner();		
-	}
+	if(!applyStart(start)) return;
+	if(!start.isValid()) emit dataChanged();
+	else if(callPlanner()) emit dataChanged();
 }
 
 void AbstractPlanner::setStart(const QPointF &start) {
 	setStart(Pose2D(start, isnan(_start.angle()) ? 0.0 : _start.angle()));
 }
 void AbstractPlanner::setGoal(const Pose2D &goal) {
-	if(!goal.isValid()) {
-		_goal = goal;
-		_path.clear();
-		emit dataChanged();
+	if(planningThread) {
+		planningThread->setGoal(goal);
 		return;
 	}
-	if(QRect(QPoint(0, 0), _mapSize).contains(goal.pos().toPoint())) {
-		_goal = goal;
-		accumulatedInputUpdates |= UpdatedGoal;
-		callPlanner();
-	}	
+	if(!applyGoal(goal)) return;
+	if(!goal.isValid()) emit dataChanged();
+	else if(callPlanner()) emit dataChanged();
 }
 void AbstractPlanner::setGoal(const QPointF &goal) {
 	setGoal(Pose2D(goal, isnan(_goal.angle()) ? 0.0 : _goal.angle()));
 }
 void AbstractPlanner::setStartGoal(const Pose2D &start, const Pose2D &goal) {
+	if(planningThread) {
+		planningThread->setStartGoal(start, goal);
+		return;
+	}
 	bool startValid = start.isValid();
 	bool goalValid = goal.isValid();
 	if(startValid && goalValid) {
@@ -77,10 +250,9 @@ void AbstractPlanner::setStartGoal(const Pose2D &start, const Pose2D &goal) {
 		if(!rc.contains(start.pos().toPoint())) return;
 		if(!rc.contains(goal.pos().toPoint())) return;
 		
-		_start = start;
-		_goal = goal;
-		accumulatedInputUpdates |= UpdatedStart | UpdatedGoal;
-		callPlanner();		
+		applyStart(start);
+		applyGoal(goal);
+		if(callPlanner()) emit dataChanged();
 	} else {
 		if(!startValid) {
 			setStart(start);
@@ -98,59 +270,380 @@ void AbstractPlanner::setStartGoal(const QPointF &start, const QPointF &goal) {
 
 void AbstractPlanner::setMap(const QImage &mapData) {
 	if(mapData.format() != QImage::Format_Indexed8) return;
-	
-	_start = Pose2D::invalid();
-	_goal = Pose2D::invalid();
-	
-	_path.clear();
-	_mapSize = mapData.size();
-	initMap(mapData, QRect());
-	accumulatedInputUpdates = NewMap;
-		
+	if(planningThread) {
+		planningThread->setMap(mapData);
+		return;
+	}
+	applyMap(mapData);
 	emit dataChanged();
 }
 
 void AbstractPlanner::updateMap(const QImage &mapData, const QRect &updateRegion) {
 	if(mapData.format() != QImage::Format_Indexed8) return;
+	if(planningThread) {
+		if(!updateRegion.isEmpty() && mapData.rect().contains(updateRegion)) planningThread->updateMap(mapData, updateRegion);
+		return;
+	}
 	
 	if(mapData.size() == _mapSize) {
 		if(updateRegion.isEmpty() || !mapData.rect().contains(updateRegion)) return;
 		
-		initMap(mapData, updateRegion);
-		if(!(accumulatedInputUpdates & NewMap)) accumulatedInputUpdates |= UpdatedMap;
-		callPlanner();
+		resetCallStatistics();
+		applyMapUpdate(mapData, updateRegion);
+		if(callPlanner(false)) emit dataChanged();
 	} else setMap(mapData);	
 }
 
+/* the apply functions change the inputs without calling the planner, they return false if the input is
+ * ignored (e.g. outside of the map)
+ */
+bool AbstractPlanner::applyStart(const Pose2D &start) {
+	if(!start.isValid()) {
+		_start = start; 
+		_path.clear();
+		return true;
+	}
+	if(!QRect(QPoint(0, 0), _mapSize).contains(start.pos().toPoint())) return false;
+	_start = start;
+	accumulatedInputUpdates |= UpdatedStart;
+	return true;
+}
+
+bool AbstractPlanner::applyGoal(const Pose2D &goal) {
+	if(!goal.isValid()) {
+		_goal = goal;
+		_path.clear();
+		return true;
+	}
+	if(!QRect(QPoint(0, 0), _mapSize).contains(goal.pos().toPoint())) return false;
+	_goal = goal;
+	accumulatedInputUpdates |= UpdatedGoal;
+	return true;
+}
+
+bool AbstractPlanner::applyMap(const QImage &mapData) {
+	if(mapData.format() != QImage::Format_Indexed8) return false;
+	
+	_start = Pose2D::invalid();
+	_goal = Pose2D::invalid();
+	
+	_path.clear();
+	_mapSize = mapData.size();
+	_warmedUp = false;
+	if(_allocationFree) reservePath();
+	if(heatMapEnabled()) resetHeatMap();
+	{
+		TRACE_SCOPE_DETAIL("initMap", metaObject()->className());
+		initMap(mapData, QRect());
+	}
+	accumulatedInputUpdates = NewMap;
+	return true;
+}
+
+// a map of another size is set as new map
+bool AbstractPlanner::applyMapUpdate(const QImage &mapData, const QRect &updateRegion) {
+	if(mapData.size() != _mapSize) return applyMap(mapData);
+	if(updateRegion.isEmpty() || !mapData.rect().contains(updateRegion)) return false;
+	{
+		TRACE_SCOPE_DETAIL("initMap", metaObject()->className());
+		initMap(mapData, updateRegion);
+	}
+	if(!(accumulatedInputUpdates & NewMap)) accumulatedInputUpdates |= UpdatedMap;
+	return true;
+}
+
+void AbstractPlanner::resetCallStatistics() {
+	_allocationsStart = AllocationCounters::current();
+	_counters.clear();
+	clearQueryHeat();
+}
+
+void AbstractPlanner::setBackgroundPlanning(bool enabled) {
+	if(enabled == backgroundPlanning()) return;
+	if(enabled) {
+		planningThread = new PlanningThread(this);
+		planningThread->start();
+	} else {
+		planningThread->stop();
+		delete planningThread;
+		planningThread = NULL;
+	}
+}
+
+bool AbstractPlanner::isPlanning() const {
+	return planningThread && planningThread->isPlanning();
+}
+
+void AbstractPlanner::cancel() {
+	if(planningThread) planningThread->cancel();
+	else if(_callRunning) _cancelRequested = true;
+}
+
+void AbstractPlanner::setBudget(int64_t timeNs, uint64_t expansions) {
+	QMutexLocker locker(&_dataMutex);
+	_timeBudgetNs = qMax(timeNs, (int64_t)0);
+	_expansionBudget = expansions;
+}
+
+bool AbstractPlanner::budgetUsedUp() {
+	if(_budgetExhausted) return true;
+	_budgetSteps++;
+	if(_expansionBudget && _budgetSteps > _expansionBudget) _budgetExhausted = true;
+	else if(_timeBudgetNs && !(_budgetSteps & 63) && timestampNs() >= _budgetDeadlineNs) _budgetExhausted = true;
+	return _budgetExhausted;
+}
+
+void AbstractPlanner::continuePlanning() {
+	if(planningThread) {
+		planningThread->resume();
+		return;
+	}
+	if(_planComplete) return;
+	if(callPlanner()) emit dataChanged();
+}
+
+/* called by the planning thread: applies the merged inputs like the input setters and calls the planner once,
+ * returns true if the result is to be published (cancelled calls are not)
+ */
+bool AbstractPlanner::planInputs(const PendingInputs &inputs) {
+	QMutexLocker locker(&_dataMutex);
+	deferConfigChanges = true;
+	resetCallStatistics();
+	bool changed = false;
+	if(inputs.newMap) changed |= applyMap(inputs.map);
+	if(inputs.hasStart) changed |= applyStart(inputs.start);
+	if(inputs.hasGoal) changed |= applyGoal(inputs.goal);
+	// incremental planners need a valid start when repairing the map
+	if(!inputs.newMap && !inputs.updateRegion.isEmpty()) changed |= applyMapUpdate(inputs.map, inputs.updateRegion);
+	bool called = (changed || (inputs.resume && !_planComplete)) && callPlanner(false);
+	deferConfigChanges = false;
+	return called ? !cancelled() : changed;
+}
+
+// runs in the planner's thread while the planning thread waits
+void AbstractPlanner::publishResult() {
+	while(!deferredConfigChanges.isEmpty()) {
+		ConfigChangeEvent event = deferredConfigChanges.takeFirst();
+		emit configChanged(event.element, event.type, event.index);
+	}
+	emit dataChanged();
+	if(planningThread) planningThread->published();
+}
+
 void AbstractPlanner::setPath(const Path &path) {
-	_path = path;
-	if(!_path.empty()) _lastError.clear();
+	if(&path != &_path) _path = path;
+	if(!_path.empty()) _lastError[0] = 0;
+}
+void AbstractPlanner::Counters::clear() {
+	expansions = heapInserts = decreaseKeys = heapUpSwaps = heapDownSwaps = cellsTouched = processStateCalls = updateVertexCalls = 0;
+}
+
+AbstractPlanner::Counters &AbstractPlanner::Counters::operator+=(const Counters &other) {
+	expansions += other.expansions;
+	heapInserts += other.heapInserts;
+	decreaseKeys += other.decreaseKeys;
+	heapUpSwaps += other.heapUpSwaps;
+	heapDownSwaps += other.heapDownSwaps;
+	cellsTouched += other.cellsTouched;
+	processStateCalls += other.processStateCalls;
+	updateVertexCalls += other.updateVertexCalls;
+	return *this;
 }
+
+static std::atomic<bool> hardwareCountersOn(false);
+
+void AbstractPlanner::setHardwareCountersEnabled(bool enabled) {
+	hardwareCountersOn = enabled;
+}
+bool AbstractPlanner::hardwareCountersEnabled() {
+	return hardwareCountersOn;
+}
+
+bool AbstractPlanner::countersEnabled() {
+#ifdef PLANNER_COUNTERS
+	return true;
+#else
+	return false;
+#endif
+}
+
+void AbstractPlanner::beginPhase(TimingPhase phase) {
+	if(!_phaseStartNs) return; // not called from within callPlanner(), e.g. single stepping
+	int64_t now = timestampNs();
+	_phaseTimeNs[_currentPhase] += now - _phaseStartNs;
+	_phaseStartNs = now;
+	_currentPhase = phase;
+}
+
+QString AbstractPlanner::phaseName(TimingPhase phase) {
+	switch(phase) {
+	case Phase_Reset: return tr("Reset");
+	case Phase_Search: return tr("Search");
+	case Phase_PathExtraction: return tr("Path extraction");
+	case Phase_DebugLayers: return tr("Debug layers");
+	default: return QString();
+	}
+}
+
+void AbstractPlanner::setMemoryUsage(MemoryComponent component, int64_t bytes) {
+	_memoryUsage[component] = bytes;
+	_peakMemoryUsage[component] = qMax(_peakMemoryUsage[component], bytes);
+	_peakTotalMemoryUsage = qMax(_peakTotalMemoryUsage, memoryUsage());
+}
+
+int64_t AbstractPlanner::memoryUsage() const {
+	int64_t total = 0;
+	for(int i = 0; i < NumMemoryComponents; i++) total += _memoryUsage[i];
+	return total;
+}
+
+QString AbstractPlanner::memoryComponentName(MemoryComponent component) {
+	switch(component) {
+	case Memory_Cells: return tr("Cells");
+	case Memory_OpenList: return tr("Open list");
+	case Memory_DebugImages: return tr("Debug images");
+	case Memory_Tables: return tr("Tables");
+	case Memory_HeatMap: return tr("Heat map");
+	case Memory_Path: return tr("Path");
+	case Memory_StepHistory: return tr("Step history");
+	case Memory_CostField: return tr("Cost field");
+	default: return QString();
+	}
+}
+
+const QString &AbstractPlanner::lastError() const {
+	_lastErrorString = QString::fromUtf8(_lastError);
+	return _lastErrorString;
+}
+
+// encodes the string as UTF-8 directly into the error buffer (QString::toUtf8() would allocate)
 void AbstractPlanner::setError(const QString &str) {
-	_lastError = str;
+	const QChar *pChar = str.unicode();
+	int length = str.size(), pos = 0;
+	for(int i = 0; i < length; i++) {
+		unsigned code = pChar[i].unicode();
+		if(code >= 0xd800 && code < 0xdc00 && i + 1 < length && pChar[i + 1].unicode() >= 0xdc00 && pChar[i + 1].unicode() < 0xe000) {
+			code = 0x10000 + ((code - 0xd800) << 10) + (pChar[++i].unicode() - 0xdc00);
+		}
+		char bytes[4];
+		int numBytes;
+		if(code < 0x80) {
+			bytes[0] = code;
+			numBytes = 1;
+		} else if(code < 0x800) {
+			bytes[0] = 0xc0 | (code >> 6);
+			bytes[1] = 0x80 | (code & 0x3f);
+			numBytes = 2;
+		} else if(code < 0x10000) {
+			bytes[0] = 0xe0 | (code >> 12);
+			bytes[1] = 0x80 | ((code >> 6) & 0x3f);
+			bytes[2] = 0x80 | (code & 0x3f);
+			numBytes = 3;
+		} else {
+			bytes[0] = 0xf0 | (code >> 18);
+			bytes[1] = 0x80 | ((code >> 12) & 0x3f);
+			bytes[2] = 0x80 | ((code >> 6) & 0x3f);
+			bytes[3] = 0x80 | (code & 0x3f);
+			numBytes = 4;
+		}
+		// truncated at a character boundary
+		if(pos + numBytes >= (int)sizeof(_lastError)) break;
+		memcpy(_lastError + pos, bytes, numBytes);
+		pos += numBytes;
+	}
+	_lastError[pos] = 0;
 }
 void AbstractPlanner::setError(const char *format, ...) {
-	char *outStr = NULL; 
 	va_list args; va_start(args, format);	
-	int ret __attribute__((unused)) = vasprintf(&outStr, format, args);
+	int length = vsnprintf(_lastError, sizeof(_lastError), format, args);
 	va_end(args);
-	setError(QString(outStr));
-	free(outStr);
+	if(length >= (int)sizeof(_lastError)) {
+		// drop a UTF-8 sequence cut off by the truncation
+		int pos = sizeof(_lastError) - 1, start = pos;
+		while(start > 0 && (_lastError[start - 1] & 0xc0) == 0x80) start--;
+		if(start > 0 && (_lastError[start - 1] & 0x80)) {
+			unsigned char lead = _lastError[start - 1];
+			int numBytes = (lead >= 0xf0) ? 4 : (lead >= 0xe0) ? 3 : 2;
+			if(pos - (start - 1) < numBytes) _lastError[start - 1] = 0;
+		}
+	}
 }
 
-void AbstractPlanner::callPlanner() {
-	if(!_mapSize.isEmpty() && _start.isValid() && _goal.isValid()) {	
-		_lastError.clear();
-		_path.clear();
-		QTime time;
-		time.start();				
+void AbstractPlanner::setAllocationFree(bool enabled) {
+	if(enabled == _allocationFree) return;
+	_allocationFree = enabled;
+	_warmedUp = false;
+	if(enabled) reservePath();
+	else setMemoryUsage(Memory_Path, 0);
+}
+
+void AbstractPlanner::reservePath() {
+	// a path visits every cell at most once; large maps get the limit (the byte size of a QVector is an int, too)
+	int64_t numCells = (int64_t)_mapSize.width() * _mapSize.height();
+	_path.reserve((int)qMin(numCells, (int64_t)_pathReserve));
+	setMemoryUsage(Memory_Path, (int64_t)_path.capacity() * sizeof(QPointF));
+}
+
+// returns true if the planner has been called, i.e. map, start and goal are valid
+bool AbstractPlanner::callPlanner(bool resetCounters) {
+	if(_mapSize.isEmpty() || !_start.isValid() || !_goal.isValid()) return false;
+	
+	TRACE_SCOPE_DETAIL("callPlanner", metaObject()->className());
+	if(resetCounters) resetCallStatistics();
+	if(!planningThread) _cancelRequested = false; // reset by the planning thread when it takes the inputs
+	_lastError[0] = 0;
+	_keepInputUpdates = false;
+	_path.resize(0); // keeps the capacity if reserved
+	for(int i = 0; i < NumTimingPhases; i++) _phaseTimeNs[i] = 0;
+	_currentPhase = Phase_Search;
+	int pathCapacity = _path.capacity();
+	int64_t startNs = _phaseStartNs = timestampNs();
+	_budgetLimited = _timeBudgetNs > 0 || _expansionBudget > 0;
+	_budgetExhausted = false;
+	_budgetSteps = 0;
+	_budgetDeadlineNs = startNs + _timeBudgetNs;
+	PerfCounters *perf = hardwareCountersOn ? PerfCounters::forCurrentThread() : NULL;
+	if(perf) perf->start();
+	_callRunning = true;
+	{
+		TRACE_SCOPE_DETAIL("calculatePath", metaObject()->className());
 		calculatePath(accumulatedInputUpdates);
-		_calcTimeMs = time.elapsed();
+	}
+	_callRunning = false;
+	_hardwareCounters = perf ? perf->stop() : PerfCounters::Values();
+	_allocations = AllocationCounters::current() - _allocationsStart;
+	if(_allocationFree) {
+		// a path longer than the reserved buffer grows it, counted without AllocationCounters as well
+		bool pathGrown = _path.capacity() > pathCapacity;
+		if(_warmedUp && (_allocations.allocations || pathGrown)) _allocationViolations++;
+		if(pathGrown) setMemoryUsage(Memory_Path, (int64_t)_path.capacity() * sizeof(QPointF));
+		_warmedUp = true;
+	}
+	int64_t endNs = timestampNs();
+	_phaseTimeNs[_currentPhase] += endNs - _phaseStartNs;
+	_phaseStartNs = 0;
+	_calcTimeNs = endNs - startNs;
+	_callCount++;
+	if(cancelled()) {
+		// the input updates are kept, so the next call continues or repeats the interrupted work
+		_path.resize(0);
+		setError("Planning cancelled");
+	} else if(!_keepInputUpdates) {
+		_lastInputUpdates = accumulatedInputUpdates;
 		accumulatedInputUpdates = NoInputUpdates;
-		
-		if(_path.empty() && _lastError.isEmpty()) _lastError = "No Path set";
-		emit dataChanged();
-	}	
+	}
+	if(_budgetExhausted && !cancelled()) {
+		// the inputs are part of the search state now, continuePlanning() resumes the search
+		_path.resize(0);
+		setError("Planning budget used up");
+	}
+	_planComplete = !cancelled() && !_budgetExhausted;
+	_budgetLimited = false; // single stepping outside of planner calls has no budget
+	// the cancel request ends with the call, so stepping is not interrupted (the planning thread clears it after planInputs())
+	if(!planningThread) _cancelRequested = false;
+	
+	if(_path.empty() && !_lastError[0]) setError("No Path set");
+	return true;
 }
 
 void AbstractPlanner::addDebugLayer(DebugLayer *layer, DebugLayer *before) {
@@ -163,21 +656,138 @@ void AbstractPlanner::addDebugLayer(DebugLayer *layer, int before) {
 	if(before < 0 || before >= _debugLayers.size()) before = _debugLayers.size();
 	_debugLayers.insert(before, layer);
 	layer->_planner = this;
-	emit configChanged(Element_DebugLayer, Change_Add, before);
+	notifyConfigChanged(Element_DebugLayer, Change_Add, before);
 }
 void AbstractPlanner::removeDebugLayer(DebugLayer *layer) {
 	int idx = _debugLayers.indexOf(layer);
 	if(idx >= 0 && idx < _debugLayers.size()) {
-		if(!inDestructor) emit configChanged(Element_DebugLayer, Change_Remove, idx);
+		if(!inDestructor) notifyConfigChanged(Element_DebugLayer, Change_Remove, idx);
 		layer->_planner = NULL;
 		_debugLayers.removeAt(idx);
 	}
 }
 
+void AbstractPlanner::notifyConfigChanged(ConfigElement element, ConfigChange type, int index) {
+	if(!deferConfigChanges) {
+		emit configChanged(element, type, index);
+		return;
+	}
+	ConfigChangeEvent event;
+	event.element = element;
+	event.type = type;
+	event.index = index;
+	deferredConfigChanges.append(event);
+}
+
 void AbstractPlanner::addAction(QAction *action) {
 	_actions.push_back(action);
 }
 
+void AbstractPlanner::addObserver(PlannerObserver *observer) {
+	if(observer && !_observers.contains(observer)) _observers.push_back(observer);
+}
+void AbstractPlanner::removeObserver(PlannerObserver *observer) {
+	int idx = _observers.indexOf(observer);
+	if(idx >= 0) _observers.remove(idx);
+}
+
+void AbstractPlanner::setSearchLayerObserver(PlannerObserver *observer) {
+	if(!searchLayersAction) {
+		searchLayersAction = new QAction(tr("Search layers"), this);
+		searchLayersAction->setCheckable(true);
+		searchLayersAction->setToolTip(tr("Record the debug layers of the search loop (slows down the planner)"));
+		connect(searchLayersAction, SIGNAL(toggled(bool)), this, SLOT(setSearchLayersEnabled(bool)));
+		addAction(searchLayersAction);
+	}
+	if(_searchLayersEnabled) {
+		removeObserver(searchLayerObserver);
+		addObserver(observer);
+	}
+	searchLayerObserver = observer;
+}
+
+void AbstractPlanner::setSearchLayersEnabled(bool enabled) {
+	QMutexLocker locker(&_dataMutex);
+	if(!searchLayersAction || enabled == _searchLayersEnabled) return; // no search layers or unchanged
+	_searchLayersEnabled = enabled;
+	if(enabled) addObserver(searchLayerObserver);
+	else removeObserver(searchLayerObserver);
+	searchLayersAction->setChecked(enabled);
+}
+
+void AbstractPlanner::setHeatMapEnabled(bool enabled) {
+	QMutexLocker locker(&_dataMutex);
+	if(enabled == heatMapEnabled()) return;
+	
+	if(enabled) {
+		addDebugLayer(queryHeatLayer = new DebugLayer(tr("Expansions (last call)")));
+		addDebugLayer(totalHeatLayer = new DebugLayer(tr("Expansions (cumulative)"), 0));
+		resetHeatMap();
+		addObserver(heatMapObserver = new HeatMapObserver(this));
+	} else {
+		removeObserver(heatMapObserver);
+		delete heatMapObserver;
+		heatMapObserver = NULL;
+		delete queryHeatLayer;
+		delete totalHeatLayer;
+		queryHeatLayer = totalHeatLayer = NULL;
+		_heatCounts = QVector<quint32>();
+		_heatQuery = _heatTotal = NULL;
+		heatImages[0] = heatImages[1] = QImage();
+		setMemoryUsage(Memory_HeatMap, 0);
+	}
+	heatMapAction->setChecked(enabled);
+}
+
+void AbstractPlanner::resetHeatMap() {
+	int numCells = _mapSize.width() * _mapSize.height();
+	_heatCounts.fill(0, 2 * numCells);
+	_heatQuery = _heatCounts.data();
+	_heatTotal = _heatQuery + numCells;
+	heatImagesValid = false;
+	setMemoryUsage(Memory_HeatMap, _heatCounts.size() * sizeof(quint32) + heatImages[0].byteCount() + heatImages[1].byteCount());
+}
+void AbstractPlanner::clearQueryHeat() {
+	if(!_heatQuery) return;
+	memset(_heatQuery, 0, _mapSize.width() * _mapSize.height() * sizeof(quint32));
+	heatImagesValid = false;
+}
+
+// logarithmic color scale from blue (single expansion) to red (maximum count)
+void AbstractPlanner::drawHeatMap(QPainter &painter, const DebugLayer *layer) {
+	if(!_heatQuery || _mapSize.isEmpty()) return;
+	
+	if(!heatImagesValid) {
+		QVector<QRgb> colors;
+		colors << qRgba(0, 0, 0, 0);
+		for(int i = 1; i < 256; i++) colors << QColor::fromHsvF(0.667 * (255 - i) / 254.0, 1.0, 1.0, 0.75).rgba();
+		
+		int w = _mapSize.width();
+		for(int n = 0; n < 2; n++) {
+			const quint32 *counts = n ? _heatTotal : _heatQuery;
+			quint32 maxCount = 0;
+			for(int i = 0; i < w * _mapSize.height(); i++) maxCount = qMax(maxCount, counts[i]);
+			
+			QImage &img = heatImages[n];
+			if(img.size() != _mapSize) {
+				img = QImage(_mapSize, QImage::Format_Indexed8);
+				img.setColorTable(colors);
+			}
+			qreal scale = maxCount > 1 ? 254.0 / log((qreal)maxCount) : 0.0;
+			for(int y = 0; y < _mapSize.height(); y++) {
+				uchar *pLine = img.scanLine(y);
+				for(int x = 0; x < w; x++) {
+					quint32 count = *counts++;
+					*pLine++ = count ? 1 + (uchar)(log((qreal)count) * scale) : 0;
+				}
+			}
+		}
+		heatImagesValid = true;
+		setMemoryUsage(Memory_HeatMap, _heatCounts.size() * sizeof(quint32) + heatImages[0].byteCount() + heatImages[1].byteCount());
+	}
+	painter.drawImage(QPointF(-0.5, -0.5), heatImages[layer == totalHeatLayer ? 1 : 0]);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class DebugLayer
 ////////////////////////////////////////////////////////////////////////////////
@@ -194,7 +804,9 @@ AbstractPlanner::DebugLayer::~DebugLayer() {
 	}
 }
 void AbstractPlanner::DebugLayer::draw(QPainter &p, const QRect &visibleArea, qreal zoomFactor) {
-	if(_planner) _planner->drawDebugLayer(p, this, visibleArea, zoomFactor);
+	if(!_planner) return;
+	if(this == _planner->queryHeatLayer || this == _planner->totalHeatLayer) _planner->drawHeatMap(p, this);
+	else _planner->drawDebugLayer(p, this, visibleArea, zoomFactor);
 }
 
 void AbstractPlanner::DebugLayer::setMinimumZoomFactor(qreal factor) {	
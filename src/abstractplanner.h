@@ -21,13 +21,30 @@
 
 #include <QObject>
 #include "data.h"
+#include "perfcounters.h"
+#include "allocationcounters.h"
+#include "plannerobserver.h"
 #include <QList>
+#include <QVector>
 #include <QSize>
 #include <QRect>
+#include <QMutex>
+#include <atomic>
 class QAction;
 #include <QImage>
 class QPainter;
 
+/* search effort counters are only maintained if PLANNER_COUNTERS is defined (debug builds or CONFIG += counters),
+ * otherwise PLANNER_COUNT() compiles to nothing and the counters stay 0
+ */
+#ifdef PLANNER_COUNTERS
+#define PLANNER_COUNT(counter) (_counters.counter++)
+#define PLANNER_COUNT_ADD(counter, n) (_counters.counter += (n))
+#else
+#define PLANNER_COUNT(counter) ((void)0)
+#define PLANNER_COUNT_ADD(counter, n) ((void)0)
+#endif
+
 class AbstractPlanner: public QObject {
 	Q_OBJECT
 public:	
@@ -84,12 +101,148 @@ public:
 	
 	void setMap(const QImage &mapData);
 	void updateMap(const QImage &mapData, const QRect &updateRegion);
+	
+	/* background planning: the input setters above only queue the inputs and return, a planning thread applies
+	 * them and calls the planner. Inputs arriving during a call are merged into the next one (the latest start,
+	 * goal and map with the union of the updated regions). Complete calls are published with dataChanged() in
+	 * the planner's thread while the planning thread waits, so slots connected to dataChanged() read a consistent
+	 * state; other readers of the planner's data (painting debug layers, cellDetails(), statistics on a timer)
+	 * must hold dataMutex() and should only try to lock it. Slots of planner actions lock it, too; the stepping
+	 * actions only try to lock it and do nothing while a call is running, so they do not block the GUI.
+	 * Disabling cancels the running call and drops pending inputs; it has to be disabled before the planner is deleted.
+	 */
+	void setBackgroundPlanning(bool enabled);
+	bool backgroundPlanning() const { return planningThread != NULL; }
+	bool isPlanning() const; // inputs are queued or being planned
+	QMutex *dataMutex() const { return &_dataMutex; }
+	
+	/* aborts the running planner call (from any thread): it ends without path and the error "Planning cancelled",
+	 * its input updates are handled by the next call; cancelled calls are not published in background mode.
+	 * Does nothing if no call is running.
+	 */
+	void cancel();
+	
+	/* anytime planning: with a budget, planner calls return when the time (checked every 64 expansions) or the
+	 * number of expanded cells is used up, without path and with planComplete() false. The search state is kept
+	 * for continuePlanning(), which resumes the search with a new budget; inputs set in between are handled by
+	 * the resumed call like by any other call (a new goal or map restarts the search). 0 means no limit (default).
+	 * The budget covers the search only, calls re-initializing the planner state take a pass over the map on top.
+	 */
+	void setBudget(int64_t timeNs, uint64_t expansions = 0);
+	int64_t timeBudgetNs() const { return _timeBudgetNs; }
+	uint64_t expansionBudget() const { return _expansionBudget; }
+	bool planComplete() const { return _planComplete; } // false if the last call was interrupted (budget, cancel())
 
 	
 	const Path &path() const { return _path; }
 		
-	int64_t calcTimeMs() const { return _calcTimeMs; }
-	const QString &lastError() const { return _lastError; }
+	int64_t calcTimeMs() const { return _calcTimeNs < 0 ? -1 : _calcTimeNs / 1000000; }
+	int64_t calcTimeNs() const { return _calcTimeNs; }
+	unsigned callCount() const { return _callCount; } // number of calculatePath() calls so far
+	
+	/* breakdown of the last planner call's calculation time; planners switch phases by calling beginPhase(),
+	 * time not attributed to another phase is accounted to Phase_Search
+	 */
+	enum TimingPhase {
+		Phase_Reset,			// (re-)initialization of the planner state
+		Phase_Search,
+		Phase_PathExtraction,
+		Phase_DebugLayers,		// preparation of debug layer data
+		NumTimingPhases
+	};
+	int64_t phaseTimeNs(TimingPhase phase) const { return _phaseTimeNs[phase]; }
+	static QString phaseName(TimingPhase phase);
+	
+	
+	// search effort of the last planner call (including the map update for updateMap())
+	struct Counters {
+		Counters() { clear(); }
+		void clear();
+		Counters &operator+=(const Counters &other);
+		uint64_t expansions;		// cells taken from the open list
+		uint64_t heapInserts;		// cells added to the open list
+		uint64_t decreaseKeys;		// key updates of cells already on the open list
+		uint64_t heapUpSwaps;		// swaps while moving heap elements towards the root
+		uint64_t heapDownSwaps;		// swaps while moving heap elements towards the leaves
+		uint64_t cellsTouched;		// neighbor cells examined during expansions
+		uint64_t processStateCalls;	// D*, Focussed D*
+		uint64_t updateVertexCalls;	// D* Lite
+	};
+	const Counters &counters() const { return _counters; }
+	static bool countersEnabled();
+	
+	/* hardware performance counters of the last calculatePath() call, invalid if they are
+	 * disabled (default) or not supported (see PerfCounters)
+	 */
+	const PerfCounters::Values &hardwareCounters() const { return _hardwareCounters; }
+	static void setHardwareCountersEnabled(bool enabled);
+	static bool hardwareCountersEnabled();
+	/* kept as UTF-8 in a fixed buffer, so setting an error does not allocate during calculatePath(); the
+	 * returned string is updated from the buffer
+	 */
+	const QString &lastError() const;
+	
+	/* heap allocations of the last planner call (including the map update for updateMap()),
+	 * only counted if AllocationCounters::available()
+	 */
+	const AllocationCounters::Values &allocations() const { return _allocations; }
+	
+	/* allocation-free steady state: the path buffer is reserved when a map is set, for the longest possible path
+	 * (every cell once) up to pathReserve() points, so after the first call on a map (warm-up, creates the debug
+	 * images and tables) planner calls for new start/goal poses or map updates of the same size do not allocate.
+	 * The caller must not keep copies of path() across calls, modifying the shared path would allocate. Calls
+	 * that allocate nevertheless are counted as violations (only with AllocationCounters), as are calls whose
+	 * path outgrows the reserved buffer (always).
+	 */
+	void setAllocationFree(bool enabled);
+	bool allocationFree() const { return _allocationFree; }
+	// limit of the path buffer reserved in allocation-free mode in points (default 1M, 16 MiB), applies to the next map
+	void setPathReserve(int points) { _pathReserve = qMax(points, 0); }
+	int pathReserve() const { return _pathReserve; }
+	unsigned allocationViolations() const { return _allocationViolations; }
+	
+	/* memory footprint of the planner's data structures in bytes as reported by the planners (see setMemoryUsage()),
+	 * peak values are kept for the lifetime of the planner
+	 */
+	enum MemoryComponent {
+		Memory_Cells,			// per-cell search state
+		Memory_OpenList,		// open list arrays
+		Memory_DebugImages,		// images of the debug layers
+		Memory_Tables,			// lookup tables, e.g. D* Lite neighborhoods
+		Memory_HeatMap,
+		Memory_Path,			// path buffer reserved in allocation-free mode
+		Memory_StepHistory,		// recorded single steps (D*, D* Lite)
+		Memory_CostField,		// parallel cost field seeding the D* planners
+		NumMemoryComponents
+	};
+	int64_t memoryUsage(MemoryComponent component) const { return _memoryUsage[component]; }
+	int64_t peakMemoryUsage(MemoryComponent component) const { return _peakMemoryUsage[component]; }
+	int64_t memoryUsage() const; // all components
+	int64_t peakMemoryUsage() const { return _peakTotalMemoryUsage; }
+	static QString memoryComponentName(MemoryComponent component);
+	
+	/* expansion heat map: counts how often each cell was expanded, for the last planner call and cumulatively
+	 * since the heat map was enabled or a new map was set; both are shown as debug layers while enabled
+	 * (costs 8 bytes per cell, disabled by default)
+	 */
+	bool heatMapEnabled() const { return queryHeatLayer != NULL; }
+	
+	/* observers receive the search events of the planner (see PlannerObserver) until they are removed,
+	 * the planner does not take ownership
+	 */
+	void addObserver(PlannerObserver *observer);
+	void removeObserver(PlannerObserver *observer);
+	
+	/* debug layers recorded from the search events (A*'s visited cells, D* Lite's touched cells) are only
+	 * filled while enabled, as they attach an observer; disabled by default, the GUI enables them
+	 */
+	bool searchLayersEnabled() const { return _searchLayersEnabled; }
+	
+	/* planners with single stepping record the steps to scrub backward and forward through the search,
+	 * the oldest steps are dropped if the recorded steps exceed the budget (default 64 MiB)
+	 */
+	void setStepHistoryBudget(int64_t bytes) { _stepHistoryBudget = bytes; }
+	int64_t stepHistoryBudget() const { return _stepHistoryBudget; }
 	
 	QSize mapSize() const { return _mapSize; }
 	int mapWidth() const { return _mapSize.width(); }
@@ -105,10 +258,28 @@ public:
 		
 	Q_DECLARE_FLAGS(InputUpdates, InputUpdate)
 	
+	/* input updates handled by the last planner call; planners with incremental replanning (D*, FD*, D* Lite)
+	 * re-initialize their state if isFullReplan(), i.e. for a new goal or map
+	 */
+	InputUpdates lastInputUpdates() const { return _lastInputUpdates; }
+	static bool isFullReplan(InputUpdates updates) { return updates & ~(UpdatedStart | UpdatedMap); }
+	
 	QList<QAction *> actions() { return _actions; }
 	
 	virtual QString cellDetails(const QPoint &/*pos*/) { return QString(); }	
 	
+	// true if the planner always finds a path of minimum cost (used by the benchmark tool's --check)
+	virtual bool isOptimal() const { return true; }
+	
+public slots:
+	void setHeatMapEnabled(bool enabled);
+	void setSearchLayersEnabled(bool enabled);
+	// resumes the search of an incomplete plan (see setBudget()), does nothing if planComplete()
+	void continuePlanning();
+	
+private slots:
+	void publishResult();
+	
 signals:
 	void dataChanged();
 	void configChanged(AbstractPlanner::ConfigElement element, AbstractPlanner::ConfigChange type, int index);
@@ -128,6 +299,12 @@ protected:
 	virtual void calculatePath(InputUpdates updates) = 0;
 	
 	void setPath(const Path &path);
+	/* the path of the current call, empty when calculatePath() is called; filling it in place instead
+	 * of calling setPath() reuses its capacity between calls
+	 */
+	Path &pathBuffer() { return _path; }
+	void beginPhase(TimingPhase phase);
+	void setMemoryUsage(MemoryComponent component, int64_t bytes);
 	void setError(const QString &str);
 	void setError(const char *format, ...) __attribute__(( format(printf, 2, 3) ));
 
@@ -139,21 +316,111 @@ protected:
 
 
 	virtual void drawDebugLayer(QPainter &, const DebugLayer *, const QRect &, qreal /*zoomFactor*/) { }
+	
+	/* search loops are templates on "bool Observed" and report events with "if(Observed) notifyExpanded(x, y);",
+	 * the caller selects the instantiation with observed()
+	 */
+	bool observed() const { return !_observers.isEmpty(); }
+	void notifyExpanded(int x, int y) { for(int i = 0; i < _observers.size(); i++) _observers[i]->expanded(x, y); }
+	void notifyOpened(int x, int y) { for(int i = 0; i < _observers.size(); i++) _observers[i]->opened(x, y); }
+	void notifyClosed(int x, int y) { for(int i = 0; i < _observers.size(); i++) _observers[i]->closed(x, y); }
+	void notifyKeyUpdated(int x, int y) { for(int i = 0; i < _observers.size(); i++) _observers[i]->keyUpdated(x, y); }
+	
+	// observer that records the planner's search debug layers, attached while searchLayersEnabled()
+	void setSearchLayerObserver(PlannerObserver *observer);
+	
+	// set by cancel() until the cancelled call has finished
+	bool cancelled() const { return _cancelRequested.load(std::memory_order_relaxed); }
+	// search loops check this before each expansion and return early if true (cancel() or budget used up)
+	bool interrupted() { return cancelled() || (_budgetLimited && budgetUsedUp()); }
+	/* the running call has been interrupted by the budget: planners skip preparing debug layers that cost a pass
+	 * over the map, so calls stay within the budget; the call completing the plan updates them
+	 */
+	bool budgetExhausted() const { return _budgetExhausted; }
+	// called by calculatePath() if it returns before using the inputs (e.g. blocked start), so the next call gets them again
+	void keepInputUpdates() { _keepInputUpdates = true; }
+	
+	Counters _counters; // use PLANNER_COUNT() to modify
+	PerfCounters::Values _hardwareCounters;
 
 private:	
 	Path _path;
 	Pose2D _start, _goal;
 	QSize _mapSize;
-	QString _lastError;	
+	char _lastError[128]; // UTF-8
+	mutable QString _lastErrorString; // converted by lastError()
 	
 	void updatePath();
-	int64_t _calcTimeMs;
+	int64_t _calcTimeNs;
+	unsigned _callCount;
+	AllocationCounters::Values _allocations, _allocationsStart;
+	bool _allocationFree, _warmedUp;
+	int _pathReserve;
+	unsigned _allocationViolations;
+	int64_t _phaseTimeNs[NumTimingPhases];
+	int64_t _phaseStartNs;
+	TimingPhase _currentPhase;
+	
+	int64_t _memoryUsage[NumMemoryComponents];
+	int64_t _peakMemoryUsage[NumMemoryComponents];
+	int64_t _peakTotalMemoryUsage;
+	int64_t _stepHistoryBudget;
 	
 	DebugLayers _debugLayers;
 	bool inDestructor;
 	
-	InputUpdates accumulatedInputUpdates;
-	void callPlanner();
+	QVector<PlannerObserver *> _observers;
+	PlannerObserver *searchLayerObserver;
+	QAction *searchLayersAction;
+	bool _searchLayersEnabled;
+	
+	class HeatMapObserver;
+	HeatMapObserver *heatMapObserver;
+	QAction *heatMapAction;
+	DebugLayer *queryHeatLayer, *totalHeatLayer;
+	QVector<quint32> _heatCounts; // counts of the last call followed by the cumulative counts
+	quint32 *_heatQuery, *_heatTotal; // NULL while the heat map is disabled
+	QImage heatImages[2];
+	bool heatImagesValid;
+	void resetHeatMap();
+	void reservePath();
+	void clearQueryHeat();
+	void drawHeatMap(QPainter &painter, const DebugLayer *layer);
+	
+	InputUpdates accumulatedInputUpdates, _lastInputUpdates;
+	bool _keepInputUpdates;
+	bool applyStart(const Pose2D &start);
+	bool applyGoal(const Pose2D &goal);
+	bool applyMap(const QImage &mapData);
+	bool applyMapUpdate(const QImage &mapData, const QRect &updateRegion);
+	void resetCallStatistics();
+	bool callPlanner(bool resetCounters = true);
+	
+	class PlanningThread;
+	struct PendingInputs;
+	PlanningThread *planningThread; // NULL unless background planning
+	mutable QMutex _dataMutex;
+	std::atomic<bool> _cancelRequested;
+	std::atomic<bool> _callRunning; // callPlanner() is running (in foreground mode, cancel() is ignored otherwise)
+	bool planInputs(const PendingInputs &inputs);
+	
+	int64_t _timeBudgetNs;
+	uint64_t _expansionBudget;
+	bool _budgetLimited; // during calls with a budget only
+	bool _budgetExhausted, _planComplete;
+	int64_t _budgetDeadlineNs;
+	uint64_t _budgetSteps; // interrupted() checks of the current call
+	bool budgetUsedUp();
+	
+	// configuration changes of the planning thread, emitted by publishResult()
+	struct ConfigChangeEvent {
+		ConfigElement element;
+		ConfigChange type;
+		int index;
+	};
+	bool deferConfigChanges;
+	QList<ConfigChangeEvent> deferredConfigChanges;
+	void notifyConfigChanged(ConfigElement element, ConfigChange type, int index);
 	
 	QList<QAction *> _actions;
 };
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "allocationcounters.h"
+
+#if defined(ALLOCATION_COUNTERS) && defined(__GLIBC__)
+#include <cerrno>
+#include <cstddef>
+
+extern "C" {
+	void *__libc_malloc(size_t size);
+	void *__libc_calloc(size_t count, size_t size);
+	void *__libc_realloc(void *ptr, size_t size);
+	void *__libc_memalign(size_t alignment, size_t size);
+	void __libc_free(void *ptr);
+}
+
+// initial-exec TLS is accessed without calling into the allocator, even in newly created threads
+static __thread uint64_t allocationCount __attribute__((tls_model("initial-exec"))) = 0;
+static __thread uint64_t freeCount __attribute__((tls_model("initial-exec"))) = 0;
+static __thread uint64_t allocatedBytes __attribute__((tls_model("initial-exec"))) = 0;
+
+static inline void countAllocation(size_t size) {
+	allocationCount++;
+	allocatedBytes += size;
+}
+
+extern "C" {
+
+void *malloc(size_t size) {
+	countAllocation(size);
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+	countAllocation(count * size);
+	return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+	countAllocation(size);
+	return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+	countAllocation(size);
+	return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+	countAllocation(size);
+	return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+	if(alignment < sizeof(void *) || (alignment & (alignment - 1))) return EINVAL;
+	countAllocation(size);
+	*ptr = __libc_memalign(alignment, size);
+	return *ptr ? 0 : ENOMEM;
+}
+
+void free(void *ptr) {
+	if(ptr) freeCount++;
+	__libc_free(ptr);
+}
+
+}
+
+bool AllocationCounters::available() {
+	return true;
+}
+
+AllocationCounters::Values AllocationCounters::current() {
+	Values values;
+	values.allocations = allocationCount;
+	values.frees = freeCount;
+	values.bytes = allocatedBytes;
+	return values;
+}
+
+#else
+
+bool AllocationCounters::available() {
+	return false;
+}
+
+AllocationCounters::Values AllocationCounters::current() {
+	return Values();
+}
+
+#endif
+
+AllocationCounters::Values AllocationCounters::Values::operator-(const Values &other) const {
+	Values values;
+	values.allocations = allocations - other.allocations;
+	values.frees = frees - other.frees;
+	values.bytes = bytes - other.bytes;
+	return values;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ALLOCATIONCOUNTERS_H
+#define ALLOCATIONCOUNTERS_H
+
+#include <stdint.h>
+
+/* Heap allocations of the calling thread. With ALLOCATION_COUNTERS defined (CONFIG += alloccounters)
+ * and glibc, malloc(), calloc(), realloc(), the aligned variants and free() are replaced by counting
+ * wrappers around the C library's allocator; operator new, QVector, QString and QImage all end up there.
+ * Otherwise nothing is counted and available() is false.
+ */
+class AllocationCounters {
+public:
+	struct Values {
+		Values(): allocations(0), frees(0), bytes(0) { }
+		Values operator-(const Values &other) const;
+		uint64_t allocations;	// malloc(), calloc(), realloc() and aligned allocations
+		uint64_t frees;			// free() of non-NULL pointers
+		uint64_t bytes;			// requested bytes of all allocations
+	};
+	
+	static bool available();
+	// totals of the calling thread since it was started
+	static Values current();
+};
+
+#endif // ALLOCATIONCOUNTERS_H
@@ -19,51 +19,109 @@
 #include "astarplanner.h"
 #include <cstdio>
 #include <new>
+#include <atomic>
 #include <QPainter>
+#include <QSemaphore>
+#include <QThread>
+
+const int AStarPlanner::neighbourhood_dx[8] = { -1,  0,  1, -1, -1, 1, 1, 0 };
+const int AStarPlanner::neighbourhood_dy[8] = { -1, -1, -1,  0,  1, 0, 1, 1 };
 
 AStarPlanner::AStarPlanner(QObject *parent):
 	AbstractPlanner(parent),
-	rasterElements(NULL),
-	openList(NULL),
-	visitedLayer(NULL)
+	visitedLayer(NULL),
+	visitedObserver(visitedMap, DebugImageObserver::Opened, 1)
 {
-
+	setSearchLayerObserver(&visitedObserver);
 }
 
 AStarPlanner::~AStarPlanner() {
-	freeMemory();
+	qDeleteAll(batchContexts);
 }
+
+bool AStarPlanner::SearchContext::allocate(const QSize &size) {
+	freeMemory();
+	rasterElements = new (std::nothrow) RasterElement[size.width() * size.height()];
+	openList = new (std::nothrow) RasterElement *[size.width() * size.height() + 1];
+	if(!rasterElements || !openList) {
+		freeMemory();
+		return false;
+	}
+	allocatedSize = size;
 	
-void AStarPlanner::freeMemory() {
-	// free path planner memory 
+	RasterElement *pRE = rasterElements;
+	for(int y = 0; y < size.height(); y++) {
+		for(int x = 0; x < size.width(); x++) {
+			pRE->x = x;
+			pRE->y = y;
+			pRE->list = List_None;
+			pRE++;
+		}
+	}
+	return true;
+}
+
+void AStarPlanner::SearchContext::freeMemory() {
 	if(rasterElements) delete[] rasterElements;
 	if(openList) delete[] openList;
+	rasterElements = NULL;
+	openList = NULL;
+	openListLength = 0;
+	allocatedSize = QSize();
+	suspended = false;
 }
 
-void AStarPlanner::initMap(const QImage &map, const QRect &) {
-	freeMemory(); // free old memory
-	
-	// allocate A* memory according to the image's dimensions
-	rasterElements = new (std::nothrow) RasterElement[map.width() * map.height()];
-	openList = new (std::nothrow) RasterElement *[map.width() * map.height() + 1];
-		
-	if(!rasterElements || !openList){
-		printf("Could not allocate path planner memory\n");
-		return;
+// clears the open/closed lists and takes the blocked cells from occupancy
+void AStarPlanner::SearchContext::reset(const QByteArray &occupancy, const RasterElement *pGoal) {
+	RasterElement *pRE = rasterElements;
+	const char *pBlocked = occupancy.constData();
+	int numCells = allocatedSize.width() * allocatedSize.height();
+	for(int i = 0; i < numCells; i++){
+		if(*pBlocked++) pRE->list = List_Unwalkable;
+		else {
+			pRE->list = List_None;
+#ifdef HIGHQUALITYPATHPLANNER			
+			int diffX = pGoal->x - pRE->x;
+			int diffY = pGoal->y - pRE->y;
+			pRE->h_cost = 10 * (int)sqrt(diffX * diffX + diffY * diffY);
+#endif
+		}
+		pRE++;
 	}
+	Q_UNUSED(pGoal);
+}
+
+void AStarPlanner::initMap(const QImage &map, const QRect &updateRegion) {
+	QMutexLocker locker(&batchMutex);
+	// map updates of the same size reuse the memory
+	if(map.size() != context.allocatedSize) {
+		// idle batch contexts are of the old size, contexts of running batches are dropped when they are returned
+		qDeleteAll(batchContexts);
+		batchContexts.clear();
 		
-	RasterElement *pRE = rasterElements;	
-	unsigned width = map.width();
-	unsigned height = map.height();
-	for(unsigned y = 0; y < height; y++) {
-		const unsigned char *pCost = (const unsigned char *)map.scanLine(y);
-		for(unsigned x = 0; x < width; x++) {
-			pRE->x = x;
-			pRE->y = y;
-			pRE->list = (*pCost++ > 0) ? List_Unwalkable : List_None;
-			pRE++;			
+		// allocate A* memory according to the image's dimensions
+		if(!context.allocate(map.size())) {
+			printf("Could not allocate path planner memory\n");
+			occupancy.clear();
+			occupancySize = QSize();
+			setMemoryUsage(Memory_Cells, 0);
+			setMemoryUsage(Memory_OpenList, 0);
+			return;
 		}
 	}
+	setMemoryUsage(Memory_Cells, (int64_t)map.width() * map.height() * (sizeof(RasterElement) + 1));
+	setMemoryUsage(Memory_OpenList, ((int64_t)map.width() * map.height() + 1) * sizeof(RasterElement *));
+	
+	// a running batch keeps its copy of the occupancy, writing detaches
+	QRect rc = (updateRegion.isNull() || map.size() != occupancySize) ? map.rect() : updateRegion.intersected(map.rect());
+	occupancy.resize(map.width() * map.height());
+	occupancySize = map.size();
+	char *pBlocked = occupancy.data();
+	for(int y = rc.top(); y <= rc.bottom(); y++) {
+		const unsigned char *pCost = (const unsigned char *)map.scanLine(y) + rc.left();
+		char *pRow = pBlocked + y * map.width() + rc.left();
+		for(int x = 0; x < rc.width(); x++) *pRow++ = (*pCost++ > 0);
+	}
 }
 
 void AStarPlanner::drawDebugLayer(QPainter &painter, const DebugLayer *layer, const QRect &, qreal) {
@@ -72,60 +130,103 @@ void AStarPlanner::drawDebugLayer(QPainter &painter, const DebugLayer *layer, co
 	}
 }
 
-void AStarPlanner::calculatePath(InputUpdates) {	
-	if(!openList || !rasterElements) {
-		setError("Planner memory allocation error");
-		return;
-	}
+// Open List = Binary Heap: add the item at the bottom and move it to its proper place
+void AStarPlanner::SearchContext::openListInsert(RasterElement *pRE) {
+	PLANNER_COUNT(heapInserts);
+	int m = ++openListLength;
+	openList[m] = pRE;
+	pRE->openListIndex = m;
 	
-	// some preparations...
-	int width = mapWidth();
-	int height = mapHeight();
-	if(visitedMap.size() != mapSize()) {
-		visitedMap = QImage(mapSize(), QImage::Format_Indexed8);
-		visitedMap.setColorTable(QVector<QRgb>() << qRgba(0, 0, 0, 0) << qRgba(0, 255, 255, 128));
+	// Starting at the bottom, successively compare to parent items,
+	// swapping as needed until the item finds its place in the heap
+	// or bubbles all the way to the top (if it has the lowest F cost).
+	while(m != 1){ // While item hasn't bubbled to the top (m=1)	
+		// Check if child's F cost is < parent's F cost. If so, swap them.	
+		int m_half = m >> 1;
+		if (openList[m]->f_cost <= openList[m_half]->f_cost){
+			PLANNER_COUNT(heapUpSwaps);
+			RasterElement *temp = openList[m_half];
+			openList[m_half] = openList[m];
+			openList[m_half]->openListIndex = m_half;
+			openList[m] = temp;
+			openList[m]->openListIndex = m;
+			m = m_half;
+		} else break;
 	}
-	visitedMap.fill(0);
-#define ADD_TO_VISITED_MAP(re)	visitedMap.setPixel((re)->x, (re)->y, 1);
-		
-	QPoint goalPos = this->goalPos().toPoint();
-	QPoint startPos = this->startPos().toPoint();
-	RasterElement *pStart = rasterElements + startPos.y() * width + startPos.x();
-	RasterElement *pGoal = rasterElements + goalPos.y() * width + goalPos.x();
+}
+
+// Open List = Binary Heap: Delete the top item in binary heap and reorder the heap, with the lowest F cost item rising to the top.
+AStarPlanner::RasterElement *AStarPlanner::SearchContext::openListPop() {
+	RasterElement *pMin = openList[1];
+	if(--openListLength){
+		openList[1] = openList[openListLength + 1];//move the last item in the heap up to slot #1
+		int v = 1;
+
+		//	Repeat the following until the new item in slot #1 sinks to its proper spot in the heap.
+		while(1){
+			int u = v;	
+			if (((u << 1) + 1) <= openListLength){ //if both children exist
+				// Check if the F cost of the parent is greater than each child.
+				// Select the lowest of the two children.
+				if(openList[v]->f_cost >= openList[u << 1]->f_cost) v = u << 1;
+				if(openList[v]->f_cost >= openList[(u << 1) + 1]->f_cost) v = (u << 1) + 1;								
+			}else{
+				if((u << 1) <= openListLength){ //if only child #1 exists
+					// Check if the F cost of the parent is greater than child #1	
+					if(openList[u]->f_cost >= openList[u << 1]->f_cost) v = (u << 1);
+				}
+			}
 		
-	// check validity of start & goal
-	if(pGoal->list == List_Unwalkable) {
-		setError("Goal position blocked");
-		return;
-	}	
-	if(pStart->list == List_Unwalkable) {
-		setError("Start position blocked");
-		return;
+			if (u != v){ // if parent's F is > one of its children, swap them
+				PLANNER_COUNT(heapDownSwaps);
+				RasterElement *temp = openList[u];
+				openList[u] = openList[v];
+				openList[u]->openListIndex = u;
+				openList[v] = temp;			
+				openList[v]->openListIndex = v;
+			} else break; //otherwise, exit loop
+		}
 	}
+	return pMin;
+}
 
-	// A* initialization
+// Open List = Binary Heap: see if changing the F score bubbles the item up from it's current location in the heap
+void AStarPlanner::SearchContext::openListDecreaseKey(RasterElement *pRE) {
+	PLANNER_COUNT(decreaseKeys);
+	int m = pRE->openListIndex;
+	while(m != 1){ //While item hasn't bubbled to the top (m=1)	
+		// Check if child is < parent. If so, swap them.	
+		int m_half = m >> 1;
+		if(openList[m]->f_cost < openList[m_half]->f_cost){
+			PLANNER_COUNT(heapUpSwaps);
+			RasterElement *temp = openList[m_half];
+			openList[m_half] = openList[m];
+			openList[m_half]->openListIndex = m_half;
+			openList[m] = temp;
+			openList[m]->openListIndex = m;
+			m = m_half;
+		} else break;
+	} 
+}
+
+/* expands cells from pStart until pGoal is closed, returns false if there is no path or the search has been
+ * interrupted (suspended is set then and the open list kept, so it can be resumed)
+ */
+template<bool Observed> bool AStarPlanner::SearchContext::search(AStarPlanner *planner, RasterElement *pStart, RasterElement *pGoal, bool resume) {
+	int width = allocatedSize.width();
+	int height = allocatedSize.height();
 	RasterElement *pEnd = rasterElements + width * height - 1;
-	RasterElement *pRE = rasterElements;	
-	// clear open/closed lists
-	for(int i = 0; i < width * height; i++){
-		if(pRE->list != List_Unwalkable){
-			pRE->list = List_None;
-#ifdef HIGHQUALITYPATHPLANNER			
-			int diffX = pTarget->x - pRE->x;
-			int diffY = pTarget->y - pRE->y;
-			pRE->h_cost = 10 * (int)sqrt(diffX * diffX + diffY * diffY);
-#endif
-		}
-		pRE++;
+	RasterElement *pRE = pStart;
+	_counters.clear();
+	suspended = false;
+	if(!resume) {
+		pRE->g_cost = 0;
+		// Add the starting location to the open list of squares to be checked.
+		openListLength = 0;
+		openListInsert(pRE);
+		if(Observed) planner->notifyOpened(pRE->x, pRE->y);
 	}
 
-	pRE = pStart;
-	pRE->g_cost = 0;
-	// Add the starting location to the open list of squares to be checked.
-	int numberOfOpenListItems = 1;
-	openList[1] = pRE;
-	ADD_TO_VISITED_MAP(pRE)
-
 	int neighbourhood_offsets[8];
 	// arrange neighbourhood pixels in a way that diagonal pixels have an even index (this will simplifies a condition used later)
 	neighbourhood_offsets[0] = -width - 1;
@@ -136,49 +237,23 @@ void AStarPlanner::calculatePath(InputUpdates) {
 	neighbourhood_offsets[5] = +1;
 	neighbourhood_offsets[6] = +width + 1;
 	neighbourhood_offsets[7] = +width;
-	int neighbourhood_dx[8] = { -1,  0,  1, -1, -1, 1, 1, 0 };
-	int neighbourhood_dy[8] = { -1, -1, -1,  0,  1, 0, 1, 1 };
 
-	Path path;
-	
 	// Do the following until a path is found or deemed nonexistent.
 	while(true) {
+		if(planner && planner->interrupted()) {
+			suspended = true;
+			return false;
+		}
 		// If the open list is not empty, take the first cell off of the list.
 		// This is the lowest F cost cell on the open list.
-		if(numberOfOpenListItems != 0) {
+		if(openListLength != 0) {
 			// Pop the first item off the open list.
-			pRE = openList[1];
+			pRE = openListPop();
 			pRE->list = List_Closed;
-
-			//	Open List = Binary Heap: Delete this item from the open list
-			//	Delete the top item in binary heap and reorder the heap, with the lowest F cost item rising to the top.
-			if(--numberOfOpenListItems){
-				openList[1] = openList[numberOfOpenListItems + 1];//move the last item in the heap up to slot #1
-				int v = 1;
-	
-				//	Repeat the following until the new item in slot #1 sinks to its proper spot in the heap.
-				while(1){
-					int u = v;	
-					if (((u << 1) + 1) <= numberOfOpenListItems){ //if both children exist
-					 	// Check if the F cost of the parent is greater than each child.
-						// Select the lowest of the two children.
-						if(openList[v]->f_cost >= openList[u << 1]->f_cost) v = u << 1;
-						if(openList[v]->f_cost >= openList[(u << 1) + 1]->f_cost) v = (u << 1) + 1;								
-					}else{
-						if((u << 1) <= numberOfOpenListItems){ //if only child #1 exists
-					 		// Check if the F cost of the parent is greater than child #1	
-							if(openList[u]->f_cost >= openList[u << 1]->f_cost) v = (u << 1);
-						}
-					}
-				
-					if (u != v){ // if parent's F is > one of its children, swap them
-						RasterElement *temp = openList[u];
-						openList[u] = openList[v];
-						openList[u]->openListIndex = u;
-						openList[v] = temp;			
-						openList[v]->openListIndex = v;
-					} else break; //otherwise, exit loop
-				}
+			PLANNER_COUNT(expansions);
+			if(Observed) {
+				planner->notifyExpanded(pRE->x, pRE->y);
+				planner->notifyClosed(pRE->x, pRE->y);
 			}
 		
 			// Check the adjacent cells. (Its "children" -- these path children
@@ -193,6 +268,7 @@ void AStarPlanner::calculatePath(InputUpdates) {
 				int x = pRE->x + neighbourhood_dx[neighbourhood_index];
 				int y = pRE->y + neighbourhood_dy[neighbourhood_index];
 				if((unsigned)x >= (unsigned)width || (unsigned)y >= (unsigned)height) continue;
+				PLANNER_COUNT(cellsTouched);
 				
 				//	If not off the map (do this first to avoid array out-of-bounds errors)
 				RasterElement *pNeighbour = pRE + neighbourhood_offsets[neighbourhood_index];
@@ -204,11 +280,6 @@ void AStarPlanner::calculatePath(InputUpdates) {
 						if(pNeighbour->list != List_Unwalkable){ 
 							//	If not already on the open list, add it to the open list.			
 							if(pNeighbour->list != List_Open){	
-								//Create a new open list item in the binary heap.
-								int m = numberOfOpenListItems + 1;
-								openList[m] = pNeighbour;
-								pNeighbour->openListIndex = m;
-								
 								// Figure out its G cost
 								pNeighbour->g_cost = pRE->g_cost;
 								if(neighbourhood_index & 0x01) // non-diagonal neighbour									
@@ -224,28 +295,12 @@ void AStarPlanner::calculatePath(InputUpdates) {
 								pNeighbour->f_cost = pNeighbour->g_cost + h_cost;
 								pNeighbour->parent = pRE; 
 						
-								// Move the new open list item to the proper place in the binary heap.
-								// Starting at the bottom, successively compare to parent items,
-								// swapping as needed until the item finds its place in the heap
-								// or bubbles all the way to the top (if it has the lowest F cost).
-								while(m != 1){ // While item hasn't bubbled to the top (m=1)	
-									// Check if child's F cost is < parent's F cost. If so, swap them.	
-									int m_half = m >> 1;
-									if (openList[m]->f_cost <= openList[m_half]->f_cost){
-										RasterElement *temp = openList[m_half];
-										//temp->openListIndex = m;
-										openList[m_half] = openList[m];
-										openList[m_half]->openListIndex = m_half;
-										openList[m] = temp;
-										openList[m]->openListIndex = m;
-										m = m_half;
-									} else break;
-								}
-								numberOfOpenListItems++;
+								// Create a new open list item in the binary heap.
+								openListInsert(pNeighbour);
 	
 								//Change whichList to show that the new item is on the open list.
 								pNeighbour->list = List_Open;
-								ADD_TO_VISITED_MAP(pNeighbour)
+								if(Observed) planner->notifyOpened(pNeighbour->x, pNeighbour->y);
 							} else {
 								// If adjacent cell is already on the open list, check to see if this 
 								// path to that cell from the starting location is a better one. 
@@ -270,22 +325,8 @@ void AStarPlanner::calculatePath(InputUpdates) {
 									pNeighbour->g_cost = tempGcost;
 									pNeighbour->f_cost = tempGcost + h_cost;
 									pNeighbour->parent = pRE;
-																		
-									//See if changing the F score bubbles the item up from it's current location in the heap
-									int m = pNeighbour->openListIndex;
-									
-									while(m != 1){ //While item hasn't bubbled to the top (m=1)	
-										// Check if child is < parent. If so, swap them.	
-										int m_half = m >> 1;
-										if(openList[m]->f_cost < openList[m_half]->f_cost){
-											RasterElement *temp = openList[m_half];
-											openList[m_half] = openList[m];
-											openList[m_half]->openListIndex = m_half;
-											openList[m] = temp;
-											openList[m]->openListIndex = m;
-											m = m_half;
-										} else break;
-									} 
+									openListDecreaseKey(pNeighbour);
+									if(Observed) planner->notifyKeyUpdated(pNeighbour->x, pNeighbour->y);
 								}
 							}
 						} 
@@ -293,38 +334,181 @@ void AStarPlanner::calculatePath(InputUpdates) {
 				}
 			}
 	
-		} else {
-			setError("No Path found");
-			break;
-		}
+		} else return false;
 	
-		//If target is added to open list then path has been found.
-		if(pGoal->list == List_Closed){
-			// Path found, extract path data into QVector and return that
-			// 1st step: examine path length
-			int pathLength = 0;
-			pRE = pGoal;
-			while(1){
-				pathLength++;
-				if(pRE == pStart) break;
-				else pRE = pRE->parent;	
-			}	
-			
-			// 2nd step: store path points	
-			path.resize(pathLength);
-			pRE = pGoal;
-			int segmentIndex = pathLength - 1;
-			while(1) {				
-				path[segmentIndex--] = QPointF(pRE->x, pRE->y);
-				if(pRE == pStart) break;
-				else pRE = pRE->parent;
-			}
-			
-			break;
-		}
+		//If target is added to closed list then path has been found.
+		if(pGoal->list == List_Closed) return true;
 	}
+}
+
+// follows the parents from pGoal back to pStart
+void AStarPlanner::SearchContext::extractPath(RasterElement *pStart, RasterElement *pGoal, Path &path) const {
+	// 1st step: examine path length
+	int pathLength = 0;
+	RasterElement *pRE = pGoal;
+	while(1){
+		pathLength++;
+		if(pRE == pStart) break;
+		else pRE = pRE->parent;	
+	}	
 	
-	if(!visitedLayer) addDebugLayer(visitedLayer = new DebugLayer(tr("Show visited cells")));
+	// 2nd step: store path points	
+	path.resize(pathLength);
+	pRE = pGoal;
+	int segmentIndex = pathLength - 1;
+	while(1) {				
+		path[segmentIndex--] = QPointF(pRE->x, pRE->y);
+		if(pRE == pStart) break;
+		else pRE = pRE->parent;
+	}
+}
+
+void AStarPlanner::calculatePath(InputUpdates updates) {	
+	if(!context.openList || !context.rasterElements) {
+		setError("Planner memory allocation error");
+		return;
+	}
+	
+	// some preparations...
+	int width = mapWidth();
+	beginPhase(Phase_DebugLayers);
+	// the interrupted search is resumed unless the inputs have changed since
+	bool resume = context.suspended && !updates;
+	prepareVisitedMap(!resume);
 		
+	QPoint goalPos = this->goalPos().toPoint();
+	QPoint startPos = this->startPos().toPoint();
+	RasterElement *pStart = context.rasterElements + startPos.y() * width + startPos.x();
+	RasterElement *pGoal = context.rasterElements + goalPos.y() * width + goalPos.x();
+		
+	// check validity of start & goal
+	if(occupancy.at(goalPos.y() * width + goalPos.x())) {
+		setError("Goal position blocked");
+		return;
+	}	
+	if(occupancy.at(startPos.y() * width + startPos.x())) {
+		setError("Start position blocked");
+		return;
+	}
+
+	// A* initialization
+	beginPhase(Phase_Reset);
+	if(!resume) context.reset(occupancy, pGoal);
+
+	Path &path = pathBuffer();
+	beginPhase(Phase_Search);
+	bool found = observed() ? context.search<true>(this, pStart, pGoal, resume) : context.search<false>(this, pStart, pGoal, resume);
+	_counters += context._counters;
+	if(found) {
+		// Path found, extract path data into QVector and return that
+		beginPhase(Phase_PathExtraction);
+		context.extractPath(pStart, pGoal, path);
+	} else if(!context.suspended) setError("No Path found");
+	
 	setPath(path);
 }
+
+// (re-)allocates the image of the visited cells layer for the current map
+void AStarPlanner::prepareVisitedMap(bool clear) {
+	if(visitedMap.size() != mapSize()) {
+		visitedMap = QImage(mapSize(), QImage::Format_Indexed8);
+		static const QVector<QRgb> colors = QVector<QRgb>() << qRgba(0, 0, 0, 0) << qRgba(0, 255, 255, 128);
+		visitedMap.setColorTable(colors);
+		setMemoryUsage(Memory_DebugImages, visitedMap.byteCount());
+		clear = true;
+	}
+	if(clear) visitedMap.fill(0);
+	if(!visitedLayer) addDebugLayer(visitedLayer = new DebugLayer(tr("Show visited cells")));
+}
+
+// answers queries of a batch with its own search context until all queries are taken
+class AStarPlanner::BatchWorker: public QRunnable {
+public:
+	BatchWorker(AStarPlanner *planner, const QByteArray &occupancy, const QSize &mapSize, const QVector<Query> &queries,
+				Path *paths, std::atomic<int> &nextQuery, QSemaphore *done):
+		planner(planner), occupancy(occupancy), mapSize(mapSize), queries(queries), paths(paths), nextQuery(nextQuery), done(done) { }
+	
+	void run() {
+		SearchContext *context = planner->takeBatchContext(mapSize);
+		if(context) {
+			QRect mapRect(QPoint(0, 0), mapSize);
+			int i;
+			while((i = nextQuery++) < queries.size()) {
+				const QPoint &start = queries[i].first;
+				const QPoint &goal = queries[i].second;
+				if(!mapRect.contains(start) || !mapRect.contains(goal)) continue;
+				int startIdx = start.y() * mapSize.width() + start.x();
+				int goalIdx = goal.y() * mapSize.width() + goal.x();
+				if(occupancy.at(startIdx) || occupancy.at(goalIdx)) continue;
+				
+				RasterElement *pStart = context->rasterElements + startIdx;
+				RasterElement *pGoal = context->rasterElements + goalIdx;
+				context->reset(occupancy, pGoal);
+				if(context->search<false>(NULL, pStart, pGoal, false)) context->extractPath(pStart, pGoal, paths[i]);
+			}
+			planner->returnBatchContext(context);
+		}
+		if(done) done->release();
+	}
+	
+private:
+	AStarPlanner *planner;
+	const QByteArray &occupancy;
+	QSize mapSize;
+	const QVector<Query> &queries;
+	Path *paths;
+	std::atomic<int> &nextQuery;
+	QSemaphore *done; // NULL for the worker running in the calling thread
+};
+
+QVector<Path> AStarPlanner::planBatch(const QVector<Query> &queries, int numThreads) {
+	QVector<Path> paths(queries.size());
+	if(queries.isEmpty()) return paths;
+	
+	// the searches work on a snapshot, so the planner may get a new map meanwhile
+	if(numThreads <= 0) numThreads = QThread::idealThreadCount();
+	numThreads = qBound(1, numThreads, queries.size());
+	batchMutex.lock();
+	QByteArray occupancy = this->occupancy;
+	QSize mapSize = occupancySize;
+	if(batchPool.maxThreadCount() < numThreads - 1) batchPool.setMaxThreadCount(numThreads - 1);
+	batchMutex.unlock();
+	if(mapSize.isEmpty()) return paths;
+	
+	// the workers take the next query until all are answered, the calling thread is one of them
+	std::atomic<int> nextQuery(0);
+	QSemaphore done;
+	Path *pPaths = paths.data();
+	for(int i = 1; i < numThreads; i++) batchPool.start(new BatchWorker(this, occupancy, mapSize, queries, pPaths, nextQuery, &done));
+	BatchWorker(this, occupancy, mapSize, queries, pPaths, nextQuery, NULL).run();
+	done.acquire(numThreads - 1);
+	return paths;
+}
+
+AStarPlanner::SearchContext *AStarPlanner::takeBatchContext(const QSize &size) {
+	batchMutex.lock();
+	SearchContext *batchContext = NULL;
+	while(!batchContexts.isEmpty() && !batchContext) {
+		batchContext = batchContexts.takeLast();
+		if(batchContext->allocatedSize != size) {
+			delete batchContext;
+			batchContext = NULL;
+		}
+	}
+	batchMutex.unlock();
+	if(batchContext) return batchContext;
+	
+	batchContext = new SearchContext;
+	if(!batchContext->allocate(size)) {
+		printf("Could not allocate path planner memory\n");
+		delete batchContext;
+		return NULL;
+	}
+	return batchContext;
+}
+
+void AStarPlanner::returnBatchContext(SearchContext *batchContext) {
+	QMutexLocker locker(&batchMutex);
+	if(batchContext->allocatedSize == occupancySize) batchContexts.push_back(batchContext);
+	else delete batchContext;
+}
@@ -21,6 +21,10 @@
 
 #include "abstractplanner.h"
 #include <QImage>
+#include <QByteArray>
+#include <QMutex>
+#include <QPair>
+#include <QThreadPool>
 
 //#define HIGHQUALITYPATHPLANNER
 
@@ -29,13 +33,29 @@ public:
 	AStarPlanner(QObject *parent = 0);
 	~AStarPlanner();
 	
+#ifdef HIGHQUALITYPATHPLANNER
+	bool isOptimal() const { return true; }
+#else
+	bool isOptimal() const { return false; } // the Manhattan distance overestimates diagonal moves
+#endif
+	
+	/* multi-query planning: answers start/goal queries on the current map in parallel, independent of the
+	 * planner's own start, goal and path. The searches share the occupancy of the map (later map changes do
+	 * not affect a running batch), each thread has its own search context; the contexts are kept for the next
+	 * batch. Reentrant, i.e. may be called from several threads at once and while the planner plans in the
+	 * background. numThreads = 0 uses QThread::idealThreadCount(). Returns a path per query, empty if there
+	 * is none or start or goal are outside of the map or blocked.
+	 */
+	typedef QPair<QPoint, QPoint> Query; // start, goal
+	QVector<Path> planBatch(const QVector<Query> &queries, int numThreads = 0);
+	
 protected:
 	void initMap(const QImage &map, const QRect &updateRegion = QRect());
 	void calculatePath(InputUpdates updates);
 	
 	void drawDebugLayer(QPainter &painter, const DebugLayer *layer, const QRect &visibleArea, qreal zoomFactor);
 	
-private:
+	// the cells, search contexts and occupancy are shared with BidirectionalAStarPlanner
 	enum ListType {
 		List_None,
 		List_Open,
@@ -53,13 +73,52 @@ private:
 		int openListIndex; // must be an index because otherwise the binary heap to array mapping would not be applicable
 		unsigned short x, y; // coordinates of the element (can be deduced from the pointer, of course, but this would be a rather time consuming calculation)
 	};
-	RasterElement *rasterElements;	
-	RasterElement **openList;
 	
-	void freeMemory();
+	/* search state of a query: costs and list membership of the cells and the open list. The planner's calls
+	 * search with context, planBatch() with a context per thread
+	 */
+	struct SearchContext {
+		SearchContext(): rasterElements(NULL), openList(NULL), openListLength(0), suspended(false) { }
+		~SearchContext() { freeMemory(); }
+		bool allocate(const QSize &size);
+		void freeMemory();
+		void reset(const QByteArray &occupancy, const RasterElement *pGoal); // (re-)initializes the cells for a search to pGoal
+		
+		void openListInsert(RasterElement *pRE);
+		RasterElement *openListPop();
+		void openListDecreaseKey(RasterElement *pRE); // call after pRE->f_cost has been lowered
+		// planner is notified (if Observed) and may interrupt the search, NULL for batch queries
+		template<bool Observed> bool search(AStarPlanner *planner, RasterElement *pStart, RasterElement *pGoal, bool resume);
+		void extractPath(RasterElement *pStart, RasterElement *pGoal, Path &path) const;
+		
+		RasterElement *rasterElements;	
+		RasterElement **openList; // binary heap ordered by f_cost, index 0 is unused
+		int openListLength;
+		QSize allocatedSize; // of rasterElements and openList
+		bool suspended; // search() has been interrupted, a call without input updates resumes it
+		Counters _counters; // of the last search, use PLANNER_COUNT() to modify
+	};
+	SearchContext context;
+	// neighbors of a cell, the diagonal ones have an even index
+	static const int neighbourhood_dx[8], neighbourhood_dy[8];
+	
+	QByteArray occupancy; // 1 for blocked cells, row by row; shared with running batches
+	QSize occupancySize;
 	
 	DebugLayer *visitedLayer;
 	QImage visitedMap;
+	void prepareVisitedMap(bool clear);
+	
+private:
+	friend class PlannerMicrobench; // kernel benchmarks
+	QMutex batchMutex; // guards occupancy (modified in the planner's thread) and batchContexts against planBatch()
+	QList<SearchContext *> batchContexts; // idle contexts of planBatch()
+	QThreadPool batchPool;
+	class BatchWorker;
+	SearchContext *takeBatchContext(const QSize &size);
+	void returnBatchContext(SearchContext *batchContext);
+	
+	DebugImageObserver visitedObserver;
 };
 
 #endif // ASTARPLANNER_H
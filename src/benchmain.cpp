@@ -0,0 +1,797 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QApplication>
+#include <QStringList>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QThread>
+#include <cstdio>
+#include <algorithm>
+#include "plannerfactory.h"
+#include "astarplanner.h"
+#include "plannerbench.h"
+#include "benchreport.h"
+#include "plannercheck.h"
+#include "scenario.h"
+#include "mapedit.h"
+#include "maputils.h"
+#include "mapgenerator.h"
+#include "sessionlog.h"
+#include "trace.h"
+#include "metricsexporter.h"
+
+static void printUsage(const char *appName) {
+	printf("Usage: %s [options] [<map> ...]\n"
+		   "Runs start/goal queries on all (or the selected) planners without GUI.\n"
+		   "Maps may be images, MovingAI .map files or generated maps (see below).\n\n"
+		   "Options:\n"
+		   "  -p, --planner <index|name>  benchmark only this planner (may be repeated)\n"
+		   "  -n, --queries <n>           number of random queries per map (default: 10)\n"
+		   "  -s, --seed <n>              seed for the random queries (default: 1)\n"
+		   "  -q, --query <sx,sy,gx,gy>   run this query instead of random ones (may be repeated)\n"
+		   "  -S, --scen <file>           run the queries of a MovingAI scenario file (may be repeated)\n"
+		   "      --csv <file>            write per-query results as CSV\n"
+		   "      --json <file>           write per-query results as JSON\n"
+		   "      --quiet                 print the summary only\n"
+		   "      --hw-counters           measure cycles, instructions, cache and branch misses of each query (Linux perf)\n"
+		   "      --alloc-free            run the planners in allocation-free mode, fails (exit code 1) if a query or map\n"
+		   "                              update after the first query on a map allocates heap memory\n"
+		   "      --budget <n>[us]        anytime planning: interrupt planner calls after n expansions (or n microseconds)\n"
+		   "                              and resume them until the plan is complete; times include all calls\n"
+		   "      --batch <threads>       multi-query A*: answer the queries of each map with AStarPlanner::planBatch() on one and\n"
+		   "                              on <threads> threads (0: ideal thread count), fails if the paths differ\n"
+		   "      --trace <file>          write planner trace events as Chrome trace JSON (chrome://tracing, ui.perfetto.dev)\n"
+		   "      --metrics <file>        write planner metrics in Prometheus text format (node_exporter textfile collector)\n"
+		   "\nMap update replay (incremental replanning):\n"
+		   "  -e, --edits <n>             replay n random map edits after the first query of each map\n"
+		   "      --edit-size <n>         maximum extent of random edits in cells (default: 32)\n"
+		   "      --edit-script <file>    replay the map edits of this script instead of random ones\n"
+		   "      --save-edits <file>     save the replayed map edits as script\n"
+		   "\nEquivalence and regression check (exit code 1 on failures):\n"
+		   "      --check                 compare the path costs of the planners on each query (or map update):\n"
+		   "                              optimal planners must agree, the others may not find cheaper paths;\n"
+		   "                              a planner that returns no path must report why (with --budget: after resuming)\n"
+		   "      --baseline <file>       fail on changed path costs and on time or expansion regressions against this baseline\n"
+		   "      --save-baseline <file>  save path costs, total time and expansions per planner and map as baseline\n"
+		   "      --tolerance <t>[,<e>]   allowed time and expansion increase in percent (default: 20,5)\n"
+		   "\nGenerated maps:\n"
+		   "  gen:<type>[:<key>=<value>[,<value> ...]] ...\n"
+		   "    types: random, maze, rooms, field\n"
+		   "    keys:  size=<n>|<w>x<h> (1024), density=<0..1> (0.2), seed=<n> (1), block=<n> (1),\n"
+		   "           width=<corridor width> (4), wall=<thickness> (1), room=<min. room size> (32)\n"
+		   "    lists of values sweep all combinations, e.g. gen:random:size=1000,2000,4000:density=0.1,0.2\n"
+		   "\n"
+		   "\nSession replay:\n"
+		   "      --session <file>        replay a session recorded in the GUI (File / Record Session) at full speed;\n"
+		   "                              the recorded planner switches are followed unless planners are selected with -p\n"
+		   "\n"
+		   "  -l, --list                  list available planners\n"
+		   "  -h, --help                  show this help\n", appName);
+}
+
+static int findPlanner(const PlannerFactories &factories, const QString &spec) {
+	bool ok;
+	int idx = spec.toInt(&ok);
+	if(ok) return (idx >= 0 && idx < factories.size()) ? idx : -1;
+	for(int i = 0; i < factories.size(); i++) {
+		if(factories[i]->name().startsWith(spec)) return i;
+	}
+	return -1;
+}
+
+static double percentile(QVector<double> values, double p) {
+	if(values.isEmpty()) return 0.0;
+	std::sort(values.begin(), values.end());
+	double pos = p * (values.size() - 1);
+	int idx = (int)pos;
+	if(idx + 1 >= values.size()) return values.last();
+	return values[idx] + (pos - idx) * (values[idx + 1] - values[idx]);
+}
+
+static void printMemoryHeader() {
+	printf("\n%-22s", "memory [KiB]");
+	for(int i = 0; i < AbstractPlanner::NumMemoryComponents; i++) {
+		printf(" %12s", qPrintable(AbstractPlanner::memoryComponentName((AbstractPlanner::MemoryComponent)i)));
+	}
+	printf(" %12s %12s %10s\n", "total", "peak", "bytes/cell");
+}
+
+// current memory per component of the bench's planner, its peak and the peak bytes per map cell
+static QString memoryLine(PlannerBench &bench, const QImage &map) {
+	const AbstractPlanner *planner = bench.planner();
+	QString line = QString().sprintf("%-22s", qPrintable(bench.plannerName()));
+	for(int i = 0; i < AbstractPlanner::NumMemoryComponents; i++) {
+		line += QString().sprintf(" %12.1f", planner->memoryUsage((AbstractPlanner::MemoryComponent)i) / 1024.0);
+	}
+	double numCells = qMax(1.0, (double)map.width() * map.height());
+	line += QString().sprintf(" %12.1f %12.1f %10.1f", planner->memoryUsage() / 1024.0, planner->peakMemoryUsage() / 1024.0,
+							  planner->peakMemoryUsage() / numCells);
+	return line;
+}
+
+// heap allocations of one planner's calls, only counted if AllocationCounters::available()
+struct AllocationSummary {
+	AllocationSummary(): calls(0), allocations(0), maxAllocations(0), bytes(0) { }
+	void add(const PlannerBench::Result &r) {
+		calls++;
+		allocations += r.allocations.allocations;
+		maxAllocations = qMax(maxAllocations, r.allocations.allocations);
+		bytes += r.allocations.bytes;
+	}
+	// violations: calls after the warm-up that allocated in allocation-free mode
+	QString line(PlannerBench &bench) const {
+		double n = qMax(calls, 1);
+		return QString().sprintf("%-22s %12.1f %12llu %12.1f %12u", qPrintable(bench.plannerName()), allocations / n,
+								 (unsigned long long)maxAllocations, bytes / n / 1024.0, bench.planner()->allocationViolations());
+	}
+	static void printHeader() {
+		printf("\n%-22s %12s %12s %12s %12s\n", "allocations", "mean/call", "max/call", "KiB/call", "violations");
+	}
+	
+	int calls;
+	uint64_t allocations, maxAllocations, bytes;
+};
+
+// one map and the queries to run on it
+struct BenchJob {
+	QString mapFile;
+	PlannerBench::Queries queries;
+};
+
+// returns the number of allocation-free mode violations
+static unsigned runJob(const BenchJob &job, const QImage &map, const PlannerFactories &factories, const QList<int> &plannerIndices,
+					   bool quiet, bool allocationFree, BenchReport &report) {
+	const PlannerBench::Queries &queries = job.queries;
+	printf("\n### map %s (%d x %d), %d queries\n", qPrintable(job.mapFile), map.width(), map.height(), queries.size());
+	if(!quiet) printf("%-22s %5s %13s %13s %12s %7s %10s %10s %8s\n", "planner", "query", "start", "goal", "time [ms]", "cells", "length", "expanded", "subopt.");
+	
+	QStringList summary, phaseSummary, counterSummary, hardwareSummary, memorySummary, allocationSummary, budgetSummary;
+	unsigned allocationViolations = 0;
+	foreach(int plannerIdx, plannerIndices) {
+		PlannerBench bench(factories[plannerIdx]);
+		bench.planner()->setAllocationFree(allocationFree);
+		bench.setMap(map);
+		AllocationSummary allocations;
+		int plannerCalls = 0, maxPlannerCalls = 0;
+		int64_t maxCallNs = 0;
+		
+		QVector<double> times;
+		uint64_t expansions = 0;
+		int64_t phaseNs[AbstractPlanner::NumTimingPhases] = { 0 };
+		AbstractPlanner::Counters counters;
+		int64_t hardwareCounters[PerfCounters::NumEvents] = { 0 };
+		int numMeasured = 0;
+		int numSuccess = 0, numReference = 0;
+		double suboptimality = 0.0;
+		for(int i = 0; i < queries.size(); i++) {
+			const PlannerBench::Query &q = queries[i];
+			PlannerBench::Result r = bench.run(q);
+			report.add(bench.plannerName(), job.mapFile, i, q, r);
+			allocations.add(r);
+			plannerCalls += r.plannerCalls;
+			maxPlannerCalls = qMax(maxPlannerCalls, r.plannerCalls);
+			maxCallNs = qMax(maxCallNs, r.maxCallNs);
+			
+			double timeMs = r.timeNs * 1e-6;
+			times.push_back(timeMs);
+			expansions += r.counters.expansions;
+			counters.heapInserts += r.counters.heapInserts;
+			counters.decreaseKeys += r.counters.decreaseKeys;
+			counters.heapUpSwaps += r.counters.heapUpSwaps;
+			counters.heapDownSwaps += r.counters.heapDownSwaps;
+			counters.cellsTouched += r.counters.cellsTouched;
+			counters.processStateCalls += r.counters.processStateCalls;
+			counters.updateVertexCalls += r.counters.updateVertexCalls;
+			for(int j = 0; j < AbstractPlanner::NumTimingPhases; j++) phaseNs[j] += r.phaseNs[j];
+			if(r.hardwareCounters.isValid()) {
+				for(int j = 0; j < PerfCounters::NumEvents; j++) hardwareCounters[j] += r.hardwareCounters.value[j];
+				numMeasured++;
+			}
+			if(r.success()) numSuccess++;
+			if(r.suboptimality(q) > 0.0) {
+				suboptimality += r.suboptimality(q);
+				numReference++;
+			}
+			
+			if(quiet) continue;
+			QString start = QString("(%1,%2)").arg(q.start.x()).arg(q.start.y());
+			QString goal = QString("(%1,%2)").arg(q.goal.x()).arg(q.goal.y());
+			printf("%-22s %5d %13s %13s %12.3f %7d %10.1f %10llu %8.4f %s\n", qPrintable(bench.plannerName()), i, qPrintable(start), qPrintable(goal),
+				   timeMs, r.pathCells, r.pathLength, (unsigned long long)r.counters.expansions, r.suboptimality(q), qPrintable(r.error));
+		}
+		
+		double total = 0.0;
+		foreach(double t, times) total += t;
+		summary.push_back(QString().sprintf("%-22s %7d/%-7d %12.3f %10.3f %10.3f %10.3f %10.3f %10.1f %10llu %8.4f", qPrintable(bench.plannerName()), 
+							numSuccess, queries.size(), total, times.isEmpty() ? 0.0 : total / times.size(), 
+							percentile(times, 0.5), percentile(times, 0.95), percentile(times, 1.0),
+							total > 0.0 ? 1000.0 * queries.size() / total : 0.0,
+							(unsigned long long)(queries.isEmpty() ? 0 : expansions / queries.size()),
+							numReference ? suboptimality / numReference : 0.0));
+		
+		QString phases;
+		for(int j = 0; j < AbstractPlanner::NumTimingPhases; j++) {
+			phases += QString().sprintf(" %16.3f", queries.isEmpty() ? 0.0 : phaseNs[j] * 1e-6 / queries.size());
+		}
+		phaseSummary.push_back(QString().sprintf("%-22s", qPrintable(bench.plannerName())) + phases);
+		
+		unsigned long long n = qMax(queries.size(), 1);
+		counterSummary.push_back(QString().sprintf("%-22s %12llu %12llu %12llu %12llu %12llu %12llu %12llu", qPrintable(bench.plannerName()),
+							(unsigned long long)counters.heapInserts / n, (unsigned long long)counters.decreaseKeys / n, 
+							(unsigned long long)counters.heapUpSwaps / n, (unsigned long long)counters.heapDownSwaps / n, 
+							(unsigned long long)counters.cellsTouched / n, (unsigned long long)counters.processStateCalls / n, 
+							(unsigned long long)counters.updateVertexCalls / n));
+		
+		memorySummary.push_back(memoryLine(bench, map));
+		allocationSummary.push_back(allocations.line(bench));
+		allocationViolations += bench.planner()->allocationViolations();
+		budgetSummary.push_back(QString().sprintf("%-22s %12.2f %12d %14.3f", qPrintable(bench.plannerName()),
+							(double)plannerCalls / qMax(queries.size(), 1), maxPlannerCalls, maxCallNs * 1e-6));
+		
+		if(numMeasured) {
+			// misses per expansion compare the cache friendliness of the cell layouts independent of the search effort
+			QString line = QString().sprintf("%-22s", qPrintable(bench.plannerName()));
+			for(int j = 0; j < PerfCounters::NumEvents; j++) line += QString().sprintf(" %14lld", (long long)(hardwareCounters[j] / numMeasured));
+			double instructions = hardwareCounters[PerfCounters::Instructions], cycles = hardwareCounters[PerfCounters::Cycles];
+			double exp = qMax<double>(expansions, 1.0);
+			line += QString().sprintf(" %6.2f %10.3f %10.3f", cycles > 0 ? instructions / cycles : 0.0, 
+									  hardwareCounters[PerfCounters::L1DMisses] / exp, hardwareCounters[PerfCounters::LLCMisses] / exp);
+			hardwareSummary.push_back(line);
+		}
+	}
+	printf("\n%-22s %15s %12s %10s %10s %10s %10s %10s %10s %8s\n", "summary", "found", "total [ms]", "mean [ms]", "p50 [ms]", "p95 [ms]", "max [ms]",
+		   "queries/s", "mean exp.", "subopt.");
+	foreach(const QString &line, summary) printf("%s\n", qPrintable(line));
+	
+	printf("\n%-22s", "mean phase time [ms]");
+	for(int j = 0; j < AbstractPlanner::NumTimingPhases; j++) printf(" %16s", qPrintable(AbstractPlanner::phaseName((AbstractPlanner::TimingPhase)j)));
+	printf("\n");
+	foreach(const QString &line, phaseSummary) printf("%s\n", qPrintable(line));
+	
+	if(AbstractPlanner::countersEnabled()) {
+		printf("\n%-22s %12s %12s %12s %12s %12s %12s %12s\n", "mean counters", "inserts", "decr. keys", "up swaps", "down swaps", 
+			   "touched", "processState", "updateVertex");
+		foreach(const QString &line, counterSummary) printf("%s\n", qPrintable(line));
+	}
+	
+	printMemoryHeader();
+	foreach(const QString &line, memorySummary) printf("%s\n", qPrintable(line));
+	
+	if(AllocationCounters::available()) {
+		AllocationSummary::printHeader();
+		foreach(const QString &line, allocationSummary) printf("%s\n", qPrintable(line));
+	}
+	
+	if(PlannerBench::plannerBudgetSet()) {
+		// the longest call shows whether the budget holds, the calls per query what the resumption costs
+		printf("\n%-22s %12s %12s %14s\n", "anytime budget", "calls/query", "max calls", "max call [ms]");
+		foreach(const QString &line, budgetSummary) printf("%s\n", qPrintable(line));
+	}
+	
+	if(!hardwareSummary.isEmpty()) {
+		printf("\n%-22s", "mean hw counters");
+		for(int j = 0; j < PerfCounters::NumEvents; j++) printf(" %14s", qPrintable(PerfCounters::eventName((PerfCounters::Event)j)));
+		printf(" %6s %10s %10s\n", "IPC", "L1D/exp.", "LLC/exp.");
+		foreach(const QString &line, hardwareSummary) printf("%s\n", qPrintable(line));
+	}
+	return allocationViolations;
+}
+
+// update region areas used to break down replanning latencies, the last class is open-ended
+static const int editAreaClasses[] = { 16, 64, 256, 1024, 4096, 16384 };
+static const int numEditAreaClasses = sizeof(editAreaClasses) / sizeof(editAreaClasses[0]) + 1;
+
+static int editAreaClass(const QRect &region) {
+	int area = region.width() * region.height();
+	for(int i = 0; i < numEditAreaClasses - 1; i++) {
+		if(area <= editAreaClasses[i]) return i;
+	}
+	return numEditAreaClasses - 1;
+}
+
+/* plans the first query of the job, then applies the edits one after another and
+ * measures each planner's updateMap() latency; returns the number of allocation-free mode violations
+ */
+static unsigned runEditReplay(const BenchJob &job, const QImage &map, const MapEdits &edits, const PlannerFactories &factories,
+							  const QList<int> &plannerIndices, bool quiet, bool allocationFree, BenchReport &report) {
+	if(job.queries.isEmpty()) return 0;
+	const PlannerBench::Query &q = job.queries.first();
+	printf("\n### map %s (%d x %d), query (%d,%d) -> (%d,%d), %d map updates\n", qPrintable(job.mapFile), map.width(), map.height(),
+		   q.start.x(), q.start.y(), q.goal.x(), q.goal.y(), edits.size());
+	if(!quiet) printf("%-22s %5s %-6s %21s %12s %10s %7s %s\n", "planner", "edit", "tool", "update region", "time [ms]", "expanded", "cells", "error");
+	
+	QStringList summary, memorySummary, allocationSummary;
+	unsigned allocationViolations = 0;
+	QList<QVector<QVector<double> > > timesByArea; // per planner and area class
+	foreach(int plannerIdx, plannerIndices) {
+		PlannerBench bench(factories[plannerIdx]);
+		bench.planner()->setAllocationFree(allocationFree);
+		bench.setMap(map);
+		PlannerBench::Result initial = bench.run(q);
+		report.add(bench.plannerName(), job.mapFile, -1, q, initial);
+		AllocationSummary allocations;
+		allocations.add(initial);
+		
+		QImage editedMap = map.copy();
+		QVector<double> times;
+		QVector<QVector<double> > areaTimes(numEditAreaClasses);
+		uint64_t expansions = 0;
+		int numSuccess = 0;
+		for(int i = 0; i < edits.size(); i++) {
+			QRect region = edits[i].apply(editedMap);
+			if(region.isEmpty()) continue;
+			PlannerBench::Result r = bench.update(editedMap, region);
+			report.add(bench.plannerName(), job.mapFile, i, q, r, region);
+			allocations.add(r);
+			
+			double timeMs = r.timeNs * 1e-6;
+			times.push_back(timeMs);
+			areaTimes[editAreaClass(region)].push_back(timeMs);
+			expansions += r.counters.expansions;
+			if(r.success()) numSuccess++;
+			
+			if(quiet) continue;
+			static const char *toolNames[] = { "pen", "line", "rect" };
+			QString rect = QString("%1x%2+%3+%4").arg(region.width()).arg(region.height()).arg(region.x()).arg(region.y());
+			printf("%-22s %5d %-6s %21s %12.3f %10llu %7d %s\n", qPrintable(bench.plannerName()), i, toolNames[edits[i].tool], qPrintable(rect),
+				   timeMs, (unsigned long long)r.counters.expansions, r.pathCells, qPrintable(r.error));
+		}
+		timesByArea.push_back(areaTimes);
+		memorySummary.push_back(memoryLine(bench, map));
+		allocationSummary.push_back(allocations.line(bench));
+		allocationViolations += bench.planner()->allocationViolations();
+		
+		double total = 0.0;
+		foreach(double t, times) total += t;
+		summary.push_back(QString().sprintf("%-22s %12.3f %7d/%-7d %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f %10llu", qPrintable(bench.plannerName()), 
+							initial.timeNs * 1e-6, numSuccess, times.size(), times.isEmpty() ? 0.0 : total / times.size(),
+							percentile(times, 0.5), percentile(times, 0.9), percentile(times, 0.99), percentile(times, 1.0), total,
+							(unsigned long long)(times.isEmpty() ? 0 : expansions / times.size())));
+	}
+	printf("\n%-22s %12s %15s %10s %10s %10s %10s %10s %10s %10s\n", "update latency", "initial [ms]", "found", "mean [ms]", "p50 [ms]", 
+		   "p90 [ms]", "p99 [ms]", "max [ms]", "total [ms]", "mean exp.");
+	foreach(const QString &line, summary) printf("%s\n", qPrintable(line));
+	
+	// median latency by size of the update region, shows where incremental replanning stops paying off
+	printf("\n%-22s", "p50 [ms] by area");
+	for(int i = 0; i < numEditAreaClasses; i++) {
+		QString label = (i < numEditAreaClasses - 1) ? QString("<= %1").arg(editAreaClasses[i]) : QString("> %1").arg(editAreaClasses[i - 1]);
+		printf(" %10s", qPrintable(label));
+	}
+	printf("\n");
+	for(int p = 0; p < plannerIndices.size(); p++) {
+		printf("%-22s", qPrintable(factories[plannerIndices[p]]->name()));
+		for(int i = 0; i < numEditAreaClasses; i++) {
+			const QVector<double> &t = timesByArea[p][i];
+			if(t.isEmpty()) printf(" %10s", "-");
+			else printf(" %10.3f", percentile(t, 0.5));
+		}
+		printf("\n");
+	}
+	
+	printMemoryHeader();
+	foreach(const QString &line, memorySummary) printf("%s\n", qPrintable(line));
+	
+	if(AllocationCounters::available()) {
+		AllocationSummary::printHeader();
+		foreach(const QString &line, allocationSummary) printf("%s\n", qPrintable(line));
+	}
+	return allocationViolations;
+}
+
+/* answers the queries of the job with A*'s batch API, sequentially and in parallel; returns the number of
+ * queries whose paths differ
+ */
+static int runBatch(const BenchJob &job, const QImage &map, int numThreads) {
+	if(numThreads <= 0) numThreads = QThread::idealThreadCount();
+	QVector<AStarPlanner::Query> queries;
+	foreach(const PlannerBench::Query &q, job.queries) queries.push_back(AStarPlanner::Query(q.start, q.goal));
+	
+	AStarPlanner planner;
+	planner.setMap(map);
+	planner.planBatch(queries, numThreads); // allocates the search contexts
+	QElapsedTimer timer;
+	timer.start();
+	QVector<Path> sequential = planner.planBatch(queries, 1);
+	int64_t sequentialNs = timer.nsecsElapsed();
+	timer.restart();
+	QVector<Path> parallel = planner.planBatch(queries, numThreads);
+	int64_t parallelNs = timer.nsecsElapsed();
+	
+	int found = 0, mismatches = 0;
+	for(int i = 0; i < queries.size(); i++) {
+		if(!sequential[i].isEmpty()) found++;
+		if(sequential[i] != parallel[i]) mismatches++;
+	}
+	printf("\n### map %s, A* batch\n", qPrintable(job.mapFile));
+	printf("%-22s %8s %8s %8s %14s %14s %10s\n", "batch", "queries", "found", "threads", "1 thread [q/s]", "parallel [q/s]", "speedup");
+	printf("%-22s %8d %8d %8d %14.1f %14.1f %10.2f\n", "A* planBatch()", queries.size(), found, numThreads,
+		   queries.size() * 1e9 / qMax<int64_t>(sequentialNs, 1), queries.size() * 1e9 / qMax<int64_t>(parallelNs, 1),
+		   (double)sequentialNs / qMax<int64_t>(parallelNs, 1));
+	if(mismatches) printf("A* batch: %d of %d paths differ between the sequential and the parallel batch\n", mismatches, queries.size());
+	return mismatches;
+}
+
+/* replays a recorded GUI session with the planner calls of VisualizationWidget; plannerIdx < 0 follows
+ * the recorded planner switches, otherwise the given planner is used throughout the session
+ */
+static void runSessionReplay(const QString &fileName, const SessionLog &log, const PlannerFactories &factories, int plannerIdx,
+							 bool quiet, BenchReport &report) {
+	const QList<SessionLog::Event> &events = log.events();
+	printf("\n### session %s, %d events, planner %s\n", qPrintable(fileName), events.size(), 
+		   plannerIdx < 0 ? "as recorded" : qPrintable(factories[plannerIdx]->name()));
+	if(!quiet) printf("%6s %10s %-11s %-22s %21s %12s %14s %10s %7s %s\n", "event", "at [s]", "type", "planner", "region", "time [ms]", 
+					  "recorded [ms]", "expanded", "cells", "error");
+	
+	PlannerBench *bench = (plannerIdx < 0) ? NULL : new PlannerBench(factories[plannerIdx]);
+	QImage map;
+	QString mapName;
+	Pose2D start = Pose2D::invalid(), goal = Pose2D::invalid();
+	QVector<QVector<double> > times(SessionLog::Event_PlannerChanged + 1), recordedTimes(SessionLog::Event_PlannerChanged + 1);
+	
+	for(int i = 0; i < events.size(); i++) {
+		const SessionLog::Event &e = events[i];
+		PlannerBench::Result r;
+		bool called = false;
+		switch(e.type) {
+			case SessionLog::Event_MapLoaded:
+				{
+					e.applyTo(map);
+					mapName = e.name;
+					QRect rc = map.rect();
+					if(start.isValid() && !rc.contains(start.pos().toPoint())) start = Pose2D::invalid();
+					if(goal.isValid() && !rc.contains(goal.pos().toPoint())) goal = Pose2D::invalid();
+					if(bench) {
+						r = bench->load(map, start, goal);
+						called = true;
+					}
+				}
+				break;
+			case SessionLog::Event_StartChanged:
+				start = e.pose;
+				if(bench) {
+					r = bench->setStart(start);
+					called = true;
+				}
+				break;
+			case SessionLog::Event_GoalChanged:
+				goal = e.pose;
+				if(bench) {
+					r = bench->setGoal(goal);
+					called = true;
+				}
+				break;
+			case SessionLog::Event_MapUpdated:
+				e.applyTo(map);
+				if(bench) {
+					r = bench->update(map, e.region);
+					called = true;
+				}
+				break;
+			case SessionLog::Event_PlannerChanged:
+				if(plannerIdx >= 0) break;
+				{
+					delete bench;
+					bench = NULL;
+					int idx = findPlanner(factories, e.name);
+					if(idx < 0) {
+						fprintf(stderr, "Unknown planner \"%s\" in session, events are skipped up to the next planner switch\n", qPrintable(e.name));
+						break;
+					}
+					bench = new PlannerBench(factories[idx]);
+					r = bench->load(map, start, goal);
+					called = true;
+				}
+				break;
+		}
+		if(!called) continue;
+		
+		PlannerBench::Query q(start.isValid() ? start.pos().toPoint() : QPoint(-1, -1), goal.isValid() ? goal.pos().toPoint() : QPoint(-1, -1));
+		report.add(bench->plannerName(), mapName, i, q, r, e.type == SessionLog::Event_MapUpdated ? e.region : QRect());
+		times[e.type].push_back(r.timeNs * 1e-6);
+		if(e.calcTimeNs >= 0) recordedTimes[e.type].push_back(e.calcTimeNs * 1e-6);
+		
+		if(quiet) continue;
+		QString region = (e.type == SessionLog::Event_MapUpdated) ? 
+			QString("%1x%2+%3+%4").arg(e.region.width()).arg(e.region.height()).arg(e.region.x()).arg(e.region.y()) : QString("-");
+		QString recorded = (e.calcTimeNs >= 0) ? QString::number(e.calcTimeNs * 1e-6, 'f', 3) : QString("-");
+		printf("%6d %10.3f %-11s %-22s %21s %12.3f %14s %10llu %7d %s\n", i, e.timeNs * 1e-9, qPrintable(SessionLog::eventName(e.type)), 
+			   qPrintable(bench->plannerName()), qPrintable(region), r.timeNs * 1e-6, qPrintable(recorded), 
+			   (unsigned long long)r.counters.expansions, r.pathCells, qPrintable(r.error));
+	}
+	delete bench;
+	
+	printf("\n%-22s %7s %10s %10s %10s %10s %10s %15s %15s\n", "latency by event", "count", "mean [ms]", "p50 [ms]", "p90 [ms]", 
+		   "p99 [ms]", "max [ms]", "rec. p50 [ms]", "rec. max [ms]");
+	for(int type = SessionLog::Event_MapLoaded; type <= SessionLog::Event_PlannerChanged; type++) {
+		const QVector<double> &t = times[type], &rec = recordedTimes[type];
+		if(t.isEmpty()) continue;
+		double total = 0.0;
+		foreach(double v, t) total += v;
+		printf("%-22s %7d %10.3f %10.3f %10.3f %10.3f %10.3f", qPrintable(SessionLog::eventName((SessionLog::EventType)type)), t.size(),
+			   total / t.size(), percentile(t, 0.5), percentile(t, 0.9), percentile(t, 0.99), percentile(t, 1.0));
+		if(rec.isEmpty()) printf(" %15s %15s\n", "-", "-");
+		else printf(" %15.3f %15.3f\n", percentile(rec, 0.5), percentile(rec, 1.0));
+	}
+}
+
+int main(int argc, char *argv[]) {
+	QApplication app(argc, argv, false); // no GUI, planners only need QtGui's image and action classes
+	
+	PlannerFactories factories = createPlannerFactories();
+	QList<int> plannerIndices;
+	QStringList mapFiles, scenarioFiles;
+	PlannerBench::Queries fixedQueries;
+	int numQueries = 10;
+	unsigned seed = 1;
+	QString csvFile, jsonFile, traceFile, metricsFile;
+	bool quiet = false;
+	int numEdits = 0, maxEditExtent = 32;
+	QString editScriptFile, saveEditsFile;
+	QStringList sessionFiles;
+	bool checkEquivalence = false;
+	bool allocationFree = false;
+	int64_t budgetNs = 0;
+	uint64_t budgetExpansions = 0;
+	int batchThreads = -1;
+	QString baselineFile, saveBaselineFile;
+	qreal timeTolerance = 0.2, expansionTolerance = 0.05;
+	
+	QStringList args = app.arguments();
+	for(int i = 1; i < args.size(); i++) {
+		const QString &arg = args[i];
+		bool hasValue = (i + 1 < args.size());
+		bool ok = true;
+		if(arg == "-h" || arg == "--help") {
+			printUsage(argv[0]);
+			return 0;
+		} else if(arg == "-l" || arg == "--list") {
+			for(int j = 0; j < factories.size(); j++) printf("%d: %s\n", j, qPrintable(factories[j]->name()));
+			return 0;
+		} else if((arg == "-p" || arg == "--planner") && hasValue) {
+			int idx = findPlanner(factories, args[++i]);
+			if(idx < 0) {
+				fprintf(stderr, "Unknown planner \"%s\"\n", qPrintable(args[i]));
+				return 1;
+			}
+			plannerIndices.push_back(idx);
+		} else if((arg == "-n" || arg == "--queries") && hasValue) {
+			numQueries = args[++i].toInt(&ok);
+		} else if((arg == "-s" || arg == "--seed") && hasValue) {
+			seed = args[++i].toUInt(&ok);
+		} else if((arg == "-q" || arg == "--query") && hasValue) {
+			QStringList coords = args[++i].split(',');
+			QVector<int> c(4);
+			ok = (coords.size() == 4);
+			for(int j = 0; ok && j < 4; j++) c[j] = coords[j].toInt(&ok);
+			if(ok) fixedQueries.push_back(PlannerBench::Query(QPoint(c[0], c[1]), QPoint(c[2], c[3])));
+		} else if((arg == "-S" || arg == "--scen") && hasValue) {
+			scenarioFiles.push_back(args[++i]);
+		} else if(arg == "--csv" && hasValue) {
+			csvFile = args[++i];
+		} else if(arg == "--json" && hasValue) {
+			jsonFile = args[++i];
+		} else if(arg == "--hw-counters") {
+			PerfCounters perf;
+			if(perf.open()) AbstractPlanner::setHardwareCountersEnabled(true);
+			else fprintf(stderr, "Hardware counters not available (%s)\n", qPrintable(perf.lastError()));
+		} else if(arg == "--alloc-free") {
+			allocationFree = true;
+			if(!AllocationCounters::available()) fprintf(stderr, "Allocation counters not available, allocation-free mode is not checked\n");
+		} else if(arg == "--budget" && hasValue) {
+			QString budget = args[++i];
+			if(budget.endsWith("us")) budgetNs = 1000 * budget.left(budget.length() - 2).toLongLong(&ok);
+			else budgetExpansions = budget.toULongLong(&ok);
+		} else if(arg == "--batch" && hasValue) {
+			batchThreads = args[++i].toInt(&ok);
+		} else if(arg == "--trace" && hasValue) {
+			traceFile = args[++i];
+		} else if(arg == "--metrics" && hasValue) {
+			metricsFile = args[++i];
+		} else if(arg == "--quiet") {
+			quiet = true;
+		} else if((arg == "-e" || arg == "--edits") && hasValue) {
+			numEdits = args[++i].toInt(&ok);
+		} else if(arg == "--edit-size" && hasValue) {
+			maxEditExtent = args[++i].toInt(&ok);
+		} else if(arg == "--edit-script" && hasValue) {
+			editScriptFile = args[++i];
+		} else if(arg == "--save-edits" && hasValue) {
+			saveEditsFile = args[++i];
+		} else if(arg == "--session" && hasValue) {
+			sessionFiles.push_back(args[++i]);
+		} else if(arg == "--check") {
+			checkEquivalence = true;
+		} else if(arg == "--baseline" && hasValue) {
+			baselineFile = args[++i];
+		} else if(arg == "--save-baseline" && hasValue) {
+			saveBaselineFile = args[++i];
+		} else if(arg == "--tolerance" && hasValue) {
+			QStringList values = args[++i].split(',');
+			ok = (values.size() <= 2);
+			if(ok) timeTolerance = values[0].toDouble(&ok) / 100.0;
+			if(ok && values.size() == 2) expansionTolerance = values[1].toDouble(&ok) / 100.0;
+		} else if(arg.startsWith("-")) {
+			ok = false;
+		} else if(MapGenerator::isSpec(arg)) {
+			QString error;
+			QList<MapGenerator::Parameters> maps = MapGenerator::parseSpec(arg, &error);
+			if(maps.isEmpty()) {
+				fprintf(stderr, "%s\n", qPrintable(error));
+				return 1;
+			}
+			foreach(const MapGenerator::Parameters &p, maps) mapFiles.push_back(p.toString());
+		} else mapFiles.push_back(arg);
+		
+		if(!ok) {
+			fprintf(stderr, "Invalid argument \"%s\"\n", qPrintable(arg));
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+	
+	if(mapFiles.isEmpty() && scenarioFiles.isEmpty() && sessionFiles.isEmpty()) {
+		printUsage(argv[0]);
+		return 1;
+	}
+	bool followRecordedPlanners = plannerIndices.isEmpty();
+	if(plannerIndices.isEmpty()) {
+		for(int i = 0; i < factories.size(); i++) plannerIndices.push_back(i);
+	}
+	
+	PlannerBench::setPlannerBudget(budgetNs, budgetExpansions);
+	int result = 0;
+	if(!traceFile.isEmpty()) {
+		Trace::setThreadName("main");
+		Trace::setEnabled(true);
+	}
+	MetricsExporter metrics;
+	if(!metricsFile.isEmpty()) {
+		if(!metrics.start(metricsFile)) {
+			fprintf(stderr, "%s\n", qPrintable(metrics.lastError()));
+			return 1;
+		}
+		PlannerBench::setMetricsExporter(&metrics);
+	}
+	
+	// scenario files may reference several maps, queries of consecutive entries on the same map form one job
+	QList<BenchJob> jobs;
+	foreach(const QString &scenarioFile, scenarioFiles) {
+		Scenario scenario;
+		if(!scenario.load(scenarioFile)) {
+			fprintf(stderr, "%s\n", qPrintable(scenario.lastError()));
+			result = 1;
+			continue;
+		}
+		foreach(const Scenario::Entry &e, scenario.entries()) {
+			if(jobs.isEmpty() || jobs.last().mapFile != e.mapFile) {
+				jobs.push_back(BenchJob());
+				jobs.last().mapFile = e.mapFile;
+			}
+			jobs.last().queries.push_back(PlannerBench::Query(e.start, e.goal, e.bucket, e.optimalLength));
+		}
+	}
+	foreach(const QString &mapFile, mapFiles) {
+		jobs.push_back(BenchJob());
+		jobs.last().mapFile = mapFile;
+		jobs.last().queries = fixedQueries;
+	}
+	
+	MapEditScript editScript;
+	if(!editScriptFile.isEmpty() && !editScript.load(editScriptFile)) {
+		fprintf(stderr, "%s\n", qPrintable(editScript.lastError()));
+		return 1;
+	}
+	bool replayEdits = (numEdits > 0 || !editScriptFile.isEmpty());
+	
+	BenchReport report;
+	unsigned allocationViolations = 0;
+	QString loadedMapFile;
+	QImage map;
+	foreach(BenchJob job, jobs) {
+		if(job.mapFile != loadedMapFile) {
+			if(MapGenerator::isSpec(job.mapFile)) map = MapGenerator::generate(MapGenerator::parseSpec(job.mapFile).first());
+			else map = MapUtils::load(job.mapFile);
+			loadedMapFile = job.mapFile;
+		}
+		if(map.isNull()) {
+			fprintf(stderr, "Could not load map file \"%s\"\n", qPrintable(job.mapFile));
+			result = 1;
+			continue;
+		}
+		if(job.queries.isEmpty()) job.queries = PlannerBench::randomQueries(map, replayEdits ? 1 : numQueries, seed);
+		if(replayEdits) {
+			if(editScriptFile.isEmpty()) {
+				QList<QPoint> keepFree;
+				if(!job.queries.isEmpty()) keepFree << job.queries.first().start << job.queries.first().goal;
+				editScript.setEdits(MapEditScript::random(map.size(), numEdits, seed, maxEditExtent, keepFree));
+			}
+			if(!saveEditsFile.isEmpty() && !editScript.save(saveEditsFile)) {
+				fprintf(stderr, "Could not write \"%s\"\n", qPrintable(saveEditsFile));
+				result = 1;
+			}
+			allocationViolations += runEditReplay(job, map, editScript.edits(), factories, plannerIndices, quiet, allocationFree, report);
+		} else allocationViolations += runJob(job, map, factories, plannerIndices, quiet, allocationFree, report);
+		if(batchThreads >= 0 && runBatch(job, map, batchThreads)) result = 1;
+	}
+	if(allocationViolations) {
+		printf("\nallocation-free mode: %u planner calls allocated after the warm-up\n", allocationViolations);
+		result = 1;
+	}
+	
+	foreach(const QString &sessionFile, sessionFiles) {
+		SessionLog log;
+		if(!log.load(sessionFile)) {
+			fprintf(stderr, "%s\n", qPrintable(log.lastError()));
+			result = 1;
+			continue;
+		}
+		if(followRecordedPlanners) runSessionReplay(sessionFile, log, factories, -1, quiet, report);
+		else {
+			foreach(int plannerIdx, plannerIndices) runSessionReplay(sessionFile, log, factories, plannerIdx, quiet, report);
+		}
+	}
+
+	if(!csvFile.isEmpty() && !report.writeCsv(csvFile)) {
+		fprintf(stderr, "Could not write \"%s\"\n", qPrintable(csvFile));
+		result = 1;
+	}
+	if(!jsonFile.isEmpty() && !report.writeJson(jsonFile)) {
+		fprintf(stderr, "Could not write \"%s\"\n", qPrintable(jsonFile));
+		result = 1;
+	}
+	
+	PlannerCheck check;
+	check.setTolerances(timeTolerance, expansionTolerance);
+	if(checkEquivalence) {
+		QSet<QString> optimalPlanners;
+		foreach(PlannerFactoryBase *factory, factories) {
+			AbstractPlanner *planner = factory->create();
+			if(planner->isOptimal()) optimalPlanners.insert(factory->name());
+			delete planner;
+		}
+		check.setOptimalPlanners(optimalPlanners);
+		if(check.checkEquivalence(report)) result = 1;
+	}
+	if(!baselineFile.isEmpty()) {
+		if(!check.loadBaseline(baselineFile)) {
+			fprintf(stderr, "%s\n", qPrintable(check.lastError()));
+			result = 1;
+		} else if(check.checkBaseline(report)) result = 1;
+	}
+	if(!saveBaselineFile.isEmpty() && !check.saveBaseline(report, saveBaselineFile)) {
+		fprintf(stderr, "%s\n", qPrintable(check.lastError()));
+		result = 1;
+	}
+	
+	if(!traceFile.isEmpty() && !Trace::writeJson(traceFile)) {
+		fprintf(stderr, "Could not write \"%s\"\n", qPrintable(traceFile));
+		result = 1;
+	}
+	if(metrics.isRunning()) {
+		PlannerBench::setMetricsExporter(NULL);
+		if(!metrics.stop()) {
+			fprintf(stderr, "%s\n", qPrintable(metrics.lastError()));
+			result = 1;
+		}
+	}
+	
+	qDeleteAll(factories);
+	return result;
+}
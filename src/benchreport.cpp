@@ -0,0 +1,129 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "benchreport.h"
+#include <QFile>
+#include <QTextStream>
+
+void BenchReport::add(const QString &planner, const QString &map, int index, const PlannerBench::Query &query, const PlannerBench::Result &result,
+					  const QRect &updateRegion) {
+	Row row;
+	row.planner = planner;
+	row.map = map;
+	row.index = index;
+	row.query = query;
+	row.result = result;
+	row.updateRegion = updateRegion;
+	_rows.push_back(row);
+}
+
+static QString csvQuote(QString str) {
+	if(!str.contains(',') && !str.contains('"') && !str.contains('\n')) return str;
+	return "\"" + str.replace("\"", "\"\"") + "\"";
+}
+
+static QString jsonQuote(QString str) {
+	str.replace("\\", "\\\\");
+	str.replace("\"", "\\\"");
+	str.replace("\n", "\\n");
+	str.replace("\t", "\\t");
+	return "\"" + str + "\"";
+}
+
+bool BenchReport::writeCsv(const QString &fileName) const {
+	QFile file(fileName);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return false;
+	
+	QTextStream out(&file);
+	out << "planner,map,query,bucket,start_x,start_y,goal_x,goal_y,update_x,update_y,update_width,update_height,time_ns,reset_ns,search_ns,path_extraction_ns,debug_layers_ns,expansions,heap_inserts,decrease_keys,heap_up_swaps,heap_down_swaps,cells_touched,process_state_calls,update_vertex_calls,cycles,instructions,l1d_misses,llc_misses,branch_misses,memory_bytes,allocations,path_cells,path_length,path_cost,optimal_length,suboptimality,error\n";
+	foreach(const Row &r, _rows) {
+		out << csvQuote(r.planner) << ',' << csvQuote(r.map) << ',' << r.index << ',' << r.query.bucket << ','
+			<< r.query.start.x() << ',' << r.query.start.y() << ',' << r.query.goal.x() << ',' << r.query.goal.y() << ','
+			<< r.updateRegion.x() << ',' << r.updateRegion.y() << ',' << r.updateRegion.width() << ',' << r.updateRegion.height() << ','
+			<< (qlonglong)r.result.timeNs << ',';
+		for(int i = 0; i < AbstractPlanner::NumTimingPhases; i++) out << (qlonglong)r.result.phaseNs[i] << ',';
+		const AbstractPlanner::Counters &c = r.result.counters;
+		out << (qulonglong)c.expansions << ',' << (qulonglong)c.heapInserts << ',' << (qulonglong)c.decreaseKeys << ','
+			<< (qulonglong)c.heapUpSwaps << ',' << (qulonglong)c.heapDownSwaps << ',' << (qulonglong)c.cellsTouched << ','
+			<< (qulonglong)c.processStateCalls << ',' << (qulonglong)c.updateVertexCalls << ',';
+		// hardware counters are left empty if not measured
+		for(int i = 0; i < PerfCounters::NumEvents; i++) {
+			if(r.result.hardwareCounters.value[i] >= 0) out << (qlonglong)r.result.hardwareCounters.value[i];
+			out << ',';
+		}
+		out << (qlonglong)r.result.memoryBytes << ',';
+		if(AllocationCounters::available()) out << (qulonglong)r.result.allocations.allocations;
+		out << ',' << r.result.pathCells << ','
+			<< QString::number(r.result.pathLength, 'f', 6) << ',' << (qlonglong)r.result.pathCost << ',' 
+			<< QString::number(r.query.optimalLength, 'f', 6) << ','
+			<< QString::number(r.result.suboptimality(r.query), 'f', 6) << ',' << csvQuote(r.result.error) << '\n';
+	}
+	return true;
+}
+
+bool BenchReport::writeJson(const QString &fileName) const {
+	QFile file(fileName);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return false;
+	
+	QTextStream out(&file);
+	out << "[\n";
+	for(int i = 0; i < _rows.size(); i++) {
+		const Row &r = _rows[i];
+		out << "  {\"planner\": " << jsonQuote(r.planner) << ", \"map\": " << jsonQuote(r.map) << ", \"query\": " << r.index
+			<< ", \"bucket\": " << r.query.bucket
+			<< ", \"start\": [" << r.query.start.x() << ", " << r.query.start.y() << "]"
+			<< ", \"goal\": [" << r.query.goal.x() << ", " << r.query.goal.y() << "]";
+		if(!r.updateRegion.isEmpty()) {
+			out << ", \"update\": [" << r.updateRegion.x() << ", " << r.updateRegion.y() << ", " 
+				<< r.updateRegion.width() << ", " << r.updateRegion.height() << "]";
+		}
+		out << ", \"time_ns\": " << (qlonglong)r.result.timeNs
+			<< ", \"phases_ns\": {\"reset\": " << (qlonglong)r.result.phaseNs[AbstractPlanner::Phase_Reset]
+			<< ", \"search\": " << (qlonglong)r.result.phaseNs[AbstractPlanner::Phase_Search]
+			<< ", \"path_extraction\": " << (qlonglong)r.result.phaseNs[AbstractPlanner::Phase_PathExtraction]
+			<< ", \"debug_layers\": " << (qlonglong)r.result.phaseNs[AbstractPlanner::Phase_DebugLayers] << "}"
+			<< ", \"counters\": {\"expansions\": " << (qulonglong)r.result.counters.expansions
+			<< ", \"heap_inserts\": " << (qulonglong)r.result.counters.heapInserts
+			<< ", \"decrease_keys\": " << (qulonglong)r.result.counters.decreaseKeys
+			<< ", \"heap_up_swaps\": " << (qulonglong)r.result.counters.heapUpSwaps
+			<< ", \"heap_down_swaps\": " << (qulonglong)r.result.counters.heapDownSwaps
+			<< ", \"cells_touched\": " << (qulonglong)r.result.counters.cellsTouched
+			<< ", \"process_state_calls\": " << (qulonglong)r.result.counters.processStateCalls
+			<< ", \"update_vertex_calls\": " << (qulonglong)r.result.counters.updateVertexCalls << "}";
+		if(r.result.hardwareCounters.isValid()) {
+			static const char *keys[PerfCounters::NumEvents] = { "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses" };
+			out << ", \"hw_counters\": {";
+			for(int j = 0; j < PerfCounters::NumEvents; j++) {
+				out << (j ? ", \"" : "\"") << keys[j] << "\": ";
+				if(r.result.hardwareCounters.value[j] >= 0) out << (qlonglong)r.result.hardwareCounters.value[j];
+				else out << "null";
+			}
+			out << "}";
+		}
+		out << ", \"memory_bytes\": " << (qlonglong)r.result.memoryBytes << ", \"allocations\": ";
+		if(AllocationCounters::available()) out << (qulonglong)r.result.allocations.allocations;
+		else out << "null";
+		out << ", \"path_cells\": " << r.result.pathCells << ", \"path_length\": " << QString::number(r.result.pathLength, 'f', 6)
+			<< ", \"path_cost\": " << (qlonglong)r.result.pathCost
+			<< ", \"optimal_length\": " << QString::number(r.query.optimalLength, 'f', 6)
+			<< ", \"suboptimality\": " << QString::number(r.result.suboptimality(r.query), 'f', 6)
+			<< ", \"error\": " << jsonQuote(r.result.error) << "}" << (i + 1 < _rows.size() ? ",\n" : "\n");
+	}
+	out << "]\n";
+	return true;
+}
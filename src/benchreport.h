@@ -0,0 +1,52 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BENCHREPORT_H
+#define BENCHREPORT_H
+
+#include <QList>
+#include <QString>
+#include <QRect>
+#include "plannerbench.h"
+
+/* Collects the per-query results of a benchmark run and writes them as CSV or JSON
+ * for further evaluation
+ */
+class BenchReport {
+public:
+	struct Row {
+		QString planner;
+		QString map;
+		int index;
+		PlannerBench::Query query;
+		PlannerBench::Result result;
+		QRect updateRegion; // map update for update rows, empty for queries
+	};
+	
+	void add(const QString &planner, const QString &map, int index, const PlannerBench::Query &query, const PlannerBench::Result &result,
+			 const QRect &updateRegion = QRect());
+	const QList<Row> &rows() const { return _rows; }
+	
+	bool writeCsv(const QString &fileName) const;
+	bool writeJson(const QString &fileName) const;
+
+private:
+	QList<Row> _rows;
+};
+
+#endif // BENCHREPORT_H
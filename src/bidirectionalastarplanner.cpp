@@ -0,0 +1,282 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bidirectionalastarplanner.h"
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <new>
+#include <QThread>
+
+// best costs: the cost of a cell or INFINITE_COST, CLOSED set once the direction has expanded the cell
+#define INFINITE_COST	0x7fffffffu
+#define CLOSED			0x80000000u
+#define NO_MEETING		UINT64_MAX
+
+// octile distance, a consistent lower bound of the path cost with straight (10) and diagonal (14) moves
+static inline int heuristic(int x, int y, int targetX, int targetY) {
+	int dx = abs(x - targetX), dy = abs(y - targetY);
+	return (dx > dy) ? 10 * dx + 4 * dy : 10 * dy + 4 * dx;
+}
+
+// runs the backward search of each call, waits for searchStarted in between
+class BidirectionalAStarPlanner::BackwardThread: public QThread {
+public:
+	BackwardThread(BidirectionalAStarPlanner *planner): planner(planner), quit(false) { }
+	void stop() {
+		quit = true;
+		planner->searchStarted.release();
+		wait();
+	}
+protected:
+	void run() {
+		while(true) {
+			planner->searchStarted.acquire();
+			if(quit) return;
+			planner->search(Backward);
+			planner->searchFinished.release();
+		}
+	}
+private:
+	BidirectionalAStarPlanner *planner;
+	bool quit; // set before searchStarted is released
+};
+
+BidirectionalAStarPlanner::BidirectionalAStarPlanner(QObject *parent):
+	AStarPlanner(parent),
+	backwardThread(new BackwardThread(this)),
+	startIdx(0),
+	goalIdx(0),
+	meeting(NO_MEETING),
+	resume(false),
+	searchDone(false),
+	resetsDone(0)
+{
+	bestCosts[Forward] = bestCosts[Backward] = NULL;
+	backwardThread->start();
+}
+
+BidirectionalAStarPlanner::~BidirectionalAStarPlanner() {
+	backwardThread->stop();
+	delete backwardThread;
+	freeBestCosts();
+}
+
+void BidirectionalAStarPlanner::freeBestCosts() {
+	for(int i = 0; i < 2; i++) {
+		if(bestCosts[i]) delete[] bestCosts[i];
+		bestCosts[i] = NULL;
+	}
+}
+
+void BidirectionalAStarPlanner::initMap(const QImage &map, const QRect &updateRegion) {
+	AStarPlanner::initMap(map, updateRegion);
+	int64_t numCells = (int64_t)map.width() * map.height();
+	if(map.size() != backward.allocatedSize) {
+		freeBestCosts();
+		bool allocated = backward.allocate(map.size());
+		for(int i = 0; i < 2; i++) {
+			bestCosts[i] = new (std::nothrow) std::atomic<unsigned>[numCells];
+			allocated &= (bestCosts[i] != NULL);
+		}
+		if(!allocated) {
+			printf("Could not allocate path planner memory\n");
+			backward.freeMemory();
+			freeBestCosts();
+			return;
+		}
+	}
+	// both directions' cells and open lists
+	setMemoryUsage(Memory_Cells, numCells * (2 * sizeof(RasterElement) + 1 + 2 * sizeof(std::atomic<unsigned>)));
+	setMemoryUsage(Memory_OpenList, 2 * (numCells + 1) * sizeof(RasterElement *));
+}
+
+// a path through the cell idx has been found, keeps it if it is the cheapest one
+void BidirectionalAStarPlanner::offerMeeting(unsigned cost, int idx) {
+	uint64_t found = ((uint64_t)cost << 32) | idx, best = meeting.load();
+	while(found < best && !meeting.compare_exchange_weak(best, found)) { }
+}
+
+/* one direction of the search, called in the planner's thread (forward) and in the backward thread; the
+ * searches run until one of them has proven the cheapest path found so far to be optimal, or until the forward
+ * search is interrupted (context.suspended is set then, both open lists and the meeting are kept for resuming)
+ */
+void BidirectionalAStarPlanner::search(Direction direction) {
+	SearchContext &ctx = (direction == Forward) ? context : backward;
+	Counters &_counters = ctx._counters; // PLANNER_COUNT() counts per direction, the directions run concurrently
+	std::atomic<unsigned> *ownCosts = bestCosts[direction], *otherCosts = bestCosts[1 - direction];
+	int width = ctx.allocatedSize.width(), height = ctx.allocatedSize.height();
+	int sourceIdx = (direction == Forward) ? startIdx : goalIdx;
+	int targetIdx = (direction == Forward) ? goalIdx : startIdx;
+	int targetX = targetIdx % width, targetY = targetIdx / width;
+
+	_counters.clear();
+	RasterElement *pRE;
+	unsigned otherCost;
+	if(!resume) {
+		// reset this direction, the searches start when both are done
+		ctx.reset(occupancy, ctx.rasterElements + targetIdx);
+		int numCells = width * height;
+		for(int i = 0; i < numCells; i++) ownCosts[i].store(INFINITE_COST, std::memory_order_relaxed);
+		resetsDone.fetch_add(1, std::memory_order_acq_rel);
+		while(resetsDone.load(std::memory_order_acquire) < 2) QThread::yieldCurrentThread();
+
+		pRE = ctx.rasterElements + sourceIdx;
+		pRE->g_cost = 0;
+		pRE->f_cost = heuristic(pRE->x, pRE->y, targetX, targetY);
+		pRE->parent = NULL;
+		pRE->list = List_Open;
+		ctx.openListLength = 0;
+		ctx.openListInsert(pRE);
+		ownCosts[sourceIdx].store(0);
+		otherCost = otherCosts[sourceIdx].load() & ~CLOSED;
+		if(otherCost != INFINITE_COST) offerMeeting(otherCost, sourceIdx);
+	}
+
+	int neighbourhood_offsets[8];
+	for(int i = 0; i < 8; i++) neighbourhood_offsets[i] = neighbourhood_dy[i] * width + neighbourhood_dx[i];
+
+	while(!searchDone.load(std::memory_order_relaxed)) {
+		// the budget is checked by the forward search, the backward search stops with it
+		if(direction == Forward && interrupted()) {
+			context.suspended = true;
+			break;
+		}
+		// no path not found yet costs less than the smallest f cost on the open list
+		if(!ctx.openListLength || (unsigned)ctx.openList[1]->f_cost >= (unsigned)(meeting.load() >> 32)) break;
+		pRE = ctx.openListPop();
+		pRE->list = List_Closed;
+		/* a cell the other direction has expanded already has been offered as meeting with both costs final,
+		 * paths through its neighbors cannot be cheaper than the one through the cell (nipping)
+		 */
+		int idx = pRE - ctx.rasterElements;
+		ownCosts[idx].store(pRE->g_cost | CLOSED, std::memory_order_relaxed);
+		if(otherCosts[idx].load(std::memory_order_relaxed) & CLOSED) continue;
+		PLANNER_COUNT(expansions);
+
+		for(int i = 0; i < 8; i++) {
+			int x = pRE->x + neighbourhood_dx[i];
+			int y = pRE->y + neighbourhood_dy[i];
+			if((unsigned)x >= (unsigned)width || (unsigned)y >= (unsigned)height) continue;
+			PLANNER_COUNT(cellsTouched);
+			RasterElement *pNeighbour = pRE + neighbourhood_offsets[i];
+			// closed cells have their final cost, the heuristic is consistent
+			if(pNeighbour->list == List_Closed || pNeighbour->list == List_Unwalkable) continue;
+
+			int g_cost = pRE->g_cost + ((i & 0x01) ? 10 : 14);
+			if(pNeighbour->list != List_Open) {
+				pNeighbour->g_cost = g_cost;
+				pNeighbour->f_cost = g_cost + heuristic(x, y, targetX, targetY);
+				pNeighbour->parent = pRE;
+				pNeighbour->list = List_Open;
+				ctx.openListInsert(pNeighbour);
+			} else if(g_cost < pNeighbour->g_cost) {
+				pNeighbour->f_cost -= pNeighbour->g_cost - g_cost;
+				pNeighbour->g_cost = g_cost;
+				pNeighbour->parent = pRE;
+				ctx.openListDecreaseKey(pNeighbour);
+			} else continue;
+
+			/* publish the cost, then look for the other direction's: as both are sequentially consistent,
+			 * at least one of the directions sees the other's cost of a cell both have reached
+			 */
+			idx = pNeighbour - ctx.rasterElements;
+			ownCosts[idx].store(g_cost);
+			otherCost = otherCosts[idx].load() & ~CLOSED;
+			if(otherCost != INFINITE_COST) offerMeeting(g_cost + otherCost, idx);
+		}
+	}
+	searchDone.store(true);
+}
+
+void BidirectionalAStarPlanner::calculatePath(InputUpdates updates) {
+	if(!context.rasterElements || !backward.rasterElements || !bestCosts[Forward] || !bestCosts[Backward]) {
+		setError("Planner memory allocation error");
+		return;
+	}
+
+	int width = mapWidth();
+	beginPhase(Phase_DebugLayers);
+	// the interrupted search is resumed unless the inputs have changed since
+	resume = context.suspended && !updates;
+	prepareVisitedMap(!resume);
+
+	QPoint goalPos = this->goalPos().toPoint();
+	QPoint startPos = this->startPos().toPoint();
+	goalIdx = goalPos.y() * width + goalPos.x();
+	startIdx = startPos.y() * width + startPos.x();
+	if(occupancy.at(goalIdx)) {
+		setError("Goal position blocked");
+		return;
+	}
+	if(occupancy.at(startIdx)) {
+		setError("Start position blocked");
+		return;
+	}
+
+	// both directions reset their cells before they search, unless an interrupted search is resumed
+	beginPhase(Phase_Search);
+	if(!resume) {
+		meeting.store(NO_MEETING);
+		resetsDone.store(0);
+	}
+	searchDone.store(false);
+	context.suspended = false;
+	searchStarted.release();
+	search(Forward);
+	searchFinished.acquire();
+	_counters += context._counters;
+	_counters += backward._counters;
+
+	Path &path = pathBuffer();
+	uint64_t found = meeting.load();
+	if(!context.suspended && found != NO_MEETING) {
+		// the forward parents lead from the meeting cell to the start, the backward parents to the goal
+		beginPhase(Phase_PathExtraction);
+		int meetingIdx = (int)(found & 0xffffffff);
+		RasterElement *pForward = context.rasterElements + meetingIdx;
+		RasterElement *pBackward = backward.rasterElements + meetingIdx;
+		int forwardLength = 0, backwardLength = 0;
+		for(RasterElement *pRE = pForward; pRE; pRE = pRE->parent) forwardLength++;
+		for(RasterElement *pRE = pBackward->parent; pRE; pRE = pRE->parent) backwardLength++;
+		path.resize(forwardLength + backwardLength);
+		int segmentIndex = forwardLength - 1;
+		for(RasterElement *pRE = pForward; pRE; pRE = pRE->parent) path[segmentIndex--] = QPointF(pRE->x, pRE->y);
+		segmentIndex = forwardLength;
+		for(RasterElement *pRE = pBackward->parent; pRE; pRE = pRE->parent) path[segmentIndex++] = QPointF(pRE->x, pRE->y);
+	} else if(!context.suspended) setError("No Path found");
+
+	beginPhase(Phase_DebugLayers);
+	if(observed()) {
+		// the searches do not report events, the cells reached by either direction are reported afterwards
+		const RasterElement *pForward = context.rasterElements, *pBackward = backward.rasterElements;
+		int height = mapHeight();
+		for(int y = 0; y < height; y++) {
+			for(int x = 0; x < width; x++, pForward++, pBackward++) {
+				if(pForward->list == List_Open || pForward->list == List_Closed || pBackward->list == List_Open ||
+				   pBackward->list == List_Closed) notifyOpened(x, y);
+				if(pForward->list == List_Closed || pBackward->list == List_Closed) {
+					notifyExpanded(x, y);
+					notifyClosed(x, y);
+				}
+			}
+		}
+	}
+
+	setPath(path);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BIDIRECTIONALASTARPLANNER_H
+#define BIDIRECTIONALASTARPLANNER_H
+
+#include "astarplanner.h"
+#include <QSemaphore>
+#include <atomic>
+
+/* Bidirectional A*: a forward search from the start (in the planner's thread) and a backward search from the
+ * goal (in a second thread) on the cells of AStarPlanner. Each search publishes the best known cost of its cells
+ * in an array of atomics, and generating a cell the other search has reached gives a path through that cell.
+ * A search stops as soon as the smallest f cost on its open list is not below the cheapest of these paths: with
+ * the (consistent) octile distance heuristic, every path not found yet costs at least that much, so the
+ * cheapest path is optimal.
+ * The budget of anytime planning is checked by the forward search and counts its expansions only; the backward
+ * search stops with it, and continuePlanning() resumes both.
+ */
+class BidirectionalAStarPlanner: public AStarPlanner {
+public:
+	BidirectionalAStarPlanner(QObject *parent = 0);
+	~BidirectionalAStarPlanner();
+
+	bool isOptimal() const { return true; }
+
+protected:
+	void initMap(const QImage &map, const QRect &updateRegion = QRect());
+	void calculatePath(InputUpdates updates);
+
+private:
+	enum Direction {
+		Forward,
+		Backward
+	};
+	SearchContext backward; // the forward search uses AStarPlanner::context
+	std::atomic<unsigned> *bestCosts[2]; // per cell and direction, INFINITE_COST if not reached
+	void freeBestCosts();
+	void search(Direction direction);
+
+	class BackwardThread;
+	BackwardThread *backwardThread;
+
+	// state of the running search, shared by both directions
+	int startIdx, goalIdx;
+	std::atomic<uint64_t> meeting; // cost (upper 32 bits) and index of the cell of the cheapest path found so far
+	void offerMeeting(unsigned cost, int idx);
+	bool resume; // the running call resumes an interrupted search, set before searchStarted is released
+	std::atomic<bool> searchDone;
+	std::atomic<int> resetsDone;
+	QSemaphore searchStarted, searchFinished;
+};
+
+#endif // BIDIRECTIONALASTARPLANNER_H
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "comparisonwidget.h"
+#include "comparisonworker.h"
+#include "performancewidget.h"
+#include "abstractplanner.h"
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QLabel>
+#include <QVBoxLayout>
+
+enum Column {
+	Column_Time,
+	Column_Expansions,
+	Column_Memory,
+	Column_PathCost,
+	Column_Status,
+	NumColumns
+};
+
+ComparisonWidget::ComparisonWidget(const PlannerFactories &factories, QWidget *parent):
+	QWidget(parent), factories(factories), start(Pose2D::invalid()), goal(Pose2D::invalid())
+{
+	QVBoxLayout *layout = new QVBoxLayout;
+	
+	statusLabel = new QLabel;
+	layout->addWidget(statusLabel);
+	
+	table = new QTableWidget(factories.size(), NumColumns);
+	table->setHorizontalHeaderLabels(QStringList() << tr("Time") << tr("Expanded") << tr("Memory") << tr("Path cost") << tr("Status"));
+	QStringList names;
+	foreach(PlannerFactoryBase *factory, factories) names << factory->name();
+	table->setVerticalHeaderLabels(names);
+	table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	table->setSelectionMode(QAbstractItemView::NoSelection);
+	table->horizontalHeader()->setStretchLastSection(true);
+	for(int row = 0; row < factories.size(); row++) {
+		for(int col = 0; col < NumColumns; col++) {
+			QTableWidgetItem *item = new QTableWidgetItem;
+			item->setTextAlignment((col == Column_Status ? Qt::AlignLeft : Qt::AlignRight) | Qt::AlignVCenter);
+			table->setItem(row, col, item);
+		}
+	}
+	table->horizontalHeaderItem(Column_PathCost)->setToolTip(tr("path cost in cells, diagonal steps cost 1.4"));
+	layout->addWidget(table, 1);
+	
+	setLayout(layout);
+	updateTable();
+}
+
+ComparisonWidget::~ComparisonWidget() {
+	setRunning(false);
+}
+
+void ComparisonWidget::setRunning(bool running) {
+	if(running == isRunning()) return;
+	if(!running) {
+		qDeleteAll(workers);
+		workers.clear();
+		updateTable();
+		return;
+	}
+	
+	foreach(PlannerFactoryBase *factory, factories) {
+		ComparisonWorker *worker = new ComparisonWorker(factory);
+		connect(worker, SIGNAL(resultReady()), this, SLOT(updateTable()));
+		if(!map.isNull()) worker->load(map, start, goal);
+		workers << worker;
+	}
+	updateTable();
+}
+
+void ComparisonWidget::setMap(const QImage &map, const Pose2D &start, const Pose2D &goal) {
+	this->map = map;
+	this->start = start;
+	this->goal = goal;
+	foreach(ComparisonWorker *worker, workers) worker->load(map, start, goal);
+	updateTable();
+}
+
+void ComparisonWidget::setStart(const Pose2D &start) {
+	this->start = start;
+	foreach(ComparisonWorker *worker, workers) worker->setStart(start);
+	updateTable();
+}
+
+void ComparisonWidget::setGoal(const Pose2D &goal) {
+	this->goal = goal;
+	foreach(ComparisonWorker *worker, workers) worker->setGoal(goal);
+	updateTable();
+}
+
+void ComparisonWidget::updateMap(const QImage &map, const QRect &updateRegion) {
+	this->map = map;
+	foreach(ComparisonWorker *worker, workers) worker->updateMap(map, updateRegion);
+	updateTable();
+}
+
+void ComparisonWidget::updateTable() {
+	if(workers.isEmpty()) {
+		statusLabel->setText(tr("stopped"));
+		for(int row = 0; row < table->rowCount(); row++) {
+			for(int col = 0; col < NumColumns; col++) table->item(row, col)->setText(QString());
+		}
+		return;
+	}
+	
+	QList<PlannerBench::Result> results;
+	QList<bool> busy;
+	int64_t minTime = -1;
+	qint64 minCost = -1;
+	int done = 0;
+	foreach(ComparisonWorker *worker, workers) {
+		// busy first: a result read before a finished call would be marked as pending
+		bool workerBusy = worker->isBusy();
+		busy << workerBusy;
+		results << worker->result();
+		if(!workerBusy) done++;
+		const PlannerBench::Result &r = results.last();
+		if(r.timeNs >= 0 && (minTime < 0 || r.timeNs < minTime)) minTime = r.timeNs;
+		if(r.pathCost >= 0 && (minCost < 0 || r.pathCost < minCost)) minCost = r.pathCost;
+	}
+	statusLabel->setText(tr("%1 of %2 planners done").arg(done).arg(workers.size()));
+	
+	for(int row = 0; row < workers.size(); row++) {
+		const PlannerBench::Result &r = results[row];
+		bool called = r.timeNs >= 0;
+		
+		QTableWidgetItem *timeItem = table->item(row, Column_Time);
+		timeItem->setText(called ? PerformanceWidget::formatDuration(r.timeNs) : QString("---"));
+		QFont font = timeItem->font();
+		font.setBold(called && r.timeNs == minTime);
+		timeItem->setFont(font);
+		
+		table->item(row, Column_Expansions)->setText((called && AbstractPlanner::countersEnabled()) ? 
+													 QString::number(r.counters.expansions) : QString("---"));
+		table->item(row, Column_Memory)->setText(called ? PerformanceWidget::formatBytes(r.memoryBytes) : QString("---"));
+		
+		// costs are on the 5/7 scale, see PlannerBench::pathCost()
+		QTableWidgetItem *costItem = table->item(row, Column_PathCost);
+		costItem->setText(r.pathCost >= 0 ? QString::number(r.pathCost / 5.0, 'f', 1) : QString("---"));
+		costItem->setForeground(r.pathCost > minCost ? QBrush(Qt::red) : palette().text());
+		
+		QString status = busy[row] ? tr("planning...") : r.error;
+		if(status.isEmpty() && called && !r.success()) status = tr("no path");
+		table->item(row, Column_Status)->setText(status);
+	}
+}
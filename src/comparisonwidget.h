@@ -0,0 +1,68 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPARISONWIDGET_H
+#define COMPARISONWIDGET_H
+
+#include <QWidget>
+#include <QList>
+#include <QImage>
+#include "data.h"
+#include "plannerfactory.h"
+class QTableWidget;
+class QLabel;
+class ComparisonWorker;
+
+/* Contents of the comparison dock: while running, one instance of every planner plans on its own
+ * worker thread (see ComparisonWorker) with the inputs of the main planner, i.e. the same map,
+ * start, goal and edits. The table shows the time, expansions, memory and path cost of the last call
+ * of each planner; the fastest time is bold, path costs above the cheapest path are red.
+ */
+class ComparisonWidget: public QWidget {
+	Q_OBJECT
+public:
+	ComparisonWidget(const PlannerFactories &factories, QWidget *parent = 0);
+	~ComparisonWidget();
+	
+	bool isRunning() const { return !workers.isEmpty(); }
+	
+public slots:
+	// creates the planners and loads the current inputs, stopping waits for the running planner calls
+	void setRunning(bool running);
+	
+	// the inputs are kept while stopped and passed to the planners when started
+	void setMap(const QImage &map, const Pose2D &start, const Pose2D &goal);
+	void setStart(const Pose2D &start);
+	void setGoal(const Pose2D &goal);
+	void updateMap(const QImage &map, const QRect &updateRegion);
+	
+private slots:
+	void updateTable();
+	
+private:
+	PlannerFactories factories;
+	QList<ComparisonWorker *> workers;
+	
+	QImage map;
+	Pose2D start, goal;
+	
+	QLabel *statusLabel;
+	QTableWidget *table;
+};
+
+#endif // COMPARISONWIDGET_H
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "comparisonworker.h"
+#include "trace.h"
+
+ComparisonWorker::ComparisonWorker(PlannerFactoryBase *factory, QObject *parent):
+	QThread(parent), bench(factory), processing(false), quit(false)
+{
+	start();
+}
+
+ComparisonWorker::~ComparisonWorker() {
+	mutex.lock();
+	inputs.clear();
+	quit = true;
+	inputPosted.wakeOne();
+	mutex.unlock();
+	bench.planner()->cancel();
+	wait();
+}
+
+void ComparisonWorker::load(const QImage &map, const Pose2D &start, const Pose2D &goal) {
+	Input input;
+	input.type = Input_Load;
+	input.map = map;
+	input.start = start;
+	input.goal = goal;
+	post(input);
+}
+
+void ComparisonWorker::setStart(const Pose2D &start) {
+	Input input;
+	input.type = Input_Start;
+	input.start = start;
+	post(input);
+}
+
+void ComparisonWorker::setGoal(const Pose2D &goal) {
+	Input input;
+	input.type = Input_Goal;
+	input.goal = goal;
+	post(input);
+}
+
+void ComparisonWorker::updateMap(const QImage &map, const QRect &updateRegion) {
+	Input input;
+	input.type = Input_Update;
+	input.map = map;
+	input.updateRegion = updateRegion;
+	post(input);
+}
+
+bool ComparisonWorker::isBusy() const {
+	QMutexLocker locker(&mutex);
+	return processing || !inputs.isEmpty();
+}
+
+PlannerBench::Result ComparisonWorker::result() const {
+	QMutexLocker locker(&mutex);
+	return lastResult;
+}
+
+void ComparisonWorker::post(const Input &input) {
+	QMutexLocker locker(&mutex);
+	inputs.append(input);
+	inputPosted.wakeOne();
+}
+
+void ComparisonWorker::run() {
+	Trace::setThreadName("Comparison");
+	mutex.lock();
+	for(;;) {
+		while(inputs.isEmpty() && !quit) inputPosted.wait(&mutex);
+		if(quit) break;
+		Input input = inputs.takeFirst();
+		processing = true;
+		mutex.unlock();
+		
+		PlannerBench::Result r;
+		switch(input.type) {
+			case Input_Load: r = bench.load(input.map, input.start, input.goal); break;
+			case Input_Start: r = bench.setStart(input.start); break;
+			case Input_Goal: r = bench.setGoal(input.goal); break;
+			case Input_Update: r = bench.update(input.map, input.updateRegion); break;
+		}
+		
+		mutex.lock();
+		lastResult = r;
+		processing = false;
+		mutex.unlock();
+		emit resultReady();
+		mutex.lock();
+	}
+	mutex.unlock();
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPARISONWORKER_H
+#define COMPARISONWORKER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <QRect>
+#include <QList>
+#include "data.h"
+#include "plannerbench.h"
+class PlannerFactoryBase;
+
+/* Runs one planner on its own thread for the comparison of all planners (see ComparisonWidget).
+ * Inputs are queued and passed to the planner in order, so workers fed with the same inputs plan on
+ * identical data. The planner is created and deleted by the owning thread, but only called by the worker.
+ */
+class ComparisonWorker: public QThread {
+	Q_OBJECT
+public:
+	ComparisonWorker(PlannerFactoryBase *factory, QObject *parent = 0);
+	// discards pending inputs and cancels the current planner call
+	~ComparisonWorker();
+	
+	const QString &plannerName() const { return bench.plannerName(); }
+	
+	// see PlannerBench, the calls return immediately
+	void load(const QImage &map, const Pose2D &start, const Pose2D &goal);
+	void setStart(const Pose2D &start);
+	void setGoal(const Pose2D &goal);
+	void updateMap(const QImage &map, const QRect &updateRegion);
+	
+	// true while inputs are pending or being processed
+	bool isBusy() const;
+	// result of the last planner call, timeNs < 0 before the first call
+	PlannerBench::Result result() const;
+	
+signals:
+	// emitted by the worker thread after each planner call
+	void resultReady();
+	
+protected:
+	void run();
+	
+private:
+	enum InputType {
+		Input_Load,
+		Input_Start,
+		Input_Goal,
+		Input_Update
+	};
+	struct Input {
+		InputType type;
+		QImage map;
+		QRect updateRegion;
+		Pose2D start, goal;
+	};
+	void post(const Input &input);
+	
+	PlannerBench bench;
+	
+	mutable QMutex mutex;		// guards all members below
+	QWaitCondition inputPosted;
+	QList<Input> inputs;
+	bool processing;
+	bool quit;
+	PlannerBench::Result lastResult;
+};
+
+#endif // COMPARISONWORKER_H
@@ -0,0 +1,335 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "deltastepping.h"
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <QThread>
+
+// frontier cells a worker takes at once, and cells a worker collects before appending them to a list
+#define CHUNK_SIZE		256
+#define BUFFER_SIZE		256
+// times a worker waiting at the barrier yields before it blocks (rounds are short, but several planners may be running)
+#define BARRIER_SPINS	100
+
+static const int neighbor_dx[8] = { -1,  0,  1, -1, -1, 1, 1, 0 };
+static const int neighbor_dy[8] = { -1, -1, -1,  0,  1, 0, 1, 1 };
+
+/* relaxes chunks of the frontier in each round, worker 0 is not started and runs in the thread calling
+ * compute(), the others wait for computeStarted in between
+ */
+class DeltaStepping::Worker: public QThread {
+public:
+	Worker(DeltaStepping *engine, int index): engine(engine), index(index), sameCount(0), nextCount(0) { }
+
+	void compute();
+
+	AbstractPlanner::Counters _counters; // of the last computation, use PLANNER_COUNT() to modify
+
+protected:
+	void run() {
+		while(true) {
+			engine->computeStarted.acquire();
+			if(engine->quitWorkers.load()) return;
+			compute();
+			engine->computeFinished.release();
+		}
+	}
+
+private:
+	DeltaStepping *engine;
+	int index;
+	int sameBuffer[BUFFER_SIZE], nextBuffer[BUFFER_SIZE];
+	int sameCount, nextCount;
+	void relaxNeighbors(int idx, unsigned cost);
+	void append(int idx, unsigned cost);
+	void flush(int *buffer, int &count, int *list, std::atomic<int> &length);
+};
+
+void DeltaStepping::Worker::flush(int *buffer, int &count, int *list, std::atomic<int> &length) {
+	if(!count) return;
+	int pos = length.fetch_add(count, std::memory_order_relaxed);
+	memcpy(list + pos, buffer, count * sizeof(int));
+	count = 0;
+}
+
+// the cell's cost has been lowered, it is appended to the list of its bucket unless it is on it already
+void DeltaStepping::Worker::append(int idx, unsigned cost) {
+	bool same = (cost / engine->diagonalCost == engine->bucket);
+	unsigned stamp = same ? engine->sameBucketStamp : engine->nextBucketStamp;
+	std::atomic<unsigned> &cellStamp = engine->stamps[idx];
+	if(cellStamp.load(std::memory_order_relaxed) == stamp || cellStamp.exchange(stamp, std::memory_order_relaxed) == stamp) return;
+	PLANNER_COUNT(heapInserts);
+	if(same) {
+		sameBuffer[sameCount++] = idx;
+		if(sameCount == BUFFER_SIZE) flush(sameBuffer, sameCount, engine->sameBucket, engine->sameBucketLength);
+	} else {
+		nextBuffer[nextCount++] = idx;
+		if(nextCount == BUFFER_SIZE) flush(nextBuffer, nextCount, engine->nextBucket, engine->nextBucketLength);
+	}
+}
+
+void DeltaStepping::Worker::relaxNeighbors(int idx, unsigned cost) {
+	int width = engine->allocatedSize.width(), height = engine->allocatedSize.height();
+	int x = idx % width, y = idx / width;
+	const char *blocked = engine->occupancy.constData();
+	PLANNER_COUNT(expansions);
+
+	for(int i = 0; i < 8; i++) {
+		int nx = x + neighbor_dx[i], ny = y + neighbor_dy[i];
+		if((unsigned)nx >= (unsigned)width || (unsigned)ny >= (unsigned)height) continue;
+		PLANNER_COUNT(cellsTouched);
+		int neighbor = ny * width + nx;
+		if(blocked[neighbor]) continue;
+		// odd indices are straight moves
+		unsigned newCost = cost + ((i & 1) ? engine->straightCost : engine->diagonalCost);
+		std::atomic<unsigned> &neighborCost = engine->costs[neighbor];
+		unsigned oldCost = neighborCost.load(std::memory_order_relaxed);
+		do {
+			if(newCost >= oldCost) break;
+		} while(!neighborCost.compare_exchange_weak(oldCost, newCost, std::memory_order_relaxed));
+		if(newCost < oldCost) append(neighbor, newCost);
+	}
+}
+
+void DeltaStepping::Worker::compute() {
+	_counters.clear();
+	int numWorkers = engine->numWorkers;
+	int width = engine->allocatedSize.width(), height = engine->allocatedSize.height();
+	int firstRow = height * index / numWorkers, endRow = height * (index + 1) / numWorkers;
+
+	// reset a stripe of the cells, the target has cost 0 and is the first round's frontier
+	for(int idx = firstRow * width; idx < endRow * width; idx++) {
+		engine->costs[idx].store(idx == engine->targetIdx ? 0 : INFINITE_COST, std::memory_order_relaxed);
+		engine->stamps[idx].store(0, std::memory_order_relaxed);
+	}
+	engine->barrier(false);
+
+	while(!engine->finished) {
+		while(true) {
+			int begin = engine->nextChunk.fetch_add(CHUNK_SIZE, std::memory_order_relaxed);
+			if(begin >= engine->frontierLength) break;
+			int end = qMin(begin + CHUNK_SIZE, engine->frontierLength);
+			for(int i = begin; i < end; i++) {
+				int idx = engine->frontier[i];
+				// cells lowered to an earlier bucket after they have been appended have been relaxed there
+				unsigned cost = engine->costs[idx].load(std::memory_order_relaxed);
+				if(cost / engine->diagonalCost == engine->bucket) relaxNeighbors(idx, cost);
+			}
+		}
+		flush(sameBuffer, sameCount, engine->sameBucket, engine->sameBucketLength);
+		flush(nextBuffer, nextCount, engine->nextBucket, engine->nextBucketLength);
+		engine->barrier(true);
+	}
+
+	// the costs are final, find the successors of a stripe of the cells
+	const char *blocked = engine->occupancy.constData();
+	for(int y = firstRow; y < endRow; y++) {
+		for(int x = 0; x < width; x++) {
+			int idx = y * width + x;
+			unsigned bestCost = INFINITE_COST;
+			signed char best = -1;
+			for(int i = 0; i < 8; i++) {
+				int nx = x + neighbor_dx[i], ny = y + neighbor_dy[i];
+				if((unsigned)nx >= (unsigned)width || (unsigned)ny >= (unsigned)height) continue;
+				int neighbor = ny * width + nx;
+				unsigned cost = engine->costs[neighbor].load(std::memory_order_relaxed);
+				if(blocked[neighbor] || cost == INFINITE_COST) continue;
+				cost += (i & 1) ? engine->straightCost : engine->diagonalCost;
+				if(cost < bestCost) {
+					bestCost = cost;
+					best = i;
+				}
+			}
+			engine->successors[idx] = best;
+		}
+	}
+}
+
+DeltaStepping::DeltaStepping(unsigned straightCost, unsigned diagonalCost):
+	straightCost(straightCost),
+	diagonalCost(diagonalCost),
+	costs(NULL),
+	stamps(NULL),
+	successors(NULL),
+	requestedThreads(0),
+	numWorkers(0),
+	workers(NULL),
+	targetIdx(0),
+	bucket(0),
+	frontier(NULL), sameBucket(NULL), nextBucket(NULL),
+	frontierLength(0),
+	nextChunk(0), sameBucketLength(0), nextBucketLength(0),
+	stampCounter(0), sameBucketStamp(0), nextBucketStamp(0),
+	finished(false),
+	arrived(0),
+	generation(0),
+	quitWorkers(false)
+{
+	lists[0] = lists[1] = lists[2] = NULL;
+	for(int i = 0; i < 8; i++) neighborOffsets[i] = 0;
+}
+
+DeltaStepping::~DeltaStepping() {
+	freeMemory();
+}
+
+void DeltaStepping::freeMemory() {
+	if(workers) {
+		quitWorkers.store(true);
+		computeStarted.release(numWorkers - 1);
+		for(int i = 1; i < numWorkers; i++) workers[i]->wait();
+		quitWorkers.store(false);
+		for(int i = 0; i < numWorkers; i++) delete workers[i];
+		delete[] workers;
+	}
+	if(costs) delete[] costs;
+	if(stamps) delete[] stamps;
+	if(successors) delete[] successors;
+	for(int i = 0; i < 3; i++) {
+		if(lists[i]) delete[] lists[i];
+		lists[i] = NULL;
+	}
+	workers = NULL;
+	costs = stamps = NULL;
+	successors = NULL;
+	occupancy.clear();
+	numWorkers = 0;
+	allocatedSize = QSize();
+}
+
+int DeltaStepping::threadCountForMap() const {
+	return (requestedThreads > 0) ? requestedThreads : qMax(QThread::idealThreadCount(), 1);
+}
+
+int64_t DeltaStepping::memoryUsage() const {
+	if(!costs) return 0;
+	int64_t numCells = (int64_t)allocatedSize.width() * allocatedSize.height();
+	return numCells * (2 * sizeof(std::atomic<unsigned>) + sizeof(signed char) + 3 * sizeof(int) + 1) +
+		   numWorkers * sizeof(Worker);
+}
+
+bool DeltaStepping::initMap(const QImage &map, const QRect &updateRegion) {
+	int count = threadCountForMap();
+	bool newMap = (map.size() != allocatedSize || count != numWorkers);
+	if(newMap) {
+		freeMemory();
+		int64_t numCells = (int64_t)map.width() * map.height();
+		costs = new (std::nothrow) std::atomic<unsigned>[numCells];
+		stamps = new (std::nothrow) std::atomic<unsigned>[numCells];
+		successors = new (std::nothrow) signed char[numCells];
+		bool allocated = costs && stamps && successors;
+		for(int i = 0; i < 3; i++) {
+			lists[i] = new (std::nothrow) int[numCells];
+			allocated &= (lists[i] != NULL);
+		}
+		if(!allocated) {
+			printf("Could not allocate cost field memory\n");
+			freeMemory();
+			return false;
+		}
+		numWorkers = count;
+		allocatedSize = map.size();
+		workers = new Worker *[count];
+		for(int i = 0; i < count; i++) {
+			workers[i] = new Worker(this, i);
+			if(i > 0) workers[i]->start();
+		}
+		for(int i = 0; i < 8; i++) neighborOffsets[i] = neighbor_dy[i] * map.width() + neighbor_dx[i];
+	}
+
+	QRect rc = (updateRegion.isNull() || newMap) ? map.rect() : updateRegion.intersected(map.rect());
+	occupancy.resize(map.width() * map.height());
+	char *pBlocked = occupancy.data();
+	for(int y = rc.top(); y <= rc.bottom(); y++) {
+		const unsigned char *pCost = (const unsigned char *)map.scanLine(y) + rc.left();
+		char *pRow = pBlocked + y * map.width() + rc.left();
+		for(int x = 0; x < rc.width(); x++) *pRow++ = (*pCost++ > 0);
+	}
+	return true;
+}
+
+/* waits for all workers; the last one to arrive sets up the next round if the round has ended, the barrier's
+ * release and acquire make its changes and the workers' list appends visible to all workers. Waiting workers
+ * yield for a while, then block on barrierPassed; the generation is advanced under barrierMutex so that no
+ * wakeup is lost.
+ */
+void DeltaStepping::barrier(bool endOfRound) {
+	unsigned gen = generation.load(std::memory_order_acquire);
+	if(arrived.fetch_add(1, std::memory_order_acq_rel) == numWorkers - 1) {
+		arrived.store(0, std::memory_order_relaxed);
+		if(endOfRound) endRound();
+		barrierMutex.lock();
+		generation.store(gen + 1, std::memory_order_release);
+		barrierMutex.unlock();
+		barrierPassed.wakeAll();
+	} else {
+		for(int i = 0; i < BARRIER_SPINS; i++) {
+			if(generation.load(std::memory_order_acquire) != gen) return;
+			QThread::yieldCurrentThread();
+		}
+		QMutexLocker locker(&barrierMutex);
+		while(generation.load(std::memory_order_acquire) == gen) barrierPassed.wait(&barrierMutex);
+	}
+}
+
+// the cells lowered into the current bucket are relaxed in the next round, then the next bucket's cells
+void DeltaStepping::endRound() {
+	int *done = frontier;
+	if(sameBucketLength.load(std::memory_order_relaxed)) {
+		frontier = sameBucket;
+		frontierLength = sameBucketLength.load(std::memory_order_relaxed);
+		sameBucket = done;
+	} else if(nextBucketLength.load(std::memory_order_relaxed)) {
+		frontier = nextBucket;
+		frontierLength = nextBucketLength.load(std::memory_order_relaxed);
+		nextBucket = done;
+		nextBucketLength.store(0, std::memory_order_relaxed);
+		nextBucketStamp = ++stampCounter;
+		bucket++;
+	} else finished = true;
+	sameBucketLength.store(0, std::memory_order_relaxed);
+	sameBucketStamp = ++stampCounter;
+	nextChunk.store(0, std::memory_order_relaxed);
+}
+
+void DeltaStepping::compute(int targetIdx) {
+	if(!costs) return;
+	this->targetIdx = targetIdx;
+	bucket = 0;
+	frontier = lists[0];
+	sameBucket = lists[1];
+	nextBucket = lists[2];
+	frontier[0] = targetIdx;
+	frontierLength = 1;
+	nextChunk.store(0);
+	sameBucketLength.store(0);
+	nextBucketLength.store(0);
+	// the workers reset the stamps to 0
+	stampCounter = 2;
+	sameBucketStamp = 1;
+	nextBucketStamp = 2;
+	finished = false;
+
+	computeStarted.release(numWorkers - 1);
+	workers[0]->compute();
+	computeFinished.acquire(numWorkers - 1);
+	_counters.clear();
+	for(int i = 0; i < numWorkers; i++) _counters += workers[i]->_counters;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DELTASTEPPING_H
+#define DELTASTEPPING_H
+
+#include "abstractplanner.h"
+#include <QImage>
+#include <QByteArray>
+#include <QSemaphore>
+#include <QMutex>
+#include <QWaitCondition>
+#include <climits>
+#include <atomic>
+
+/* Parallel delta-stepping (Meyer & Sanders) on the 8-connected grid: computes the cost of the cheapest path from
+ * every cell to a target cell, the cost field the D* planners otherwise build one heap pop at a time. The cells
+ * are kept in buckets of width delta by their cost. The worker threads relax the cells of the current bucket in
+ * rounds until no cell falls into it any more, then the next bucket is taken up. With delta = diagonal cost, a
+ * move ends in the current or the next bucket, so two bucket lists suffice. Moves into and out of blocked cells
+ * are not allowed, diagonal moves past blocked corners are (as in the planners).
+ */
+class DeltaStepping {
+public:
+	DeltaStepping(unsigned straightCost, unsigned diagonalCost);
+	~DeltaStepping();
+
+	// number of worker threads (0: QThread::idealThreadCount()), takes effect with the next map
+	void setThreadCount(int count) { requestedThreads = count; }
+	int threadCount() const { return numWorkers; }
+	int threadCountForMap() const; // the number of threads the next initMap() of a new map sets up
+
+	// takes the blocked cells (value > 0) of the map or of its update region, returns false if allocating failed
+	bool initMap(const QImage &map, const QRect &updateRegion = QRect());
+	bool isAllocated() const { return costs != NULL; }
+	void freeMemory(); // frees the cells and stops the worker threads, until the next initMap()
+	int64_t memoryUsage() const;
+
+	// computes the costs to the target cell (index y * width + x, must not be blocked), does not allocate
+	void compute(int targetIdx);
+	// cost of the cheapest path from the cell to the target, INFINITE_COST if there is none
+	static const unsigned INFINITE_COST = UINT_MAX;
+	unsigned cost(int idx) const { return costs[idx].load(std::memory_order_relaxed); }
+	// the neighbor the cheapest path from the cell continues with, -1 if there is none; set for blocked cells as well
+	int successor(int idx) const { return successors[idx] < 0 ? -1 : idx + neighborOffsets[(int)successors[idx]]; }
+
+	// work of the last compute(), summed over the threads
+	const AbstractPlanner::Counters &counters() const { return _counters; }
+
+private:
+	class Worker;
+
+	unsigned straightCost, diagonalCost; // delta is the diagonal cost
+	QSize allocatedSize;
+	QByteArray occupancy; // 1 for blocked cells, row by row
+	std::atomic<unsigned> *costs;
+	std::atomic<unsigned> *stamps; // the list a cell has been appended to last, no list holds a cell twice
+	signed char *successors; // index into the neighbor offsets
+	int *lists[3]; // one cell index per cell each
+	int neighborOffsets[8];
+	int requestedThreads;
+	int numWorkers;
+	Worker **workers; // workers[0] runs in the calling thread, the others in their own threads
+	AbstractPlanner::Counters _counters;
+
+	/* state of the running computation: the workers take chunks of the frontier (the current round's cells) and
+	 * append to the lists of the next round and of the next bucket; the last worker to finish a round sets up
+	 * the next one
+	 */
+	int targetIdx;
+	unsigned bucket;
+	int *frontier, *sameBucket, *nextBucket;
+	int frontierLength;
+	std::atomic<int> nextChunk, sameBucketLength, nextBucketLength;
+	unsigned stampCounter, sameBucketStamp, nextBucketStamp;
+	bool finished;
+	void endRound();
+	void barrier(bool endOfRound);
+	std::atomic<int> arrived;
+	std::atomic<unsigned> generation;
+	QMutex barrierMutex;
+	QWaitCondition barrierPassed;
+	std::atomic<bool> quitWorkers;
+	QSemaphore computeStarted, computeFinished;
+};
+
+#endif // DELTASTEPPING_H
@@ -17,6 +17,7 @@
  */
 
 #include "dstarliteplanner.h"
+#include "trace.h"
 #include <new>
 #include <climits>
 #include <cstdio>
@@ -30,11 +31,15 @@
 
 DStarLitePlanner::DStarLitePlanner(QObject *parent):
 	AbstractPlanner(parent),
-	cells(NULL), openHeap(NULL), openListLength(0),
+	cells(NULL), pGoal(NULL), pStart(NULL), pRobot(NULL),
+	costField(5, 7),
+	openHeap(NULL), openListLength(0),
 	listLayer(NULL), costLayer(NULL), backPtrs(NULL),
+	touchedObserver(listMap, DebugImageObserver::Expanded, 1),
 	inhibitStep(false),
 	saveStateCounter(-1) // set to -1 to disable state saving
 {
+	setSearchLayerObserver(&touchedObserver);
 	singleSteppingAction = new QAction(tr("Stepping"), this);
 	singleSteppingAction->setCheckable(true);
 	addAction(singleSteppingAction);
@@ -45,6 +50,15 @@ DStarLitePlanner::DStarLitePlanner(QObject *parent):
 	connect(singleSteppingAction, SIGNAL(toggled(bool)), singleStepGroup, SLOT(setEnabled(bool)));
 	connect(singleSteppingAction, SIGNAL(toggled(bool)), this, SLOT(singleSteppingToggled(bool)));
 	
+	for(int i = 100000; i >= 1; i /= 10) {
+		bool kFlag = (i > 1000);
+		QAction *stepAction = new QAction(QString(tr(kFlag ? "-%1k" : "-%1")).arg(kFlag ? i / 1000 : i), this);
+		stepAction->setToolTip(tr("Scrub back through the recorded steps"));
+		singleStepGroup->addAction(stepAction);
+		connect(stepAction, SIGNAL(triggered(bool)), steppingMapper, SLOT(map()));
+		steppingMapper->setMapping(stepAction, -i);
+		addAction(stepAction);
+	}
 	for(int i = 1; i <= 100000; i *= 10) {
 		bool kFlag = (i > 1000);
 		QAction *stepAction = new QAction(QString(tr(kFlag ? "%1k" : "%1")).arg(kFlag ? i / 1000 : i), this);
@@ -65,6 +79,11 @@ DStarLitePlanner::DStarLitePlanner(QObject *parent):
 DStarLitePlanner::~DStarLitePlanner() {
 	freeData();
 }
+
+const QVector<QRgb> &DStarLitePlanner::listColors() {
+	static const QVector<QRgb> colors = QVector<QRgb>() << qRgba(0, 0, 0, 0) << qRgba(255, 255, 0, 192) << qRgba(255, 128, 0, 192) << qRgba(0, 255, 255, 192) << qRgba(255, 0, 255, 192) << qRgb(0, 200, 0);
+	return colors;
+}
 	
 void DStarLitePlanner::freeData() {
 	if(cells) {
@@ -75,6 +94,10 @@ void DStarLitePlanner::freeData() {
 		delete[] openHeap;
 		openHeap = NULL;
 	}	
+	stepHistory.reset(NULL, NULL, 0);
+	setMemoryUsage(Memory_Cells, 0);
+	setMemoryUsage(Memory_OpenList, 0);
+	setMemoryUsage(Memory_StepHistory, 0);
 }
 	
 void DStarLitePlanner::initMap(const QImage &map, const QRect &updateRegion) {
@@ -86,12 +109,21 @@ void DStarLitePlanner::initMap(const QImage &map, const QRect &updateRegion) {
 		cells = new (std::nothrow) Cell[map.width() * map.height()];
 		openHeap = new (std::nothrow) Cell *[map.width() * map.height() + 1];
 		openListLength = 0;
+		pGoal = pStart = pRobot = NULL;
+		stepHistory.reset(cells, openHeap, map.width() * map.height());
 		listMap = QImage();
+		setMemoryUsage(Memory_DebugImages, 0);
 		
 		if(!cells || !openHeap) {
 			printf("Failed allocating runtime memory\n");
 			return;
 		}		
+		// on a single core, seeding from the cost field is slower than the search towards the start
+		if(costField.threadCountForMap() > 1) costField.initMap(map);
+		else costField.freeMemory();
+		setMemoryUsage(Memory_Cells, (int64_t)map.width() * map.height() * sizeof(Cell));
+		setMemoryUsage(Memory_CostField, costField.memoryUsage());
+		setMemoryUsage(Memory_OpenList, ((int64_t)map.width() * map.height() + 1) * sizeof(Cell *));
 		
 		// initialized cells and neighborhood patterns
 		Cell *pCell = cells;
@@ -134,9 +166,15 @@ void DStarLitePlanner::initMap(const QImage &map, const QRect &updateRegion) {
 				}
 			}
 		}
+		int64_t tableBytes = neighborhoods.capacity() * sizeof(Neighborhood);
+		for(unsigned i = 0; i < neighborhoods.size(); i++) tableBytes += neighborhoods[i].capacity() * sizeof(NeighborSpec);
+		setMemoryUsage(Memory_Tables, tableBytes);
 		
 	} else {
 		// It's a map update: incorporate cost changes
+		stepHistory.clear();
+		updateStepHistoryUsage();
+		if(costField.isAllocated()) costField.initMap(map, updateRegion);
 		for(int y = updateRegion.top(); y <= updateRegion.bottom(); y++) {
 			const unsigned char *pCost = (const unsigned char *)map.scanLine(y) + updateRegion.left();
 			Cell *pCell = cells + w * y + updateRegion.left();
@@ -147,7 +185,9 @@ void DStarLitePlanner::initMap(const QImage &map, const QRect &updateRegion) {
 					
 					pCell->blocked = newBlocked;
 					const Neighborhood &neighborhood = neighborhoods.at(pCell->neighborhoodIndex);					
-					if(pCell->blocked) {
+					if(!pStart) {
+						// nothing searched on this map yet, the next call starts from scratch
+					} else if(pCell->blocked) {
 						/*printf("New blocked cell (%u, %u)\n", pCell->x, pCell->y);
 						for(unsigned i = 1; i < neighborhood.size(); i++) {							
 							Cell *pNeighbor = pCell + neighborhood[i].ptrOffset;
@@ -238,7 +278,8 @@ void DStarLitePlanner::initMap(const QImage &map, const QRect &updateRegion) {
 	}
 }
 
-bool DStarLitePlanner::computeShortestPath(unsigned maxSteps) {
+template<bool Observed> bool DStarLitePlanner::computeShortestPath(unsigned maxSteps) {
+	TRACE_SCOPE("computeShortestPath");
 	bool complete = true;
 	// make sure the start key is initialized
 	//pStart->key = pStart->calculateKey(*pStart, k_m);
@@ -251,31 +292,40 @@ bool DStarLitePlanner::computeShortestPath(unsigned maxSteps) {
 		unsigned k2Start = qMin(pStart->g_cost, pStart->rhs);		
 		if(!(pCell->key < Key(k2Start + k_m, k2Start) || pStart->rhs > pStart->g_cost)) break;
 
-		if(maxSteps && (++step > maxSteps)) {
+		if((maxSteps && (++step > maxSteps)) || interrupted()) {
 			complete = false;
 			break;
 		}
 		
 		// remove first element
-		listMap.setPixel(pCell->x, pCell->y, 1);
+		PLANNER_COUNT(expansions);
+		if(Observed) {
+			notifyExpanded(pCell->x, pCell->y);
+			if(maxSteps) stepHistory.beginStep(openListLength);
+			stepHistory.save(pCell);
+		}
 		
 		Key correctKey = pCell->calculateKey(*pStart, k_m);
 		if(pCell->key < correctKey) {
 			pCell->key = correctKey;
-			insert(*pCell);
+			if(Observed) notifyKeyUpdated(pCell->x, pCell->y);
+			insert<Observed>(*pCell);
 		} else if(pCell->g_cost > pCell->rhs) {
 			pCell->g_cost = pCell->rhs;
-			remove(*pCell);
+			if(Observed) notifyClosed(pCell->x, pCell->y);
+			remove<Observed>(*pCell);
 			if(!pCell->blocked) { // should not happen
 				const Neighborhood &neighborhood = neighborhoods.at(pCell->neighborhoodIndex);
 				for(unsigned i = 1; i < neighborhood.size(); i++) {				
 					Cell *pNeighbor = pCell + neighborhood[i].ptrOffset;
+					PLANNER_COUNT(cellsTouched);
 					if(pNeighbor->blocked || pNeighbor == pGoal) continue;
 					unsigned newCost = pCell->g_cost;
 					if(newCost < OBSTACLE_COST) newCost += neighborhood[i].baseCost;
 					if(pNeighbor->rhs > newCost) {
+						if(Observed) stepHistory.save(pNeighbor);
 						pNeighbor->rhs = newCost;					
-						updateVertex(pNeighbor);
+						updateVertex<Observed>(pNeighbor);
 					}
 				}
 			}
@@ -320,6 +370,7 @@ bool DStarLitePlanner::computeShortestPath(unsigned maxSteps) {
 			
 			for(unsigned i = 0; i < neighborhood.size(); i++) {
 				Cell *pNeighbor = pCell + neighborhood[i].ptrOffset;
+				PLANNER_COUNT(cellsTouched);
 				if(pNeighbor->blocked || pNeighbor == pGoal) continue;
 
 				unsigned testCost = g_old;
@@ -335,29 +386,66 @@ bool DStarLitePlanner::computeShortestPath(unsigned maxSteps) {
 						if(rhs < OBSTACLE_COST) rhs += neighborhood2[j].baseCost;
 						if(rhs < newRhs) newRhs = rhs;
 					}
+					if(Observed) stepHistory.save(pNeighbor);
 					pNeighbor->rhs = newRhs;
 				}				   
-				updateVertex(pNeighbor);				
+				updateVertex<Observed>(pNeighbor);				
 			}
 		}
+		if(Observed) stepHistory.endStep(openListLength);
 	}	
 	
 	return complete;
 }
 
 void DStarLitePlanner::singleSteppingToggled(bool enabled) {
+	// enabling takes effect with the next call; a running call started with stepping enabled is a single step
 	if(!enabled) {
+		QMutexLocker locker(dataMutex());
 		doCalculatePath(0, 0);	
 		emit dataChanged();
 	}
 }
 
 void DStarLitePlanner::doSteps(int max) {
-	doCalculatePath(0, max);
+	// waiting for a running background call would block the GUI, the steps are dropped instead
+	if(!dataMutex()->tryLock()) return;
+	if(!cells || !openHeap) {
+		dataMutex()->unlock();
+		return;
+	}
+	
+	// recorded steps are replayed from the step history, further steps are computed and recorded
+	unsigned steps = 0;
+	if(max < 0) steps = stepHistory.stepBack(-max, openListLength);
+	else steps = stepHistory.stepForward(max, openListLength);
+	
+	if(max > 0 && steps < (unsigned)max) {
+		doCalculatePath(0, max - steps);
+	} else {
+		// the list map is redrawn from the restored cells: touched are the cells with a finite g or rhs
+		pathBuffer().resize(0);
+		listMap.fill(0);
+		unsigned w = mapWidth();
+		unsigned h = mapHeight();
+		const Cell *pCell = cells;
+		for(unsigned y = 0; y < h; y++) {
+			unsigned char *pMap = listMap.scanLine(y);
+			for(unsigned x = 0; x < w; x++, pCell++) *pMap++ = (pCell->g_cost < OBSTACLE_COST || pCell->rhs < OBSTACLE_COST);
+		}
+		doDebugAndPathExtract(false);
+		setError("Step %u (recorded steps %u - %u)", stepHistory.position(), stepHistory.firstStep(), stepHistory.lastStep());
+	}
+	updateStepHistoryUsage();
+	dataMutex()->unlock();
 	// Inform GUI for redrawing
 	emit dataChanged();
 }
 
+void DStarLitePlanner::updateStepHistoryUsage() {
+	setMemoryUsage(Memory_StepHistory, stepHistory.memoryUsage());
+}
+
 void DStarLitePlanner::calculatePath(InputUpdates updates) {	
 	inhibitStep = singleSteppingAction->isChecked();			
 	doCalculatePath(updates, inhibitStep);	
@@ -373,9 +461,11 @@ void DStarLitePlanner::doCalculatePath(InputUpdates updates, unsigned maxSteps)
 	unsigned w = mapWidth();
 	unsigned h = mapHeight();
 
+	beginPhase(Phase_DebugLayers);
 	if(listMap.size() != mapSize()) {
 		listMap = QImage(mapSize(), QImage::Format_Indexed8);
-		listMap.setColorTable(QVector<QRgb>() << qRgba(0, 0, 0, 0) << qRgba(255, 255, 0, 192) << qRgba(255, 128, 0, 192) << qRgba(0, 255, 255, 192) << qRgba(255, 0, 255, 192) << qRgb(0, 200, 0));
+		listMap.setColorTable(listColors());
+		setMemoryUsage(Memory_DebugImages, listMap.byteCount());
 	}
 	listMap.fill(0);
 			
@@ -385,16 +475,25 @@ void DStarLitePlanner::doCalculatePath(InputUpdates updates, unsigned maxSteps)
 	pGoal = cells + (int)goalPos.y() * w + (int)goalPos.x();
 
 	// check validity of start & goal
-	if(pStart->blocked) {
-		setError("Start position blocked");
-		return;
-	} else if(pGoal->blocked) {
-		setError("Goal position blocked");
+	if(pStart->blocked || pGoal->blocked) {
+		setError("%s position blocked", pStart->blocked ? "Start" : "Goal");
+		keepInputUpdates();
+		if(isFullReplan(updates)) pStart = NULL; // no search state yet which map updates could be repaired on
 		return;
 	}
 	
+	// the steps are recorded while stepping only, any other call invalidates them
+	if(updates || !maxSteps) {
+		stepHistory.clear();
+		updateStepHistoryUsage();
+	}
+	stepHistory.setBudget(stepHistoryBudget());
+	
 	// if reusing knowledge from previous calls is not possible, (re-)initialize planner state
-	if(updates & ~(UpdatedStart | UpdatedMap)) {
+	beginPhase(Phase_Reset);
+	// stepping and budgeted calls search incrementally, the cost field (allocated on more than one core) is computed in one go
+	bool seed = isFullReplan(updates) && !maxSteps && !timeBudgetNs() && !expansionBudget() && costField.isAllocated();
+	if(isFullReplan(updates) && !seed) {
 		Cell *pEnd = cells + w * h;
 		Cell *pCell = cells;	
 		while(pCell != pEnd) {
@@ -414,6 +513,8 @@ void DStarLitePlanner::doCalculatePath(InputUpdates updates, unsigned maxSteps)
 	}
 
 	bool success = true;
+	beginPhase(Phase_Search);
+	if(seed) seedFromCostField();
 	if(inhibitStep) {
 		inhibitStep = false;
 		setError("Single stepping enabled...");
@@ -424,33 +525,52 @@ void DStarLitePlanner::doCalculatePath(InputUpdates updates, unsigned maxSteps)
 			pRobot = pStart;
 		}
 		// compute path
-		success = computeShortestPath(maxSteps);
+		success = (observed() || maxSteps) ? computeShortestPath<true>(maxSteps) : computeShortestPath<false>(maxSteps);
 	}
 	
 	// prepare debug layers
 	doDebugAndPathExtract(success);
 }
 
+// the cost field is what computeShortestPath() would converge to, all cells are consistent and the heap is empty
+void DStarLitePlanner::seedFromCostField() {
+	costField.compute(pGoal - cells);
+	_counters += costField.counters();
+	
+	k_m = 0;
+	pRobot = pStart;
+	openListLength = 0;
+	int numCells = mapWidth() * mapHeight();
+	for(int idx = 0; idx < numCells; idx++) {
+		unsigned cost = costField.cost(idx);
+		cells[idx].heapIndex = 0;
+		cells[idx].rhs = cells[idx].g_cost = (cost != DeltaStepping::INFINITE_COST) ? cost : OBSTACLE_COST;
+	}
+}
+
 void DStarLitePlanner::doDebugAndPathExtract(bool pathExtract) {
 	unsigned h = mapHeight();
 	unsigned w = mapWidth();
 	
-	const Cell *pCell = cells;
-	for(unsigned y = 0; y < h; y++) {
-		unsigned char *pMap = listMap.scanLine(y);
-		for(unsigned x = 0; x < w; x++) {
-			if(pCell->heapIndex > 0) {
-				if(pCell->g_cost != pCell->rhs) *pMap = 4;
-				else *pMap = 3;
-			} else if(*pMap > 0) {
-				if(pCell->g_cost != pCell->rhs) *pMap = 2;
-				else *pMap = 1;
+	beginPhase(Phase_DebugLayers);
+	if(!budgetExhausted()) {
+		const Cell *pCell = cells;
+		for(unsigned y = 0; y < h; y++) {
+			unsigned char *pMap = listMap.scanLine(y);
+			for(unsigned x = 0; x < w; x++) {
+				if(pCell->heapIndex > 0) {
+					if(pCell->g_cost != pCell->rhs) *pMap = 4;
+					else *pMap = 3;
+				} else if(*pMap > 0) {
+					if(pCell->g_cost != pCell->rhs) *pMap = 2;
+					else *pMap = 1;
+				}
+				pMap++;
+				pCell++;
 			}
-			pMap++;
-			pCell++;
 		}
+		if(openListLength >= 1) listMap.setPixel(openHeap[1]->x, openHeap[1]->y, 5);
 	}
-	if(openListLength >= 1) listMap.setPixel(openHeap[1]->x, openHeap[1]->y, 5);
 	if(!listLayer) addDebugLayer(listLayer = new DebugLayer(tr("Lists (cyan = open, yellow = touched)")));
 	if(!backPtrs) {
 		addDebugLayer(backPtrs = new DebugLayer(tr("Backpointers"), 1));
@@ -462,6 +582,7 @@ void DStarLitePlanner::doDebugAndPathExtract(bool pathExtract) {
 	}
 	
 	if (pathExtract) {
+		beginPhase(Phase_PathExtraction);
 		if(saveStateCounter >= 0) {
 			QString fileName;
 			fileName.sprintf("dstarlite%05u.bin", saveStateCounter++);
@@ -470,7 +591,8 @@ void DStarLitePlanner::doDebugAndPathExtract(bool pathExtract) {
 		
 		// extract path
 		if(pStart->rhs < OBSTACLE_COST) {
-			Path p;
+			Path &p = pathBuffer();
+			p.resize(0);
 			Cell *pCell = pStart;
 			bool success = true;
 			unsigned pathLength = 0;
@@ -507,24 +629,39 @@ void DStarLitePlanner::doDebugAndPathExtract(bool pathExtract) {
 			}
 			
 			if(success) setPath(p);
+			else p.resize(0);
 		} else setError("No Path found");
 	}
 }
 
-void DStarLitePlanner::updateVertex(Cell *pCell) {
+template<bool Observed> void DStarLitePlanner::updateVertex(Cell *pCell) {
+	PLANNER_COUNT(updateVertexCalls);
 	if(pCell->g_cost != pCell->rhs) {
+		if(Observed) {
+			if(pCell->heapIndex) notifyKeyUpdated(pCell->x, pCell->y);
+			else notifyOpened(pCell->x, pCell->y);
+			stepHistory.save(pCell);
+		}
 		pCell->key = pCell->calculateKey(*pStart, k_m);
-		insert(*pCell);		
-	} else remove(*pCell);	
+		insert<Observed>(*pCell);		
+	} else {
+		if(Observed && pCell->heapIndex) notifyClosed(pCell->x, pCell->y);
+		remove<Observed>(*pCell);	
+	}
 }
 
 // move element to the beginning of the heap (lower key values) as far as possible
-void DStarLitePlanner::heapUp(Cell &cell) {
+template<bool Observed> void DStarLitePlanner::heapUp(Cell &cell) {
 	if(!cell.heapIndex) return;
 	unsigned idx = cell.heapIndex;
 	while(idx != 1) {
 		unsigned parentIdx = idx >> 1;
 		if(openHeap[idx]->key < openHeap[parentIdx]->key) {
+			PLANNER_COUNT(heapUpSwaps);
+			if(Observed) {
+				stepHistory.save(openHeap[parentIdx]);
+				stepHistory.save(openHeap[idx]);
+			}
 			Cell *temp = openHeap[parentIdx];
 			openHeap[parentIdx] = openHeap[idx];
 			openHeap[idx] = temp;
@@ -536,7 +673,7 @@ void DStarLitePlanner::heapUp(Cell &cell) {
 }
 
 // move element away from the beginning of the heap (to higher key values) as far as possible
-void DStarLitePlanner::heapDown(Cell &cell) {		
+template<bool Observed> void DStarLitePlanner::heapDown(Cell &cell) {		
 	if(!cell.heapIndex) return;
 	
 	unsigned idx = cell.heapIndex;
@@ -553,6 +690,11 @@ void DStarLitePlanner::heapDown(Cell &cell) {
 		}
 			
 		if(origIdx == idx) break;		
+		PLANNER_COUNT(heapDownSwaps);
+		if(Observed) {
+			stepHistory.save(openHeap[idx]);
+			stepHistory.save(openHeap[origIdx]);
+		}
 		Cell *temp = openHeap[idx];
 		openHeap[idx] = openHeap[origIdx];
 		openHeap[origIdx] = temp;
@@ -563,32 +705,42 @@ void DStarLitePlanner::heapDown(Cell &cell) {
 
 
 
-void DStarLitePlanner::insert(Cell &cell) {
+template<bool Observed> void DStarLitePlanner::insert(Cell &cell) {
 	if(cell.heapIndex) { 
 		// update position in heap
-		heapDown(cell);
-		heapUp(cell);
+		PLANNER_COUNT(decreaseKeys);
+		heapDown<Observed>(cell);
+		heapUp<Observed>(cell);
 	} else { 
 		// insert element
+		PLANNER_COUNT(heapInserts);
+		if(Observed) stepHistory.save(&cell);
 		openListLength++;
 		openHeap[openListLength] = &cell;
 		cell.heapIndex = openListLength;
-		heapUp(cell);
+		heapUp<Observed>(cell);
 	}
 }
-void DStarLitePlanner::remove(Cell &cell) {
+template<bool Observed> void DStarLitePlanner::remove(Cell &cell) {
 	if(!cell.heapIndex) return;
 
 	Cell *lastCell = openHeap[openListLength--];
+	if(Observed) {
+		stepHistory.save(&cell);
+		stepHistory.save(lastCell);
+	}
 	if(openListLength) {
 		unsigned idx = cell.heapIndex;		
 		openHeap[idx] = lastCell;
 		lastCell->heapIndex = idx;		
-		heapUp(*lastCell);
-		heapDown(*lastCell);
+		heapUp<Observed>(*lastCell);
+		heapDown<Observed>(*lastCell);
 	}	
 	cell.heapIndex = 0;		
 }
+// the kernel benchmarks call insert() and remove() directly
+template void DStarLitePlanner::insert<false>(Cell &cell);
+template void DStarLitePlanner::remove<false>(Cell &cell);
 
 void DStarLitePlanner::checkHeap() const {
 	if(openListLength < 1) return;
@@ -818,8 +970,11 @@ void DStarLitePlanner::loadState(const QString &filename) {
 	if(file.open(QIODevice::ReadOnly)) {
 		if(file.size() == (sizeof(Cell) * mapWidth() * mapHeight())) {
 			saveStateCounter = -1;
+			stepHistory.clear();
+			updateStepHistoryUsage();
 			
 			file.read((char *)cells, sizeof(Cell) * mapWidth() * mapHeight());
+			if(costField.isAllocated()) costField.initMap(map()); // the blocked cells may differ from the planner's map
 			Cell *pCell = cells;
 			const Cell *pCellEnd = cells + mapWidth() * mapHeight();
 			openListLength = 0;			
@@ -834,7 +989,8 @@ void DStarLitePlanner::loadState(const QString &filename) {
 			
 			if(listMap.size() != mapSize()) {
 				listMap = QImage(mapSize(), QImage::Format_Indexed8);
-				listMap.setColorTable(QVector<QRgb>() << qRgba(0, 0, 0, 0) << qRgba(255, 255, 0, 192) << qRgba(255, 128, 0, 192) << qRgba(0, 255, 255, 192) << qRgba(255, 0, 255, 192) << qRgb(0, 200, 0));
+				listMap.setColorTable(listColors());
+				setMemoryUsage(Memory_DebugImages, listMap.byteCount());
 			}
 			listMap.fill(0);		
 			
@@ -847,9 +1003,11 @@ void DStarLitePlanner::loadState(const QString &filename) {
 }
 
 void DStarLitePlanner::loadState() {
+	QMutexLocker locker(dataMutex());
 	loadState("dumps/dstarlite00000.bin");	
 }
 void DStarLitePlanner::loadMapState() {
+	QMutexLocker locker(dataMutex());
 	loadMapFromState("dumps/dstarlite00001.bin");
 }
 
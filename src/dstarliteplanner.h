@@ -20,6 +20,8 @@
 #define DSTARLITEPLANNER_H
 
 #include "abstractplanner.h"
+#include "stephistory.h"
+#include "deltastepping.h"
 #include <vector>
 #include <cstdio>
 #include <QImage>
@@ -44,13 +46,14 @@ protected:
 	QString cellDetails(const QPoint &pos);
 
 private slots:
-	void doSteps(int max);
+	void doSteps(int max); // negative: scrub back through the recorded steps
 	void singleSteppingToggled(bool);
 
 	void loadState();
 	void loadMapState();	
 		
 private:
+	friend class PlannerMicrobench; // kernel benchmarks
 	
 	// core D* Lite runtime data
 	struct Key {
@@ -98,8 +101,8 @@ private:
 	
 	// D* Lite core functions
 	void doCalculatePath(InputUpdates updates, unsigned maxSteps = 0);
-	bool computeShortestPath(unsigned maxSteps = 0); // returns true if plan is complete
-	void updateVertex(Cell *c);
+	template<bool Observed> bool computeShortestPath(unsigned maxSteps); // returns true if plan is complete
+	template<bool Observed = false> void updateVertex(Cell *c);
 	static inline unsigned h_cost(const Cell &c1, const Cell &c2) {
 		unsigned dx = abs(c1.x - c2.x);
 		unsigned dy = abs(c1.y - c2.y);
@@ -109,15 +112,19 @@ private:
 	}	
 	void doDebugAndPathExtract(bool pathExtract);
 	void freeData();
+	
+	// first plans after a new map or goal start from the cost field to the goal
+	DeltaStepping costField;
+	void seedFromCostField();
 
 	// heap management and debugging
 	Cell **openHeap;
 	unsigned openListLength;
 
-	void insert(Cell &cell);
-	void remove(Cell &cell);
-	void heapUp(Cell &cell);
-	void heapDown(Cell &cell);
+	template<bool Observed = false> void insert(Cell &cell);
+	template<bool Observed = false> void remove(Cell &cell);
+	template<bool Observed> void heapUp(Cell &cell);
+	template<bool Observed> void heapDown(Cell &cell);
 	void dumpHeap(unsigned mark = 0) const;
 	void dumpHeapLayer(unsigned index, unsigned level, unsigned mark = 0) const;	
 	void checkHeap() const;
@@ -127,12 +134,18 @@ private:
 	DebugLayer *listLayer;
 	DebugLayer *costLayer, *backPtrs;
 	QImage listMap;
+	static const QVector<QRgb> &listColors();
+	DebugImageObserver touchedObserver; // marks expanded cells in listMap
 	
 	// single stepping
 	QAction *singleSteppingAction;
 	QActionGroup *singleStepGroup;	
 	bool inhibitStep;	
 	
+	// steps taken while stepping, recorded by the observed instantiations of the search functions
+	StepHistory<Cell> stepHistory;
+	void updateStepHistoryUsage();
+	
 	// stuff for saving & loading state
 	QAction *loadStateAction;
 	QAction *loadMapAction;
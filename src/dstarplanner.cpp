@@ -27,6 +27,7 @@
 DStarPlanner::DStarPlanner(QObject *parent):
 	AbstractPlanner(parent),
 	cells(NULL), openHeap(NULL), openListLength(0),
+	costField(10, 14),
 	listLayer(NULL), backPtrLayer(NULL),
 	inhibitStep(false)
 {
@@ -37,8 +38,14 @@ DStarPlanner::DStarPlanner(QObject *parent):
 	connect(singleSteppingAction, SIGNAL(toggled(bool)), singleStepAction, SLOT(setEnabled(bool)));
 	connect(singleSteppingAction, SIGNAL(toggled(bool)), this, SLOT(singleSteppingToggled(bool)));
 	singleStepAction->setEnabled(singleSteppingAction->isChecked());
+	stepBackAction = new QAction(tr("Previous Step"), this);
+	stepBackAction->setToolTip(tr("Scrub back through the recorded steps"));
+	connect(stepBackAction, SIGNAL(triggered(bool)), this, SLOT(doStepBack()));
+	connect(singleSteppingAction, SIGNAL(toggled(bool)), stepBackAction, SLOT(setEnabled(bool)));
+	stepBackAction->setEnabled(singleSteppingAction->isChecked());
 	
 	addAction(singleSteppingAction);
+	addAction(stepBackAction);
 	addAction(singleStepAction);	
 }
 
@@ -55,6 +62,10 @@ void DStarPlanner::freeData() {
 		delete[] openHeap;
 		openHeap = NULL;
 	}	
+	stepHistory.reset(NULL, NULL, 0);
+	setMemoryUsage(Memory_Cells, 0);
+	setMemoryUsage(Memory_OpenList, 0);
+	setMemoryUsage(Memory_StepHistory, 0);
 }
 
 
@@ -65,12 +76,18 @@ void DStarPlanner::initMap(const QImage &map, const QRect &updateRegion) {
 		cells = new (std::nothrow) Cell[map.width() * map.height()];
 		openHeap = new (std::nothrow) Cell *[map.width() * map.height() + 1];
 		openListLength = 0;
+		stepHistory.reset(cells, openHeap, map.width() * map.height());
 		listMap = QImage();
+		setMemoryUsage(Memory_DebugImages, 0);
 		
 		if(!cells || !openHeap) {
 			printf("Failed allocating runtime memory\n");
 			return;
 		}		
+		costField.initMap(map);
+		setMemoryUsage(Memory_Cells, (int64_t)map.width() * map.height() * sizeof(Cell));
+		setMemoryUsage(Memory_CostField, costField.memoryUsage());
+		setMemoryUsage(Memory_OpenList, ((int64_t)map.width() * map.height() + 1) * sizeof(Cell *));
 		
 		Cell *pCell = cells;
 		for(int y = 0; y < mapHeight(); y++) {
@@ -89,6 +106,9 @@ void DStarPlanner::initMap(const QImage &map, const QRect &updateRegion) {
 	} else {
 		// It's a map update: incorporate cost changes
 		// --> This implements MODIFY-COST from the Pseudo-Code in Stentz' Paper
+		stepHistory.clear();
+		setMemoryUsage(Memory_StepHistory, 0);
+		if(costField.isAllocated()) costField.initMap(map, updateRegion);
 
 		for(int y = updateRegion.top(); y <= updateRegion.bottom(); y++) {
 			const unsigned char *pCost = (const unsigned char *)map.scanLine(y) + updateRegion.left();
@@ -124,18 +144,38 @@ void DStarPlanner::initMap(const QImage &map, const QRect &updateRegion) {
 }
 
 void DStarPlanner::singleSteppingToggled(bool enabled) {
+	// enabling takes effect with the next call; a running call started with stepping enabled is a single step
 	if(!enabled) {
+		QMutexLocker locker(dataMutex());
 		doCalculatePath(0, false);	
 		emit dataChanged();
 	}
 }
 
 void DStarPlanner::doSingleStep() {
-	doCalculatePath(0, true);
+	// waiting for a running background call would block the GUI, the step is dropped instead
+	if(!dataMutex()->tryLock()) return;
+	// replay the next recorded step after scrubbing back, compute and record a new step otherwise
+	if(stepHistory.stepForward(1, openListLength)) showRecordedStep();
+	else doCalculatePath(0, true);
+	dataMutex()->unlock();
 	// Inform GUI for redrawing
 	emit dataChanged();
 }
 
+void DStarPlanner::doStepBack() {
+	if(!dataMutex()->tryLock()) return;
+	if(stepHistory.stepBack(1, openListLength)) showRecordedStep();
+	dataMutex()->unlock();
+	emit dataChanged();
+}
+
+void DStarPlanner::showRecordedStep() {
+	pathBuffer().resize(0);
+	updateListMap();
+	setError("Step %u (recorded steps %u - %u)", stepHistory.position(), stepHistory.firstStep(), stepHistory.lastStep());
+}
+
 void DStarPlanner::calculatePath(InputUpdates updates) {
 	inhibitStep = singleSteppingAction->isChecked();			
 	doCalculatePath(updates, inhibitStep);
@@ -150,9 +190,12 @@ void DStarPlanner::doCalculatePath(InputUpdates updates, bool singleStep) {
 	unsigned width = mapWidth();
 	unsigned height = mapHeight();
 	// prepare image that shows list membership (size & color table)
+	beginPhase(Phase_DebugLayers);
 	if(listMap.size() != mapSize()) {
 		listMap = QImage(mapSize(), QImage::Format_Indexed8);
-		listMap.setColorTable(QVector<QRgb>() << qRgba(0, 0, 0, 0) << qRgba(0, 255, 255, 192) << qRgba(255, 255, 0, 128) << qRgba(255, 192, 0, 192) << qRgb(0, 200, 0));
+		static const QVector<QRgb> colors = QVector<QRgb>() << qRgba(0, 0, 0, 0) << qRgba(0, 255, 255, 192) << qRgba(255, 255, 0, 128) << qRgba(255, 192, 0, 192) << qRgb(0, 200, 0);
+		listMap.setColorTable(colors);
+		setMemoryUsage(Memory_DebugImages, listMap.byteCount());
 	}
 	
 	QPoint startPos = start().pos().toPoint();
@@ -163,14 +206,23 @@ void DStarPlanner::doCalculatePath(InputUpdates updates, bool singleStep) {
 	// check validity of start & goal
 	if(pStart->blocked) {
 		setError("Start position blocked");
+		keepInputUpdates();
 		return;
 	} else if(pGoal->blocked) {
 		setError("Goal position blocked");
+		keepInputUpdates();
 		return;
 	}
 
+	// the steps are recorded while single stepping only, any other call invalidates them
+	if(updates || !singleStep) stepHistory.clear();
+	stepHistory.setBudget(stepHistoryBudget());
+	
 	// if reusing knowledge from previous calls is not possible, (re-)initialize planner state
-	if(updates & ~(UpdatedStart | UpdatedMap)) {
+	beginPhase(Phase_Reset);
+	// single stepping and budgeted calls search incrementally, the cost field is computed in one go
+	bool seed = isFullReplan(updates) && !singleStep && !timeBudgetNs() && !expansionBudget() && costField.isAllocated();
+	if(isFullReplan(updates) && !seed) {
 		
 		for(Cell *pCell = cells; pCell < (cells + width * height); pCell++) {
 			pCell->list = List_New;
@@ -187,6 +239,8 @@ void DStarPlanner::doCalculatePath(InputUpdates updates, bool singleStep) {
 	}
 	
 	bool success = true;
+	beginPhase(Phase_Search);
+	if(seed) seedFromCostField(pGoal);
 	
 	// processState loop		
 	if(inhibitStep) {
@@ -195,11 +249,18 @@ void DStarPlanner::doCalculatePath(InputUpdates updates, bool singleStep) {
 		success = false;
 	} else {	
 		unsigned kMin = getKMin();
+		bool observed = this->observed() || singleStep;
 		if(pStart->list == List_New || kMin < pStart->h_cost) {
 			do {				
-				kMin = processState(false);	
+				if(singleStep) stepHistory.beginStep(openListLength);
+				kMin = observed ? processState<true>(false) : processState<false>(false);	
+				stepHistory.endStep(openListLength);
 				
 				if(pStart->list != List_New && kMin >= pStart->h_cost) break;
+				if(interrupted()) {
+					success = false;
+					break;
+				}
 				
 				if(kMin >= OBSTACLE_COST) {
 					setError("No Path found");
@@ -222,28 +283,21 @@ void DStarPlanner::doCalculatePath(InputUpdates updates, bool singleStep) {
 		}
 	}
 
+	setMemoryUsage(Memory_StepHistory, stepHistory.memoryUsage());
+
 	// prepare debug layers
-	const Cell *pCell = cells;
-	for(unsigned y = 0; y < height; y++) {
-		unsigned char *pMap = listMap.scanLine(y);
-		for(unsigned x = 0; x < width; x++) {
-			switch(pCell->list) {
-			case List_Closed: *pMap++ = 2; break;
-			case List_Open: *pMap++ = pCell->k_cost >= OBSTACLE_COST ? 3 : 1; break;
-			default: *pMap++ = 0;
-			}
-			pCell++;
-		}
-	}
-	if(openListLength >= 1) listMap.setPixel(openHeap[1]->x, openHeap[1]->y, 4);
+	beginPhase(Phase_DebugLayers);
+	if(!budgetExhausted()) updateListMap();
 	
 	if(!listLayer) addDebugLayer(listLayer = new DebugLayer(tr("Lists (cyan = open, yellow = closed)")));
 	if(!backPtrLayer) addDebugLayer(backPtrLayer = new DebugLayer(tr("Backpointers"), 0));	
-	Path p;
+	Path &p = pathBuffer();
+	p.resize(0);
 	
 	
 	if(success) {
 		// follow the backpointers to construct the path
+		beginPhase(Phase_PathExtraction);
 		Cell *pCell = pStart;
 		
 		int pathLength = 0;	
@@ -289,20 +343,72 @@ void DStarPlanner::doCalculatePath(InputUpdates updates, bool singleStep) {
 	setPath(p);
 }
 
+/* sets up the state a search from the goal leaves behind when it has run until only cells at OBSTACLE_COST are
+ * open: the cells with a path to the goal are closed with their final costs, the blocked cells next to them are
+ * open at OBSTACLE_COST, all other cells are new
+ */
+void DStarPlanner::seedFromCostField(Cell *pGoal) {
+	costField.compute(pGoal - cells);
+	_counters += costField.counters();
+	
+	openListLength = 0;
+	int numCells = mapWidth() * mapHeight();
+	for(int idx = 0; idx < numCells; idx++) {
+		Cell *pCell = cells + idx;
+		int successor = costField.successor(idx);
+		unsigned cost = costField.cost(idx);
+		pCell->heapIndex = 0;
+		pCell->backPtr = (successor >= 0 && pCell != pGoal) ? cells + successor : NULL;
+		if(cost != DeltaStepping::INFINITE_COST) {
+			pCell->h_cost = pCell->k_cost = cost;
+			pCell->list = List_Closed;
+		} else {
+			pCell->h_cost = 0;
+			pCell->list = List_New;
+			if(pCell->blocked && pCell->backPtr) insert(pCell, OBSTACLE_COST);
+			else pCell->backPtr = NULL;
+		}
+	}
+}
+
+void DStarPlanner::updateListMap() {
+	const Cell *pCell = cells;
+	for(int y = 0; y < mapHeight(); y++) {
+		unsigned char *pMap = listMap.scanLine(y);
+		for(int x = 0; x < mapWidth(); x++) {
+			switch(pCell->list) {
+			case List_Closed: *pMap++ = 2; break;
+			case List_Open: *pMap++ = pCell->k_cost >= OBSTACLE_COST ? 3 : 1; break;
+			default: *pMap++ = 0;
+			}
+			pCell++;
+		}
+	}
+	if(openListLength >= 1) listMap.setPixel(openHeap[1]->x, openHeap[1]->y, 4);
+}
+
 // Heart of the DStar planner, implemented according to the pseudocode in the A. Stentz' ICRA'94 paper
 
-unsigned DStarPlanner::processState(bool singleStep) {
+template<bool Observed> unsigned DStarPlanner::processState(bool singleStep) {
+	PLANNER_COUNT(processStateCalls);
 	// error if open list is empty
 	if(openListLength < 1) return OBSTACLE_COST;
 	
 	// remove first entry from the open list
+	PLANNER_COUNT(expansions);
 	Cell *pMin = openHeap[1];
+	if(Observed) {
+		notifyExpanded(pMin->x, pMin->y);
+		notifyClosed(pMin->x, pMin->y);
+		stepHistory.save(pMin);
+		stepHistory.save(openHeap[openListLength]);
+	}
 	pMin->list = List_Closed;
 	pMin->heapIndex = 0;	
 	if(--openListLength){
 		openHeap[1] = openHeap[openListLength + 1]; //move the last item in the heap up to slot #1
 		openHeap[1]->heapIndex = 1;
-		heapDown(openHeap[1]);
+		heapDown<Observed>(openHeap[1]);
 	}		
 	unsigned oldKMin = pMin->k_cost;
 	if(singleStep) printf("### processState for (%d, %d), h_cost = %u, oldKMin = k_cost = %u ###\n", pMin->x, pMin->y, pMin->h_cost, oldKMin);	
@@ -315,6 +421,7 @@ unsigned DStarPlanner::processState(bool singleStep) {
 			if(y == pMin->y && x == pMin->x) continue;
 			if((unsigned)y >= (unsigned)mapHeight() || (unsigned)x >= (unsigned)mapWidth()) continue;			
 			Cell *pNeighbor = cells + y * mapWidth() + x;
+			PLANNER_COUNT(cellsTouched);
 			pNeighbors[numNeighbors] = pNeighbor;
 			if(pNeighbor->blocked || pMin->blocked) c_cost[numNeighbors] = OBSTACLE_COST;
 			else c_cost[numNeighbors] = (x != pMin->x && y != pMin->y) ? 14 : 10;
@@ -344,8 +451,9 @@ unsigned DStarPlanner::processState(bool singleStep) {
 			if(neighborHCost < OBSTACLE_COST) neighborHCost += pMin->h_cost;			
 			if(pNeighbor->list == List_New || (pNeighbor->h_cost > neighborHCost) ||
 			   (pNeighbor->backPtr == pMin && pNeighbor->h_cost != neighborHCost)) {				   
+				if(Observed) stepHistory.save(pNeighbor);
 				pNeighbor->backPtr = pMin;
-				insert(pNeighbor, neighborHCost);				
+				insert<Observed>(pNeighbor, neighborHCost);				
 			}			
 		}
 	} else {
@@ -356,16 +464,17 @@ unsigned DStarPlanner::processState(bool singleStep) {
 			
 			if(pNeighbor->list == List_New ||
 			   (pNeighbor->backPtr == pMin && pNeighbor->h_cost != neighborHCost)) {
+				if(Observed) stepHistory.save(pNeighbor);
 				pNeighbor->backPtr = pMin;
-				insert(pNeighbor, neighborHCost);				
+				insert<Observed>(pNeighbor, neighborHCost);				
 			} else if(pNeighbor->backPtr != pMin) {
 				if(pNeighbor->h_cost > neighborHCost) {
-					insert(pMin, pMin->h_cost);										
+					insert<Observed>(pMin, pMin->h_cost);										
 				} else {
 					unsigned hCost = c_cost[i];
 					if(hCost < OBSTACLE_COST) hCost += pNeighbor->h_cost;
 					if(pMin->h_cost > hCost && pNeighbor->list == List_Closed && pNeighbor->h_cost > oldKMin) {
-						insert(pNeighbor, pNeighbor->h_cost);
+						insert<Observed>(pNeighbor, pNeighbor->h_cost);
 					}
 				}
 			}
@@ -374,6 +483,8 @@ unsigned DStarPlanner::processState(bool singleStep) {
 	
 	return getKMin();
 }
+// the kernel benchmarks call processState() directly
+template unsigned DStarPlanner::processState<false>(bool singleStep);
 
 unsigned DStarPlanner::getKMin() const {
 	if(openListLength == 0) return OBSTACLE_COST;
@@ -381,12 +492,17 @@ unsigned DStarPlanner::getKMin() const {
 }
 
 // move element to the beginning of the heap (lower key values) as far as possible
-void DStarPlanner::heapUp(Cell *pCell) {
+template<bool Observed> void DStarPlanner::heapUp(Cell *pCell) {
 	if(pCell->list != List_Open) return;
 	unsigned idx = pCell->heapIndex;
 	while(idx != 1) {
 		unsigned parentIdx = idx >> 1;
 		if(openHeap[idx]->k_cost < openHeap[parentIdx]->k_cost) {
+			PLANNER_COUNT(heapUpSwaps);
+			if(Observed) {
+				stepHistory.save(openHeap[parentIdx]);
+				stepHistory.save(openHeap[idx]);
+			}
 			Cell *temp = openHeap[parentIdx];
 			openHeap[parentIdx] = openHeap[idx];
 			openHeap[idx] = temp;
@@ -398,7 +514,7 @@ void DStarPlanner::heapUp(Cell *pCell) {
 }
 
 // move element away from the beginning of the heap (to higher key values) as far as possible
-void DStarPlanner::heapDown(Cell *pCell) {
+template<bool Observed> void DStarPlanner::heapDown(Cell *pCell) {
 	if(pCell->list != List_Open) return;
 		
 	unsigned idx = pCell->heapIndex;
@@ -415,6 +531,11 @@ void DStarPlanner::heapDown(Cell *pCell) {
 		}
 		
 		if(origIdx != idx) {
+			PLANNER_COUNT(heapDownSwaps);
+			if(Observed) {
+				stepHistory.save(openHeap[idx]);
+				stepHistory.save(openHeap[origIdx]);
+			}
 			Cell *temp = openHeap[idx];
 			openHeap[idx] = openHeap[origIdx];
 			openHeap[origIdx] = temp;
@@ -424,12 +545,15 @@ void DStarPlanner::heapDown(Cell *pCell) {
 	}
 }
 
-void DStarPlanner::insert(Cell *pCell, unsigned h_cost) {
+template<bool Observed> void DStarPlanner::insert(Cell *pCell, unsigned h_cost) {
+	if(Observed) stepHistory.save(pCell);
 	if(pCell->list == List_Open) {
+		PLANNER_COUNT(decreaseKeys);
+		if(Observed) notifyKeyUpdated(pCell->x, pCell->y);
 		if(h_cost < pCell->k_cost) pCell->k_cost = h_cost;
 		pCell->h_cost = h_cost;
-		heapUp(pCell);
-		heapDown(pCell);
+		heapUp<Observed>(pCell);
+		heapDown<Observed>(pCell);
 	} else {
 		if(pCell->list == List_New) pCell->h_cost = pCell->k_cost = h_cost;
 		else {
@@ -437,12 +561,14 @@ void DStarPlanner::insert(Cell *pCell, unsigned h_cost) {
 			pCell->h_cost = h_cost;
 		}
 		// insert element
+		PLANNER_COUNT(heapInserts);
+		if(Observed) notifyOpened(pCell->x, pCell->y);
 		int idx = ++openListLength;
 		openHeap[idx] = pCell;
 		pCell->heapIndex = idx;
 		pCell->list = List_Open;		
 		pCell->k_cost = qMin(pCell->k_cost, h_cost);
-		heapUp(pCell);
+		heapUp<Observed>(pCell);
 	}	
 }
 void DStarPlanner::dumpCell(const Cell *pCell) {
@@ -20,6 +20,8 @@
 #define DSTARPLANNER_H
 
 #include "abstractplanner.h"
+#include "stephistory.h"
+#include "deltastepping.h"
 #include <QSize>
 #include <QImage>
 
@@ -39,9 +41,11 @@ protected:
 
 private slots:
 	void doSingleStep();
+	void doStepBack();
 	void singleSteppingToggled(bool);
 
 private:
+	friend class PlannerMicrobench; // kernel benchmarks
 	void doCalculatePath(InputUpdates updates, bool singleStep = false);
 	
 	enum ListType {
@@ -61,12 +65,16 @@ private:
 	Cell **openHeap;
 	unsigned openListLength;
 	
+	// first plans after a new map or goal start from the cost field to the goal
+	DeltaStepping costField;
+	void seedFromCostField(Cell *pGoal);
+	
 	void freeData();
-	unsigned processState(bool singleStep);
+	template<bool Observed> unsigned processState(bool singleStep);
 	unsigned getKMin() const;
-	void insert(Cell *pCell, unsigned h_cost);
-	void heapUp(Cell *pCell);
-	void heapDown(Cell *pCell);
+	template<bool Observed = false> void insert(Cell *pCell, unsigned h_cost);
+	template<bool Observed> void heapUp(Cell *pCell);
+	template<bool Observed> void heapDown(Cell *pCell);
 	void dumpCell(const Cell *pCell);
 	void dumpOpenHeap() const;
 	void dumpOpenHeapLayer(unsigned index, unsigned level) const;
@@ -74,11 +82,17 @@ private:
 	DebugLayer *listLayer;
 	DebugLayer *backPtrLayer;
 	QImage listMap;
+	void updateListMap();
 	
 	QAction *singleSteppingAction;
 	QAction *singleStepAction;
+	QAction *stepBackAction;
 	
 	bool inhibitStep;
+	
+	// steps taken while single stepping, recorded by the observed instantiation of processState()
+	StepHistory<Cell> stepHistory;
+	void showRecordedStep();
 
 };
 
@@ -27,6 +27,8 @@
 FocussedDStarPlanner::FocussedDStarPlanner(QObject *parent):
 	AbstractPlanner(parent),
 	cells(NULL), openHeap(NULL), openListLength(0),
+	initialSearch(false),
+	costField(5, 7),
 	listLayer(NULL), backPtrLayer(NULL),
 	_fullInit(false), inhibitStep(false)
 {
@@ -55,6 +57,8 @@ void FocussedDStarPlanner::freeData() {
 		delete[] openHeap;
 		openHeap = NULL;
 	}
+	setMemoryUsage(Memory_Cells, 0);
+	setMemoryUsage(Memory_OpenList, 0);
 }
 
 void FocussedDStarPlanner::initMap(const QImage &map, const QRect &updateRegion) {	
@@ -64,11 +68,18 @@ void FocussedDStarPlanner::initMap(const QImage &map, const QRect &updateRegion)
 		openHeap = new (std::nothrow) Cell *[map.width() * map.height() + 1];
 		openListLength = 0;
 		listMap = QImage();
+		setMemoryUsage(Memory_DebugImages, 0);
 		
 		if(!cells || !openHeap) {
 			printf("Failed allocating runtime memory\n");
 			return;
 		}		
+		// only the search with full init is seeded from the cost field
+		if(_fullInit) costField.initMap(map);
+		else costField.freeMemory();
+		setMemoryUsage(Memory_Cells, (int64_t)map.width() * map.height() * sizeof(Cell));
+		setMemoryUsage(Memory_CostField, costField.memoryUsage());
+		setMemoryUsage(Memory_OpenList, ((int64_t)map.width() * map.height() + 1) * sizeof(Cell *));
 		
 		Cell *pCell = cells;
 		for(int y = 0; y < mapHeight(); y++) {
@@ -87,6 +98,7 @@ void FocussedDStarPlanner::initMap(const QImage &map, const QRect &updateRegion)
 		}	
 	} else {
 		// It's a map update: incorporate cost changes
+		if(costField.isAllocated()) costField.initMap(map, updateRegion);
 		int w = mapWidth();
 		int h = mapHeight();
 		for(int y = updateRegion.top(); y <= updateRegion.bottom(); y++) {
@@ -120,14 +132,19 @@ void FocussedDStarPlanner::initMap(const QImage &map, const QRect &updateRegion)
 }
 
 void FocussedDStarPlanner::singleSteppingToggled(bool enabled) {
+	// enabling takes effect with the next call; a running call started with stepping enabled is a single step
 	if(!enabled) {
+		QMutexLocker locker(dataMutex());
 		doCalculatePath(0, false);	
 		emit dataChanged();
 	}
 }
 
 void FocussedDStarPlanner::doSingleStep() {
+	// waiting for a running background call would block the GUI, the step is dropped instead
+	if(!dataMutex()->tryLock()) return;
 	doCalculatePath(0, true);
+	dataMutex()->unlock();
 	// Inform GUI for redrawing
 	emit dataChanged();
 }
@@ -147,9 +164,12 @@ void FocussedDStarPlanner::doCalculatePath(InputUpdates updates, bool singleStep
 	unsigned width = mapWidth();
 	unsigned height = mapHeight();
 	// prepare image that shows list membership (size & color table)
+	beginPhase(Phase_DebugLayers);
 	if(listMap.size() != mapSize()) {
 		listMap = QImage(mapSize(), QImage::Format_Indexed8);
-		listMap.setColorTable(QVector<QRgb>() << qRgba(0, 0, 0, 0) << qRgba(0, 255, 255, 192) << qRgba(255, 255, 0, 192) << qRgba(0, 128, 255, 128) << qRgba(255, 200, 0, 128) << qRgb(0, 200, 0));
+		static const QVector<QRgb> colors = QVector<QRgb>() << qRgba(0, 0, 0, 0) << qRgba(0, 255, 255, 192) << qRgba(255, 255, 0, 192) << qRgba(0, 128, 255, 128) << qRgba(255, 200, 0, 128) << qRgb(0, 200, 0);
+		listMap.setColorTable(colors);
+		setMemoryUsage(Memory_DebugImages, listMap.byteCount());
 	}
 	
 	QPoint startPos = start().pos().toPoint();
@@ -160,14 +180,20 @@ void FocussedDStarPlanner::doCalculatePath(InputUpdates updates, bool singleStep
 	// check validity of start & goal
 	if(pStart->blocked) {
 		setError("Start position blocked");
+		keepInputUpdates();
 		return;
 	} else if(pGoal->blocked) {
 		setError("Goal position blocked");
+		keepInputUpdates();
 		return;
 	}
 
 	// if reusing knowledge from previous calls is not possible, (re-)initialize planner state
-	if(updates & ~(UpdatedStart | UpdatedMap)) {
+	beginPhase(Phase_Reset);
+	// the full init. is computed in one go unless single stepping or budgeted calls are to interrupt it
+	bool seed = isFullReplan(updates) && _fullInit && !singleStep && !timeBudgetNs() && !expansionBudget() &&
+				costField.isAllocated();
+	if(isFullReplan(updates) && !seed) {
 		for(Cell *pCell = cells; pCell < (cells + width * height); pCell++) {
 			pCell->list = List_New;
 			pCell->backPtr = NULL;
@@ -177,6 +203,7 @@ void FocussedDStarPlanner::doCalculatePath(InputUpdates updates, bool singleStep
 
 		pRobot = pStart;
 		d_curr = 0;
+		initialSearch = true;
 		
 		openListLength = 1;
 		pGoal->fB_cost = pGoal->f_cost = pGoal->h_cost = pGoal->k_cost = 0;
@@ -186,17 +213,27 @@ void FocussedDStarPlanner::doCalculatePath(InputUpdates updates, bool singleStep
 	}
 	
 	bool success = true;
+	beginPhase(Phase_Search);
+	if(seed) seedFromCostField(pStart, pGoal);
 	if(inhibitStep) {
 		inhibitStep = false;
 		setError("Single stepping enabled...");
 		success = false;
 	} else {	
-		if(updates & (NewMap | UpdatedGoal)) {
+		bool observed = this->observed();
+		// an interrupted initial search is resumed as such unless the robot has moved in between
+		if(initialSearch && pStart == pRobot) {
+			initialSearch = false;
 			while(true) {
-				Cost val = processState(singleStep);
+				Cost val = observed ? processState<true>(singleStep) : processState<false>(singleStep);
 				if(!_fullInit && pStart->list == List_Closed) break;
 				if(openListLength == 0) break;
 				if(val.c2 >= OBSTACLE_COST) break; // no error handling here since pStart is checked for valid costs after the loop
+				if(interrupted()) {
+					initialSearch = true;
+					success = false;
+					break;
+				}
 				if(singleStep) {
 					success = false;
 					setError("Not yet ready...");
@@ -209,6 +246,7 @@ void FocussedDStarPlanner::doCalculatePath(InputUpdates updates, bool singleStep
 			}
 			
 		} else {			
+			initialSearch = false;
 			if(pStart != pRobot) {
 				d_curr += dist(*pStart, *pRobot) + 1;			
 				pRobot = pStart;	
@@ -217,9 +255,13 @@ void FocussedDStarPlanner::doCalculatePath(InputUpdates updates, bool singleStep
 			Cost val = getMinVal();
 			if(pStart->list == List_New || val < getCost(*pStart)) {
 				while(openListLength > 0) {
-					val = processState(singleStep);
+					val = observed ? processState<true>(singleStep) : processState<false>(singleStep);
 					
 					if(pStart->list != List_New && getCost(*pStart) <= val) break;
+					if(interrupted()) {
+						success = false;
+						break;
+					}
 					
 					if(val.c2 >= OBSTACLE_COST) {
 						setError("No Path found");
@@ -242,26 +284,31 @@ void FocussedDStarPlanner::doCalculatePath(InputUpdates updates, bool singleStep
 	}
 	
 	// prepare debug layers
-	const Cell *pCell = cells;
-	for(unsigned y = 0; y < height; y++) {
-		unsigned char *pMap = listMap.scanLine(y);
-		for(unsigned x = 0; x < width; x++) {
-			switch(pCell->list) {
-			case List_Closed: *pMap++ = (pCell->pFocus == pRobot) ? 2 : 4; break;
-			case List_Open: *pMap++ = (pCell->pFocus == pRobot) ? 1 : 3; break;
-			default: *pMap++ = 0;
+	beginPhase(Phase_DebugLayers);
+	if(!budgetExhausted()) {
+		const Cell *pCell = cells;
+		for(unsigned y = 0; y < height; y++) {
+			unsigned char *pMap = listMap.scanLine(y);
+			for(unsigned x = 0; x < width; x++) {
+				switch(pCell->list) {
+				case List_Closed: *pMap++ = (pCell->pFocus == pRobot) ? 2 : 4; break;
+				case List_Open: *pMap++ = (pCell->pFocus == pRobot) ? 1 : 3; break;
+				default: *pMap++ = 0;
+				}
+				pCell++;
 			}
-			pCell++;
 		}
+		if(openListLength >= 1) listMap.setPixel(openHeap[1]->x, openHeap[1]->y, 5);
 	}
-	if(openListLength >= 1) listMap.setPixel(openHeap[1]->x, openHeap[1]->y, 5);
 	
 	if(!listLayer) addDebugLayer(listLayer = new DebugLayer(tr("Lists (cyan = open, yellow = closed)")));
 	if(!backPtrLayer) addDebugLayer(backPtrLayer = new DebugLayer(tr("Backpointers"), 0));
-	Path p;
+	Path &p = pathBuffer();
+	p.resize(0);
 	
 	if(success) {
 		// follow the backpointers to construct the path
+		beginPhase(Phase_PathExtraction);
 		Cell *pCell = pStart;
 		
 		int pathLength = 0;	
@@ -307,6 +354,37 @@ void FocussedDStarPlanner::doCalculatePath(InputUpdates updates, bool singleStep
 	setPath(p);	
 }
 
+/* sets up the state the initial search with full init. leaves behind: the cells with a path to the goal are
+ * closed with their final costs, the blocked cells next to them are open at OBSTACLE_COST, all other cells are new
+ */
+void FocussedDStarPlanner::seedFromCostField(Cell *pStart, Cell *pGoal) {
+	costField.compute(pGoal - cells);
+	_counters += costField.counters();
+	
+	pRobot = pStart;
+	d_curr = 0;
+	initialSearch = false;
+	openListLength = 0;
+	int numCells = mapWidth() * mapHeight();
+	for(int idx = 0; idx < numCells; idx++) {
+		Cell *pCell = cells + idx;
+		int successor = costField.successor(idx);
+		unsigned cost = costField.cost(idx);
+		pCell->heapIndex = 0;
+		pCell->pFocus = pRobot;
+		pCell->backPtr = (successor >= 0 && pCell != pGoal) ? cells + successor : NULL;
+		if(cost != DeltaStepping::INFINITE_COST) {
+			pCell->h_cost = pCell->k_cost = cost;
+			pCell->list = List_Closed;
+		} else {
+			pCell->h_cost = 0;
+			pCell->list = List_New;
+			if(pCell->blocked && pCell->backPtr) insert(*pCell, OBSTACLE_COST);
+			else pCell->backPtr = NULL;
+		}
+	}
+}
+
 FocussedDStarPlanner::Cell *FocussedDStarPlanner::getMinState() {
 	if(openListLength > 0) {
 		while(true) {
@@ -330,12 +408,18 @@ FocussedDStarPlanner::Cost FocussedDStarPlanner::getMinVal() {
 	else return Cost();
 }
 
-FocussedDStarPlanner::Cost FocussedDStarPlanner::processState(bool singleStep) {
+template<bool Observed> FocussedDStarPlanner::Cost FocussedDStarPlanner::processState(bool singleStep) {
+	PLANNER_COUNT(processStateCalls);
 	Cell *pMin = getMinState();
 	// error if open list is empty
 	if(!pMin) return Cost();
 	
 	// remove first entry from the open list
+	PLANNER_COUNT(expansions);
+	if(Observed) {
+		notifyExpanded(pMin->x, pMin->y);
+		notifyClosed(pMin->x, pMin->y);
+	}
 	pMin->list = List_Closed;
 	pMin->heapIndex = 0;	
 	if(--openListLength){
@@ -355,6 +439,7 @@ FocussedDStarPlanner::Cost FocussedDStarPlanner::processState(bool singleStep) {
 			if(y == pMin->y && x == pMin->x) continue;
 			if((unsigned)y >= (unsigned)mapHeight() || (unsigned)x >= (unsigned)mapWidth()) continue;			
 			Cell *pNeighbor = cells + y * mapWidth() + x;
+			PLANNER_COUNT(cellsTouched);
 			pNeighbors[numNeighbors] = pNeighbor;
 			if(pNeighbor->blocked || pMin->blocked) c_cost[numNeighbors] = OBSTACLE_COST;
 			else c_cost[numNeighbors] = (x != pMin->x && y != pMin->y) ? 7 : 5;
@@ -385,7 +470,7 @@ FocussedDStarPlanner::Cost FocussedDStarPlanner::processState(bool singleStep) {
 			if(pNeighbor->list == List_New || (pNeighbor->h_cost > neighborHCost) ||
 			   (pNeighbor->backPtr == pMin && pNeighbor->h_cost != neighborHCost)) {				   
 				pNeighbor->backPtr = pMin;
-				insert(*pNeighbor, neighborHCost);				
+				insert<Observed>(*pNeighbor, neighborHCost);				
 			}			
 		}
 	} else {
@@ -397,15 +482,15 @@ FocussedDStarPlanner::Cost FocussedDStarPlanner::processState(bool singleStep) {
 			if(pNeighbor->list == List_New ||
 			   (pNeighbor->backPtr == pMin && pNeighbor->h_cost != neighborHCost)) {
 				pNeighbor->backPtr = pMin;
-				insert(*pNeighbor, neighborHCost);				
+				insert<Observed>(*pNeighbor, neighborHCost);				
 			} else if(pNeighbor->backPtr != pMin) {
 				if(pNeighbor->h_cost > neighborHCost) {
-					insert(*pMin, pMin->h_cost);										
+					insert<Observed>(*pMin, pMin->h_cost);										
 				} else {
 					unsigned hCost = c_cost[i];
 					if(hCost < OBSTACLE_COST) hCost += pNeighbor->h_cost;
 					if(pMin->h_cost > hCost && pNeighbor->list == List_Closed && val < getCost(*pNeighbor)) {
-						insert(*pNeighbor, pNeighbor->h_cost);
+						insert<Observed>(*pNeighbor, pNeighbor->h_cost);
 					}
 				}
 			}
@@ -482,6 +567,7 @@ void FocussedDStarPlanner::heapUp(Cell &cell) {
 	while(idx != 1) {
 		unsigned parentIdx = idx >> 1;
 		if(*openHeap[idx] < *openHeap[parentIdx]) {
+			PLANNER_COUNT(heapUpSwaps);
 			Cell *temp = openHeap[parentIdx];
 			openHeap[parentIdx] = openHeap[idx];
 			openHeap[idx] = temp;
@@ -510,6 +596,7 @@ void FocussedDStarPlanner::heapDown(Cell &cell) {
 		}
 		
 		if(origIdx != idx) {
+			PLANNER_COUNT(heapDownSwaps);
 			Cell *temp = openHeap[idx];
 			openHeap[idx] = openHeap[origIdx];
 			openHeap[origIdx] = temp;
@@ -519,8 +606,10 @@ void FocussedDStarPlanner::heapDown(Cell &cell) {
 	}
 }
 
-void FocussedDStarPlanner::insert(Cell &cell, unsigned h_cost) {
+template<bool Observed> void FocussedDStarPlanner::insert(Cell &cell, unsigned h_cost) {
 	if(cell.list == List_Open) {
+		PLANNER_COUNT(decreaseKeys);
+		if(Observed) notifyKeyUpdated(cell.x, cell.y);
 		if(h_cost < cell.k_cost) cell.k_cost = h_cost;
 		cell.f_cost = cell.k_cost + dist(cell, *pRobot);
 		cell.fB_cost = cell.f_cost + d_curr;
@@ -532,6 +621,8 @@ void FocussedDStarPlanner::insert(Cell &cell, unsigned h_cost) {
 		cell.f_cost = cell.k_cost + dist(cell, *pRobot); 
 		cell.fB_cost = cell.f_cost + d_curr;
 		// insert element
+		PLANNER_COUNT(heapInserts);
+		if(Observed) notifyOpened(cell.x, cell.y);
 		int idx = ++openListLength;
 		openHeap[idx] = &cell;
 		cell.heapIndex = idx;
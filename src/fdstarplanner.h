@@ -20,6 +20,7 @@
 #define FDSTARPLANNER_H
 
 #include "abstractplanner.h"
+#include "deltastepping.h"
 #include <QImage>
 
 class FocussedDStarPlanner: public AbstractPlanner {
@@ -42,6 +43,7 @@ private slots:
 	void singleSteppingToggled(bool);
 	
 private:
+	friend class PlannerMicrobench; // kernel benchmarks
 	void doCalculatePath(InputUpdates updates, bool singleStep = false);
 
 	enum ListType {
@@ -96,6 +98,11 @@ private:
 	
 	Cell *pRobot;
 	unsigned d_curr;
+	bool initialSearch; // the search after a (re-)initialization has been interrupted (budget) before it finished
+	
+	// with full init, first plans after a new map or goal start from the cost field to the goal
+	DeltaStepping costField;
+	void seedFromCostField(Cell *pStart, Cell *pGoal);
 	
 	DebugLayer *listLayer;
 	DebugLayer *backPtrLayer;
@@ -105,8 +112,8 @@ private:
 	Cell *getMinState();
 	Cost getMinVal();
 	inline Cost getCost(const Cell &cell) { return Cost(cell.h_cost + dist(cell, *pRobot), cell.h_cost); }
-	Cost processState(bool singleStep);
-	void insert(Cell &cell, unsigned h_cost);
+	template<bool Observed> Cost processState(bool singleStep);
+	template<bool Observed = false> void insert(Cell &cell, unsigned h_cost);
 	void heapUp(Cell &cell);
 	void heapDown(Cell &cell);
 	void dumpCell(const Cell &cell);
@@ -0,0 +1,503 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hdastarplanner.h"
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <new>
+#include <QPainter>
+#include <QThread>
+
+#define INFINITE_COST	UINT_MAX
+// messages per queue (power of two), a sender handles its own messages while the receiver's queue is full
+#define QUEUE_CAPACITY	1024
+// times a worker waiting for the others to reset their cells yields before it blocks
+#define BARRIER_SPINS	100
+
+// octile distance, a lower bound of the path cost with straight (10) and diagonal (14) moves
+static inline unsigned heuristic(int x, int y, int goalX, int goalY) {
+	unsigned dx = abs(x - goalX), dy = abs(y - goalY);
+	return (dx > dy) ? 10 * dx + 4 * dy : 10 * dy + 4 * dx;
+}
+
+// ring buffer from one worker to another (single producer, single consumer)
+class HdaStarPlanner::MessageQueue {
+public:
+	MessageQueue(): head(0), tail(0) { }
+	void clear() {
+		head.store(0, std::memory_order_relaxed);
+		tail.store(0, std::memory_order_relaxed);
+	}
+	bool push(const Message &m) {
+		unsigned t = tail.load(std::memory_order_relaxed);
+		if(t - head.load(std::memory_order_acquire) == QUEUE_CAPACITY) return false;
+		buffer[t & (QUEUE_CAPACITY - 1)] = m;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+	bool pop(Message &m) {
+		unsigned h = head.load(std::memory_order_relaxed);
+		if(h == tail.load(std::memory_order_acquire)) return false;
+		m = buffer[h & (QUEUE_CAPACITY - 1)];
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+private:
+	std::atomic<unsigned> head; // written by the receiver
+	char padding[64]; // keeps the receiver's and the sender's index in different cache lines
+	std::atomic<unsigned> tail; // written by the sender
+	Message buffer[QUEUE_CAPACITY];
+};
+
+/* searches the cells owned by one index; the worker threads wait for searchStarted between the searches,
+ * worker 0 is not started and searches in the planner's thread
+ */
+class HdaStarPlanner::Worker: public QThread {
+public:
+	Worker(HdaStarPlanner *planner, int index, int ownedCells):
+		planner(planner), index(index), openListLength(0), busy(false), numPending(0) {
+		openList = new (std::nothrow) Cell *[ownedCells + 1];
+	}
+	~Worker() { delete[] openList; }
+
+	void search();
+
+	HdaStarPlanner *planner;
+	int index;
+	Cell **openList; // binary heap on f_cost of the owned cells, index 0 is unused
+	int openListLength;
+	Counters _counters; // of the last search, use PLANNER_COUNT() to modify
+
+protected:
+	void run() {
+		while(true) {
+			planner->searchStarted.acquire();
+			if(planner->quitWorkers.load()) return;
+			search();
+			planner->searchFinished.release();
+		}
+	}
+
+private:
+	bool busy; // counted in planner->activity
+	Message pending[8]; // messages of an interrupted search that did not fit into the queues, still counted in planner->activity
+	int numPending;
+	bool hasWork() const { return openListLength && openList[1]->f_cost < planner->bestCost.load(std::memory_order_relaxed); }
+	void relax(int idx, int parent, unsigned g_cost, unsigned f_cost);
+	void expand(Cell *pCell);
+	void send(int receiver, const Message &m);
+	void post(int receiver, const Message &m);
+	void waitForResets();
+	void receiveMessages();
+	void heapUp(Cell *pCell);
+	Cell *heapPop();
+};
+
+void HdaStarPlanner::Worker::heapUp(Cell *pCell) {
+	int m = pCell->heapIndex;
+	while(m != 1) {
+		Cell *pParent = openList[m / 2];
+		if(pCell->f_cost >= pParent->f_cost) break;
+		openList[m] = pParent;
+		pParent->heapIndex = m;
+		m /= 2;
+		PLANNER_COUNT(heapUpSwaps);
+	}
+	openList[m] = pCell;
+	pCell->heapIndex = m;
+}
+
+HdaStarPlanner::Cell *HdaStarPlanner::Worker::heapPop() {
+	Cell *pTop = openList[1];
+	pTop->heapIndex = 0;
+	Cell *pLast = openList[openListLength--];
+	if(pLast == pTop) return pTop;
+	int v = 1;
+	while(true) {
+		int u = 2 * v;
+		if(u > openListLength) break;
+		if(u < openListLength && openList[u + 1]->f_cost < openList[u]->f_cost) u++;
+		if(pLast->f_cost <= openList[u]->f_cost) break;
+		openList[v] = openList[u];
+		openList[v]->heapIndex = v;
+		v = u;
+		PLANNER_COUNT(heapDownSwaps);
+	}
+	openList[v] = pLast;
+	pLast->heapIndex = v;
+	return pTop;
+}
+
+// takes a path to an owned cell if it is cheaper than the known one, (re-)opens the cell
+void HdaStarPlanner::Worker::relax(int idx, int parent, unsigned g_cost, unsigned f_cost) {
+	Cell *pCell = planner->cells + idx;
+	if(g_cost >= pCell->g_cost) return;
+	pCell->g_cost = g_cost;
+	pCell->f_cost = f_cost;
+	pCell->parent = parent;
+	if(idx == planner->goalIdx) {
+		// the goal is not expanded, it only bounds the costs of the cells still worth expanding
+		unsigned best = planner->bestCost.load(std::memory_order_relaxed);
+		while(g_cost < best && !planner->bestCost.compare_exchange_weak(best, g_cost, std::memory_order_relaxed)) { }
+		return;
+	}
+	if(pCell->heapIndex) PLANNER_COUNT(decreaseKeys);
+	else {
+		pCell->heapIndex = ++openListLength;
+		PLANNER_COUNT(heapInserts);
+	}
+	heapUp(pCell);
+}
+
+void HdaStarPlanner::Worker::expand(Cell *pCell) {
+	static const int dx[8] = { -1,  0,  1, -1, -1, 1, 1, 0 };
+	static const int dy[8] = { -1, -1, -1,  0,  1, 0, 1, 1 };
+	int width = planner->allocatedSize.width(), height = planner->allocatedSize.height();
+	int idx = pCell - planner->cells;
+	int x = idx % width, y = idx / width;
+	int goalX = planner->goalIdx % width, goalY = planner->goalIdx / width;
+	const char *blocked = planner->occupancy.constData();
+	PLANNER_COUNT(expansions);
+
+	for(int i = 0; i < 8; i++) {
+		int nx = x + dx[i], ny = y + dy[i];
+		if((unsigned)nx >= (unsigned)width || (unsigned)ny >= (unsigned)height) continue;
+		PLANNER_COUNT(cellsTouched);
+		int neighbor = ny * width + nx;
+		if(blocked[neighbor] || neighbor == pCell->parent) continue;
+		// odd indices are straight moves
+		unsigned g_cost = pCell->g_cost + ((i & 1) ? 10 : 14);
+		unsigned f_cost = g_cost + heuristic(nx, ny, goalX, goalY);
+		if(f_cost >= planner->bestCost.load(std::memory_order_relaxed)) continue; // cannot lead to a better path
+
+		int receiver = planner->owner(neighbor);
+		if(receiver == index) relax(neighbor, idx, g_cost, f_cost);
+		else {
+			Message m = { neighbor, idx, g_cost, f_cost };
+			send(receiver, m);
+		}
+	}
+}
+
+void HdaStarPlanner::Worker::send(int receiver, const Message &m) {
+	planner->activity.fetch_add(1, std::memory_order_acq_rel);
+	post(receiver, m);
+}
+
+// puts a message counted in planner->activity into the receiver's queue, or keeps it if the search stops meanwhile
+void HdaStarPlanner::Worker::post(int receiver, const Message &m) {
+	MessageQueue &queue = planner->queues[receiver * planner->numWorkers + index];
+	while(!queue.push(m)) {
+		// the receiver may wait for room in our queues as well
+		receiveMessages();
+		if(planner->stopSearch.load(std::memory_order_relaxed)) {
+			pending[numPending++] = m;
+			return;
+		}
+		QThread::yieldCurrentThread();
+	}
+}
+
+void HdaStarPlanner::Worker::receiveMessages() {
+	int numWorkers = planner->numWorkers;
+	MessageQueue *queues = planner->queues + index * numWorkers;
+	Message m;
+	for(int sender = 0; sender < numWorkers; sender++) {
+		if(sender == index) continue;
+		while(queues[sender].pop(m)) {
+			relax(m.cell, m.parent, m.g_cost, m.f_cost);
+			// a message that gives an idle worker work passes its activity on to the worker
+			if(!busy && hasWork()) busy = true;
+			else planner->activity.fetch_sub(1, std::memory_order_acq_rel);
+		}
+	}
+}
+
+// blocks until all workers have reset their stripe of the cells
+void HdaStarPlanner::Worker::waitForResets() {
+	int numWorkers = planner->numWorkers;
+	if(planner->resetsDone.fetch_add(1, std::memory_order_acq_rel) == numWorkers - 1) {
+		// taking the mutex makes sure that a worker which has seen the old count is waiting before it is woken
+		planner->resetMutex.lock();
+		planner->resetMutex.unlock();
+		planner->resetsComplete.wakeAll();
+		return;
+	}
+	for(int i = 0; i < BARRIER_SPINS; i++) {
+		if(planner->resetsDone.load(std::memory_order_acquire) == numWorkers) return;
+		QThread::yieldCurrentThread();
+	}
+	QMutexLocker locker(&planner->resetMutex);
+	while(planner->resetsDone.load(std::memory_order_acquire) < numWorkers) planner->resetsComplete.wait(&planner->resetMutex);
+}
+
+void HdaStarPlanner::Worker::search() {
+	int numWorkers = planner->numWorkers;
+	_counters.clear();
+
+	if(planner->resume) {
+		// the open lists, the busy flags and the messages in transit are those of the interrupted search
+		Message held[8];
+		int numHeld = numPending;
+		for(int i = 0; i < numHeld; i++) held[i] = pending[i];
+		numPending = 0;
+		for(int i = 0; i < numHeld; i++) post(planner->owner(held[i].cell), held[i]);
+	} else {
+		// reset a stripe of the cells, the search starts when all workers are done
+		int64_t numCells = (int64_t)planner->allocatedSize.width() * planner->allocatedSize.height();
+		Cell *pEnd = planner->cells + numCells * (index + 1) / numWorkers;
+		for(Cell *pCell = planner->cells + numCells * index / numWorkers; pCell < pEnd; pCell++) {
+			pCell->g_cost = INFINITE_COST;
+			pCell->heapIndex = 0;
+		}
+		openListLength = 0;
+		numPending = 0;
+		waitForResets();
+
+		busy = true;
+		if(planner->owner(planner->startIdx) == index) {
+			int width = planner->allocatedSize.width();
+			relax(planner->startIdx, -1, 0, heuristic(planner->startIdx % width, planner->startIdx / width,
+													  planner->goalIdx % width, planner->goalIdx / width));
+		}
+	}
+
+	while(true) {
+		// the budget is checked by worker 0, the other workers stop with it
+		if(index == 0 && planner->interrupted()) {
+			planner->suspended = true;
+			planner->stopSearch.store(true, std::memory_order_relaxed);
+		}
+		if(planner->stopSearch.load(std::memory_order_relaxed)) break;
+		receiveMessages();
+		if(hasWork()) expand(heapPop());
+		else {
+			if(busy) {
+				busy = false;
+				planner->activity.fetch_sub(1, std::memory_order_acq_rel);
+			}
+			if(planner->activity.load(std::memory_order_acquire) == 0) break;
+			QThread::yieldCurrentThread();
+		}
+	}
+}
+
+// marks the expanded cells with the color of their owner
+class HdaStarPlanner::ThreadObserver: public PlannerObserver {
+public:
+	ThreadObserver(HdaStarPlanner *planner): planner(planner) { }
+	void expanded(int x, int y) { planner->threadMap.setPixel(x, y, 1 + planner->owner(y * planner->allocatedSize.width() + x)); }
+private:
+	HdaStarPlanner *planner;
+};
+
+HdaStarPlanner::HdaStarPlanner(QObject *parent):
+	AbstractPlanner(parent),
+	cells(NULL),
+	requestedThreads(0),
+	numWorkers(0),
+	workers(NULL),
+	queues(NULL),
+	startIdx(0),
+	goalIdx(0),
+	bestCost(INFINITE_COST),
+	activity(0),
+	resetsDone(0),
+	stopSearch(false),
+	quitWorkers(false),
+	suspended(false),
+	resume(false),
+	threadLayer(NULL),
+	threadMapWorkers(0),
+	threadObserver(new ThreadObserver(this))
+{
+	setSearchLayerObserver(threadObserver);
+}
+
+HdaStarPlanner::~HdaStarPlanner() {
+	freeMemory();
+	delete threadObserver;
+}
+
+void HdaStarPlanner::setThreadCount(int count) {
+	requestedThreads = count;
+}
+
+void HdaStarPlanner::freeMemory() {
+	if(workers) {
+		quitWorkers.store(true);
+		searchStarted.release(numWorkers - 1);
+		for(int i = 1; i < numWorkers; i++) workers[i]->wait();
+		quitWorkers.store(false);
+		for(int i = 0; i < numWorkers; i++) delete workers[i];
+		delete[] workers;
+	}
+	if(cells) delete[] cells;
+	if(queues) delete[] queues;
+	workers = NULL;
+	cells = NULL;
+	queues = NULL;
+	numWorkers = 0;
+	allocatedSize = QSize();
+	setMemoryUsage(Memory_Cells, 0);
+	setMemoryUsage(Memory_OpenList, 0);
+	setMemoryUsage(Memory_Tables, 0);
+}
+
+void HdaStarPlanner::initMap(const QImage &map, const QRect &updateRegion) {
+	int count = (requestedThreads > 0) ? requestedThreads : qMax(QThread::idealThreadCount(), 1);
+	bool newMap = (map.size() != allocatedSize || count != numWorkers);
+	if(newMap) {
+		freeMemory();
+		int64_t numCells = (int64_t)map.width() * map.height();
+		cells = new (std::nothrow) Cell[numCells];
+		queues = new (std::nothrow) MessageQueue[count * count];
+		if(!cells || !queues) {
+			printf("Could not allocate path planner memory\n");
+			freeMemory();
+			return;
+		}
+		numWorkers = count;
+		allocatedSize = map.size();
+
+		// each open list holds at most the cells owned by its worker
+		QVector<int> ownedCells(count, 0);
+		for(int64_t i = 0; i < numCells; i++) ownedCells[owner(i)]++;
+		workers = new Worker *[count];
+		int64_t openListBytes = 0;
+		bool allocated = true;
+		for(int i = 0; i < count; i++) {
+			workers[i] = new Worker(this, i, ownedCells[i]);
+			allocated &= (workers[i]->openList != NULL);
+			openListBytes += (ownedCells[i] + 1) * sizeof(Cell *);
+			if(i > 0) workers[i]->start();
+		}
+		if(!allocated) {
+			printf("Could not allocate path planner memory\n");
+			freeMemory();
+			return;
+		}
+		setMemoryUsage(Memory_Cells, numCells * (sizeof(Cell) + 1));
+		setMemoryUsage(Memory_OpenList, openListBytes);
+		setMemoryUsage(Memory_Tables, (int64_t)count * count * sizeof(MessageQueue));
+	}
+
+	QRect rc = (updateRegion.isNull() || newMap) ? map.rect() : updateRegion.intersected(map.rect());
+	occupancy.resize(map.width() * map.height());
+	char *pBlocked = occupancy.data();
+	for(int y = rc.top(); y <= rc.bottom(); y++) {
+		const unsigned char *pCost = (const unsigned char *)map.scanLine(y) + rc.left();
+		char *pRow = pBlocked + y * map.width() + rc.left();
+		for(int x = 0; x < rc.width(); x++) *pRow++ = (*pCost++ > 0);
+	}
+}
+
+void HdaStarPlanner::calculatePath(InputUpdates updates) {
+	if(!cells) {
+		setError("Planner memory allocation error");
+		return;
+	}
+
+	int width = mapWidth();
+	beginPhase(Phase_DebugLayers);
+	// the interrupted search is resumed unless the inputs have changed since
+	resume = suspended && !updates;
+	if(threadMap.size() != mapSize()) {
+		threadMap = QImage(mapSize(), QImage::Format_Indexed8);
+		threadMapWorkers = 0;
+		setMemoryUsage(Memory_DebugImages, threadMap.byteCount());
+	}
+	if(threadMapWorkers != numWorkers) {
+		// the hues are spread over the workers, a new map may come with another worker count
+		QVector<QRgb> colors;
+		colors.push_back(qRgba(0, 0, 0, 0));
+		for(int i = 0; i < 255; i++) colors.push_back(QColor::fromHsv(i * 360 / qMin(numWorkers, 255) % 360, 255, 255, 128).rgba());
+		threadMap.setColorTable(colors);
+		threadMapWorkers = numWorkers;
+	}
+	threadMap.fill(0);
+
+	QPoint goalPos = this->goalPos().toPoint();
+	QPoint startPos = this->startPos().toPoint();
+	goalIdx = goalPos.y() * width + goalPos.x();
+	startIdx = startPos.y() * width + startPos.x();
+	if(occupancy.at(goalIdx)) {
+		setError("Goal position blocked");
+		return;
+	}
+	if(occupancy.at(startIdx)) {
+		setError("Start position blocked");
+		return;
+	}
+
+	// the workers reset the cells in parallel before they search, unless an interrupted search is resumed
+	beginPhase(Phase_Search);
+	if(!resume) {
+		for(int i = 0; i < numWorkers * numWorkers; i++) queues[i].clear();
+		bestCost.store(INFINITE_COST);
+		activity.store(numWorkers);
+		resetsDone.store(0);
+	}
+	stopSearch.store(false);
+	suspended = false;
+	searchStarted.release(numWorkers - 1);
+	workers[0]->search();
+	searchFinished.acquire(numWorkers - 1);
+	for(int i = 0; i < numWorkers; i++) _counters += workers[i]->_counters;
+
+	Path &path = pathBuffer();
+	if(!suspended && bestCost.load() != INFINITE_COST) {
+		// follow the parents from the goal back to the start, costs decrease strictly along the parents
+		beginPhase(Phase_PathExtraction);
+		int pathLength = 1;
+		for(int idx = goalIdx; idx != startIdx; idx = cells[idx].parent) pathLength++;
+		path.resize(pathLength);
+		int segmentIndex = pathLength - 1;
+		for(int idx = goalIdx; ; idx = cells[idx].parent) {
+			path[segmentIndex--] = QPointF(idx % width, idx / width);
+			if(idx == startIdx) break;
+		}
+	} else if(!suspended) setError("No Path found");
+
+	beginPhase(Phase_DebugLayers);
+	if(observed()) {
+		// the workers do not report events, the opened (and expanded) cells are reported afterwards
+		int height = mapHeight();
+		const Cell *pCell = cells;
+		for(int y = 0; y < height; y++) {
+			for(int x = 0; x < width; x++, pCell++) {
+				if(pCell->g_cost == INFINITE_COST) continue;
+				notifyOpened(x, y);
+				if(!pCell->heapIndex && pCell != cells + goalIdx) {
+					notifyExpanded(x, y);
+					notifyClosed(x, y);
+				}
+			}
+		}
+	}
+	if(!threadLayer) addDebugLayer(threadLayer = new DebugLayer(tr("Show expanded cells by thread")));
+
+	setPath(path);
+}
+
+void HdaStarPlanner::drawDebugLayer(QPainter &painter, const DebugLayer *layer, const QRect &, qreal) {
+	if(layer == threadLayer) {
+		painter.drawImage(QPointF(-0.5, -0.5), threadMap);
+	}
+}
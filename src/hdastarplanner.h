@@ -0,0 +1,95 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HDASTARPLANNER_H
+#define HDASTARPLANNER_H
+
+#include "abstractplanner.h"
+#include <QImage>
+#include <QByteArray>
+#include <QSemaphore>
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+
+/* Hash-distributed A* (HDA*): the cells are distributed over worker threads by a hash of their index. Each
+ * thread expands the cells it owns from its own open list and sends the neighbors it generates to their owners
+ * through lock-free queues. Expansions are not globally ordered, so cells may be expanded again with lower
+ * costs; the search ends when no thread holds a cell cheaper than the best path to the goal found so far and
+ * no cells are in transit. With the (admissible) octile distance heuristic, this path is optimal. With a budget,
+ * worker 0 checks it and the other workers stop with it; continuePlanning() resumes all of them.
+ */
+class HdaStarPlanner: public AbstractPlanner {
+public:
+	HdaStarPlanner(QObject *parent = 0);
+	~HdaStarPlanner();
+
+	// number of worker threads (0: QThread::idealThreadCount()), takes effect with the next map
+	void setThreadCount(int count);
+	int threadCount() const { return numWorkers; }
+
+protected:
+	void initMap(const QImage &map, const QRect &updateRegion = QRect());
+	void calculatePath(InputUpdates updates);
+
+	void drawDebugLayer(QPainter &painter, const DebugLayer *layer, const QRect &visibleArea, qreal zoomFactor);
+
+private:
+	struct Cell {
+		unsigned g_cost, f_cost;
+		int parent; // index of the predecessor cell
+		int heapIndex; // position in the owner's open list, 0 if not on it
+	};
+	// a generated cell on its way to the owner
+	struct Message {
+		int cell, parent;
+		unsigned g_cost, f_cost;
+	};
+	class MessageQueue;
+	class Worker;
+	class ThreadObserver;
+
+	Cell *cells;
+	QByteArray occupancy; // 1 for blocked cells, row by row
+	QSize allocatedSize;
+	int requestedThreads;
+	int numWorkers;
+	Worker **workers; // workers[0] searches in the planner's thread, the others in their own threads
+	MessageQueue *queues; // queues[receiver * numWorkers + sender]
+	int owner(int idx) const { return (int)(((unsigned)idx * 2654435761u) >> 16) % numWorkers; }
+	void freeMemory();
+
+	// state of the running search, shared by the workers
+	int startIdx, goalIdx;
+	std::atomic<unsigned> bestCost; // of the paths to the goal found so far
+	std::atomic<int> activity; // busy workers plus messages in transit, the search has ended when it drops to 0
+	std::atomic<int> resetsDone; // workers that have reset their part of the cells
+	std::atomic<bool> stopSearch, quitWorkers;
+	QSemaphore searchStarted, searchFinished;
+	QMutex resetMutex; // with resetsComplete, blocks the workers until all have reset their cells
+	QWaitCondition resetsComplete;
+	bool suspended; // the search has been interrupted, the open lists and the queues are kept for resuming
+	bool resume; // the running call resumes an interrupted search, set before searchStarted is released
+
+	DebugLayer *threadLayer;
+	QImage threadMap;
+	int threadMapWorkers; // the worker count the color table of the thread map was made for
+	ThreadObserver *threadObserver;
+};
+
+#endif // HDASTARPLANNER_H
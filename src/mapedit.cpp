@@ -0,0 +1,204 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mapedit.h"
+#include "xorshift.h"
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <cstring>
+
+// draws a round dab of the given diameter, like the circle pen of the VisualizationWidget
+static QRect drawDab(QImage &map, const QPoint &center, int size, unsigned char cost) {
+	int lo = -(size - 1) / 2, hi = size / 2;
+	QRect rect = QRect(center.x() + lo, center.y() + lo, hi - lo + 1, hi - lo + 1).intersected(map.rect());
+	for(int y = rect.top(); y <= rect.bottom(); y++) {
+		unsigned char *pCost = (unsigned char *)map.scanLine(y);
+		int dy = 2 * (y - center.y()) - (size + 1) % 2;
+		for(int x = rect.left(); x <= rect.right(); x++) {
+			int dx = 2 * (x - center.x()) - (size + 1) % 2;
+			if(size <= 2 || dx * dx + dy * dy <= size * size) pCost[x] = cost;
+		}
+	}
+	return rect;
+}
+
+// draws a stroke from p1 to p2 with dabs at every cell (bresenham)
+static QRect drawStroke(QImage &map, QPoint p1, const QPoint &p2, int size, unsigned char cost) {
+	int dx = qAbs(p2.x() - p1.x()), sx = p1.x() < p2.x() ? 1 : -1;
+	int dy = -qAbs(p2.y() - p1.y()), sy = p1.y() < p2.y() ? 1 : -1;
+	int err = dx + dy;
+	QRect rect;
+	while(true) {
+		rect |= drawDab(map, p1, size, cost);
+		if(p1 == p2) break;
+		int e2 = 2 * err;
+		if(e2 >= dy) { err += dy; p1.rx() += sx; }
+		if(e2 <= dx) { err += dx; p1.ry() += sy; }
+	}
+	return rect;
+}
+
+QRect MapEdit::apply(QImage &map) const {
+	if(points.isEmpty() || map.format() != QImage::Format_Indexed8) return QRect();
+	unsigned char cost = blocking ? 255 : 0;
+	
+	QRect rect;
+	switch(tool) {
+	case Tool_Pen:
+	case Tool_Line:
+		if(points.size() == 1) rect = drawDab(map, points[0], size, cost);
+		for(int i = 1; i < points.size(); i++) rect |= drawStroke(map, points[i - 1], points[i], size, cost);
+		break;
+	case Tool_Rect:
+		if(points.size() < 2) return QRect();
+		rect = QRect(points[0], points[1]).normalized().intersected(map.rect());
+		for(int y = rect.top(); y <= rect.bottom(); y++) memset(map.scanLine(y) + rect.left(), cost, rect.width());
+		break;
+	}
+	return rect;
+}
+
+QString MapEdit::toString() const {
+	QString str;
+	switch(tool) {
+	case Tool_Pen: str = QString("pen %1 ").arg(size); break;
+	case Tool_Line: str = QString("line %1 ").arg(size); break;
+	case Tool_Rect: str = "rect "; break;
+	}
+	str += blocking ? "block" : "clear";
+	foreach(const QPoint &p, points) str += QString(" %1,%2").arg(p.x()).arg(p.y());
+	return str;
+}
+
+MapEdit MapEdit::fromString(const QString &str, bool *ok) {
+	MapEdit edit;
+	QStringList fields = str.split(' ', QString::SkipEmptyParts);
+	bool valid = fields.size() >= 3;
+	int idx = 1;
+	if(valid) {
+		if(fields[0] == "pen") edit.tool = Tool_Pen;
+		else if(fields[0] == "line") edit.tool = Tool_Line;
+		else if(fields[0] == "rect") edit.tool = Tool_Rect;
+		else valid = false;
+	}
+	if(valid && edit.tool != Tool_Rect) {
+		edit.size = fields[idx++].toInt(&valid);
+		if(edit.size < 1) valid = false;
+	}
+	if(valid) {
+		if(fields[idx] == "block") edit.blocking = true;
+		else if(fields[idx] == "clear") edit.blocking = false;
+		else valid = false;
+		idx++;
+	}
+	for(; valid && idx < fields.size(); idx++) {
+		QStringList coords = fields[idx].split(',');
+		valid = (coords.size() == 2);
+		int x = 0, y = 0;
+		if(valid) x = coords[0].toInt(&valid);
+		if(valid) y = coords[1].toInt(&valid);
+		edit.points.push_back(QPoint(x, y));
+	}
+	if(valid) {
+		if(edit.tool == Tool_Pen) valid = !edit.points.isEmpty();
+		else valid = (edit.points.size() == 2);
+	}
+	if(ok) *ok = valid;
+	return edit;
+}
+
+bool MapEditScript::load(const QString &fileName) {
+	_edits.clear();
+	_lastError.clear();
+	
+	QFile file(fileName);
+	if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		_lastError = QString("Could not open edit script \"%1\"").arg(fileName);
+		return false;
+	}
+	QTextStream in(&file);
+	int lineNo = 0;
+	while(!in.atEnd()) {
+		QString line = in.readLine().trimmed();
+		lineNo++;
+		if(line.isEmpty() || line.startsWith('#')) continue;
+		bool ok;
+		MapEdit edit = MapEdit::fromString(line, &ok);
+		if(!ok) {
+			_lastError = QString("%1:%2: invalid map edit").arg(fileName).arg(lineNo);
+			_edits.clear();
+			return false;
+		}
+		_edits.push_back(edit);
+	}
+	return true;
+}
+
+bool MapEditScript::save(const QString &fileName) const {
+	QFile file(fileName);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return false;
+	QTextStream out(&file);
+	foreach(const MapEdit &edit, _edits) out << edit.toString() << '\n';
+	return true;
+}
+
+MapEdits MapEditScript::random(const QSize &mapSize, int count, unsigned seed, int maxExtent, const QList<QPoint> &keepFree) {
+	MapEdits edits;
+	if(mapSize.isEmpty()) return edits;
+	maxExtent = qMax(1, maxExtent);
+	
+	XorShift32 rng(seed);
+	int attempts = 0;
+	while(edits.size() < count && attempts++ < 100 * count) {
+		QPoint p(rng.bounded(mapSize.width()), rng.bounded(mapSize.height()));
+		MapEdit edit;
+		edit.blocking = rng.uniform() < 0.7;
+		
+		double toolChoice = rng.uniform();
+		if(toolChoice < 0.4) {
+			// freehand stroke: random walk of a few points
+			edit.tool = MapEdit::Tool_Pen;
+			edit.size = rng.range(1, qMin(5, maxExtent));
+			int numPoints = rng.range(1, 6);
+			edit.points.push_back(p);
+			for(int i = 1; i < numPoints; i++) {
+				p += QPoint(rng.range(-maxExtent / 4, maxExtent / 4), rng.range(-maxExtent / 4, maxExtent / 4));
+				edit.points.push_back(p);
+			}
+		} else if(toolChoice < 0.7) {
+			edit.tool = MapEdit::Tool_Line;
+			edit.size = rng.range(1, qMin(3, maxExtent));
+			edit.points << p << p + QPoint(rng.range(-maxExtent, maxExtent), rng.range(-maxExtent, maxExtent));
+		} else {
+			edit.tool = MapEdit::Tool_Rect;
+			edit.points << p << p + QPoint(rng.range(0, maxExtent - 1), rng.range(0, maxExtent - 1));
+		}
+		
+		// bounding rect of the edit incl. the pen size, edits touching keepFree cells are discarded
+		QRect bounds = QRect(edit.points[0], QSize(1, 1));
+		foreach(const QPoint &q, edit.points) bounds |= QRect(q, QSize(1, 1));
+		if(edit.tool != MapEdit::Tool_Rect) bounds.adjust(-edit.size, -edit.size, edit.size, edit.size);
+		bool valid = true;
+		foreach(const QPoint &q, keepFree) {
+			if(bounds.contains(q)) valid = false;
+		}
+		if(valid && bounds.intersects(QRect(QPoint(0, 0), mapSize))) edits.push_back(edit);
+	}
+	return edits;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPEDIT_H
+#define MAPEDIT_H
+
+#include <QImage>
+#include <QList>
+#include <QPoint>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+/* A single map modification as done with the pen, line and rectangle tools of the
+ * VisualizationWidget, used to replay map updates without GUI.
+ * Text representation (one edit per line in edit scripts):
+ *   pen <size> <block|clear> <x>,<y> [<x>,<y> ...]
+ *   line <size> <block|clear> <x1>,<y1> <x2>,<y2>
+ *   rect <block|clear> <x1>,<y1> <x2>,<y2>
+ */
+class MapEdit {
+public:
+	enum Tool {
+		Tool_Pen,
+		Tool_Line,
+		Tool_Rect
+	};
+	
+	MapEdit(Tool tool = Tool_Rect, int size = 1, bool blocking = true): tool(tool), size(size), blocking(blocking) { }
+	
+	Tool tool;
+	QVector<QPoint> points;	// pen: stroke points, line: end points, rect: corners
+	int size;				// pen diameter in cells (pen and line only)
+	bool blocking;			// draws obstacles if true, free cells otherwise
+	
+	// modifies the map (Format_Indexed8) and returns the update region for AbstractPlanner::updateMap()
+	QRect apply(QImage &map) const;
+	
+	QString toString() const;
+	static MapEdit fromString(const QString &str, bool *ok = NULL);
+};
+
+typedef QList<MapEdit> MapEdits;
+
+class MapEditScript {
+public:
+	bool load(const QString &fileName);
+	bool save(const QString &fileName) const;
+	
+	const MapEdits &edits() const { return _edits; }
+	void setEdits(const MapEdits &edits) { _edits = edits; }
+	const QString &lastError() const { return _lastError; }
+	
+	/* generates a mix of pen strokes, lines and rectangles with extents up to maxExtent cells;
+	 * edits covering one of the keepFree cells (e.g. start and goal) are avoided
+	 */
+	static MapEdits random(const QSize &mapSize, int count, unsigned seed, int maxExtent = 32, const QList<QPoint> &keepFree = QList<QPoint>());
+
+private:
+	MapEdits _edits;
+	QString _lastError;
+};
+
+#endif // MAPEDIT_H
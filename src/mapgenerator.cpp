@@ -0,0 +1,272 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mapgenerator.h"
+#include "maputils.h"
+#include "xorshift.h"
+#include <QStringList>
+#include <cstring>
+
+static void fillRect(QImage &map, const QRect &rect, unsigned char cost) {
+	QRect r = rect.intersected(map.rect());
+	for(int y = r.top(); y <= r.bottom(); y++) memset(map.scanLine(y) + r.left(), cost, r.width());
+}
+
+QImage MapGenerator::generate(const Parameters &params) {
+	if(params.size.isEmpty()) return QImage();
+	QImage map(params.size, QImage::Format_Indexed8);
+	if(map.isNull()) return map; // out of memory
+	map.setColorTable(MapUtils::colorTable());
+	
+	switch(params.type) {
+		case Type_Random: generateRandom(map, params); break;
+		case Type_Maze: generateMaze(map, params); break;
+		case Type_Rooms: generateRooms(map, params); break;
+		case Type_Field: generateField(map, params); break;
+	}
+	return map;
+}
+
+void MapGenerator::generateRandom(QImage &map, const Parameters &params) {
+	XorShift32 rng(params.seed);
+	int block = qMax(1, params.blockSize), width = map.width();
+	uint64_t threshold = (uint64_t)(qBound(0.0, params.density, 1.0) * 4294967296.0);
+	
+	// decide one row of blocks, then copy it to the remaining rows of the block
+	for(int y0 = 0; y0 < map.height(); y0 += block) {
+		unsigned char *pRow = map.scanLine(y0);
+		if(block == 1) {
+			for(int x = 0; x < width; x++) pRow[x] = rng.next() < threshold ? 255 : 0;
+		} else {
+			for(int x = 0; x < width; x += block) memset(pRow + x, rng.next() < threshold ? 255 : 0, qMin(block, width - x));
+		}
+		for(int y = y0 + 1; y < qMin(y0 + block, map.height()); y++) memcpy(map.scanLine(y), pRow, width);
+	}
+}
+
+void MapGenerator::generateMaze(QImage &map, const Parameters &params) {
+	map.fill(255);
+	int corridor = qMax(1, params.corridorWidth), wall = qMax(1, params.wallThickness);
+	int pitch = corridor + wall;
+	int nx = (map.width() - wall) / pitch, ny = (map.height() - wall) / pitch;
+	if(nx < 1 || ny < 1) return;
+	
+	static const int dx[4] = { 1, -1, 0, 0 };
+	static const int dy[4] = { 0, 0, 1, -1 };
+	static const char Unvisited = 0, Root = 5;
+	
+	/* randomized depth first search; instead of a stack, every cell stores the direction
+	 * back to its parent (1 byte per cell), which allows mazes of 10^8 cells
+	 */
+	QByteArray parentDir(nx * ny, Unvisited);
+	XorShift32 rng(params.seed);
+	int cx = rng.bounded(nx), cy = rng.bounded(ny);
+	parentDir[cy * nx + cx] = Root;
+	fillRect(map, QRect(wall + cx * pitch, wall + cy * pitch, corridor, corridor), 0);
+	
+	while(true) {
+		int candidates[4], numCandidates = 0;
+		for(int d = 0; d < 4; d++) {
+			int x = cx + dx[d], y = cy + dy[d];
+			if(x >= 0 && x < nx && y >= 0 && y < ny && parentDir[y * nx + x] == Unvisited) candidates[numCandidates++] = d;
+		}
+		if(numCandidates) {
+			int d = candidates[rng.bounded(numCandidates)];
+			QRect from(wall + cx * pitch, wall + cy * pitch, corridor, corridor);
+			cx += dx[d];
+			cy += dy[d];
+			parentDir[cy * nx + cx] = (d ^ 1) + 1; // opposite direction
+			fillRect(map, from.united(QRect(wall + cx * pitch, wall + cy * pitch, corridor, corridor)), 0);
+		} else {
+			char back = parentDir[cy * nx + cx];
+			if(back == Root) break;
+			cx += dx[back - 1];
+			cy += dy[back - 1];
+		}
+	}
+}
+
+// part of area starting at offset with the given extent along the split axis
+static QRect splitPart(const QRect &area, bool horizontal, int offset, int extent) {
+	if(horizontal) return QRect(area.left(), area.top() + offset, area.width(), extent);
+	return QRect(area.left() + offset, area.top(), extent, area.height());
+}
+
+// true if the divider would end in front of a door of the walls enclosing its area
+static bool blocksDoor(const QImage &map, const QRect &divider, bool horizontal) {
+	QRect bounds = map.rect();
+	for(int i = 0; i < (horizontal ? divider.height() : divider.width()); i++) {
+		QPoint ends[2];
+		if(horizontal) {
+			ends[0] = QPoint(divider.left() - 1, divider.top() + i);
+			ends[1] = QPoint(divider.right() + 1, divider.top() + i);
+		} else {
+			ends[0] = QPoint(divider.left() + i, divider.top() - 1);
+			ends[1] = QPoint(divider.left() + i, divider.bottom() + 1);
+		}
+		for(int j = 0; j < 2; j++) {
+			if(bounds.contains(ends[j]) && map.constScanLine(ends[j].y())[ends[j].x()] == 0) return true;
+		}
+	}
+	return false;
+}
+
+static void drawWall(QImage &map, const QRect &wall, bool horizontal, int doorWidth, XorShift32 &rng) {
+	fillRect(map, wall, 255);
+	if(horizontal) {
+		doorWidth = qMin(doorWidth, wall.width());
+		fillRect(map, QRect(rng.range(wall.left(), wall.right() - doorWidth + 1), wall.top(), doorWidth, wall.height()), 0);
+	} else {
+		doorWidth = qMin(doorWidth, wall.height());
+		fillRect(map, QRect(wall.left(), rng.range(wall.top(), wall.bottom() - doorWidth + 1), wall.width(), doorWidth), 0);
+	}
+}
+
+void MapGenerator::generateRooms(QImage &map, const Parameters &params) {
+	map.fill(0);
+	int corridor = qMax(1, params.corridorWidth), wall = qMax(1, params.wallThickness), room = qMax(1, params.roomSize);
+	XorShift32 rng(params.seed);
+	
+	// recursive division: every area is split by a wall with a door, large areas by a corridor with a door on either side
+	QList<QRect> areas;
+	areas.push_back(map.rect());
+	while(!areas.isEmpty()) {
+		QRect area = areas.takeLast();
+		bool splitX = area.width() >= 2 * room + wall, splitY = area.height() >= 2 * room + wall;
+		if(!splitX && !splitY) continue;
+		bool horizontal = splitY && (!splitX || area.height() > area.width() || (area.height() == area.width() && rng.bounded(2)));
+		
+		int extent = horizontal ? area.height() : area.width();
+		bool isCorridor = (extent >= 8 * room && extent >= 2 * room + 2 * wall + corridor);
+		int dividerSize = isCorridor ? 2 * wall + corridor : wall;
+		
+		int offset = -1;
+		for(int i = 0; i < 16 && offset < 0; i++) {
+			offset = rng.range(room, extent - room - dividerSize);
+			if(blocksDoor(map, splitPart(area, horizontal, offset, dividerSize), horizontal)) offset = -1;
+		}
+		if(offset < 0) continue;
+		
+		drawWall(map, splitPart(area, horizontal, offset, wall), horizontal, corridor, rng);
+		if(isCorridor) drawWall(map, splitPart(area, horizontal, offset + wall + corridor, wall), horizontal, corridor, rng);
+		areas.push_back(splitPart(area, horizontal, 0, offset));
+		areas.push_back(splitPart(area, horizontal, offset + dividerSize, extent - offset - dividerSize));
+	}
+}
+
+void MapGenerator::generateField(QImage &map, const Parameters &params) {
+	map.fill(0);
+	XorShift32 rng(params.seed);
+	int minExtent = qMax(1, params.blockSize), maxExtent = 16 * minExtent;
+	
+	// overlaps are not accounted for, so the covered area is slightly below density
+	double area = 0.0, targetArea = qBound(0.0, params.density, 1.0) * map.width() * map.height();
+	while(area < targetArea) {
+		QRect obstacle(rng.bounded(map.width()), rng.bounded(map.height()), rng.range(minExtent, maxExtent), rng.range(minExtent, maxExtent));
+		fillRect(map, obstacle, 255);
+		area += obstacle.width() * obstacle.height();
+	}
+}
+
+QString MapGenerator::typeName(Type type) {
+	switch(type) {
+		case Type_Random: return "random";
+		case Type_Maze: return "maze";
+		case Type_Rooms: return "rooms";
+		case Type_Field: return "field";
+	}
+	return QString();
+}
+
+QString MapGenerator::Parameters::toString() const {
+	QString str = QString("gen:%1:size=%2x%3").arg(typeName(type)).arg(size.width()).arg(size.height());
+	if(type == Type_Random || type == Type_Field) str += QString(":density=%1:block=%2").arg(density).arg(blockSize);
+	if(type == Type_Maze || type == Type_Rooms) str += QString(":width=%1:wall=%2").arg(corridorWidth).arg(wallThickness);
+	if(type == Type_Rooms) str += QString(":room=%1").arg(roomSize);
+	return str + QString(":seed=%1").arg(seed);
+}
+
+// sets one parameter from its specification value, returns false if it is invalid
+static bool setParameter(MapGenerator::Parameters &p, const QString &key, const QString &value) {
+	bool ok = false;
+	if(key == "size") {
+		QStringList dims = value.split('x');
+		if(dims.size() > 2) return false;
+		int w = dims[0].toInt(&ok);
+		int h = (dims.size() == 2 && ok) ? dims[1].toInt(&ok) : w;
+		p.size = QSize(w, h);
+		return ok && w > 0 && h > 0;
+	} else if(key == "density") {
+		p.density = value.toDouble(&ok);
+		return ok && p.density >= 0.0 && p.density <= 1.0;
+	} else if(key == "seed") {
+		p.seed = value.toUInt(&ok);
+		return ok;
+	}
+	int v = value.toInt(&ok);
+	if(!ok || v < 1) return false;
+	if(key == "block") p.blockSize = v;
+	else if(key == "width") p.corridorWidth = v;
+	else if(key == "wall") p.wallThickness = v;
+	else if(key == "room") p.roomSize = v;
+	else return false;
+	return true;
+}
+
+QList<MapGenerator::Parameters> MapGenerator::parseSpec(const QString &spec, QString *error) {
+	QList<Parameters> result;
+	QStringList parts = spec.split(':');
+	if(parts.size() < 2 || parts[0] != "gen") {
+		if(error) *error = QString("Invalid map specification \"%1\"").arg(spec);
+		return result;
+	}
+	
+	Type type = Type_Random;
+	bool found = false;
+	for(int t = Type_Random; t <= Type_Field && !found; t++) {
+		if(parts[1] == typeName((Type)t)) {
+			type = (Type)t;
+			found = true;
+		}
+	}
+	if(!found) {
+		if(error) *error = QString("Unknown map type \"%1\" (random, maze, rooms or field)").arg(parts[1]);
+		return result;
+	}
+	result.push_back(Parameters(type));
+	
+	// every value of a list multiplies the maps specified so far
+	for(int i = 2; i < parts.size(); i++) {
+		int sep = parts[i].indexOf('=');
+		QString key = parts[i].left(sep);
+		QStringList values = parts[i].mid(sep + 1).split(',');
+		QList<Parameters> expanded;
+		foreach(const Parameters &p, result) {
+			foreach(const QString &value, values) {
+				Parameters q = p;
+				if(sep < 0 || !setParameter(q, key, value)) {
+					if(error) *error = QString("Invalid map parameter \"%1\" in \"%2\"").arg(parts[i]).arg(spec);
+					return QList<Parameters>();
+				}
+				expanded.push_back(q);
+			}
+		}
+		result = expanded;
+	}
+	return result;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPGENERATOR_H
+#define MAPGENERATOR_H
+
+#include <QImage>
+#include <QList>
+#include <QSize>
+#include <QString>
+
+/* Procedural planner maps (Format_Indexed8, 0 = free, 255 = obstacle) for scaling studies.
+ * The same parameters (incl. seed) always give the same map.
+ *
+ * Map specifications as accepted by the benchmark tool:
+ *   gen:<type>[:<key>=<value>[,<value> ...]] ...
+ * e.g. "gen:random:size=1000,4000x2000:density=0.1,0.2:seed=3". Lists of values expand
+ * to all combinations (a sweep), toString() gives the specification of a single map.
+ */
+class MapGenerator {
+public:
+	enum Type {
+		Type_Random,	// obstacle blocks of blockSize placed independently with probability density
+		Type_Maze,		// perfect maze (spanning tree) with corridors of corridorWidth
+		Type_Rooms,		// recursive division into rooms of at least roomSize, with doors and corridors of corridorWidth
+		Type_Field		// open field with sparse rectangular obstacles covering about density of the area
+	};
+	
+	struct Parameters {
+		Parameters(Type type = Type_Random, const QSize &size = QSize(1024, 1024)): type(type), size(size), density(0.2), seed(1),
+			blockSize(1), corridorWidth(4), wallThickness(1), roomSize(32) { }
+		
+		Type type;
+		QSize size;
+		double density;		// random and field only
+		unsigned seed;
+		int blockSize;		// random: obstacle size, field: minimum obstacle extent (maximum is 16 * blockSize)
+		int corridorWidth;	// maze and rooms, also the width of doors
+		int wallThickness;	// maze and rooms
+		int roomSize;		// rooms: minimum room extent
+		
+		QString toString() const;
+	};
+	
+	static QImage generate(const Parameters &params);
+	
+	static bool isSpec(const QString &str) { return str.startsWith("gen:"); }
+	// returns all parameter combinations of the specification, an empty list on errors
+	static QList<Parameters> parseSpec(const QString &spec, QString *error = NULL);
+	
+	static QString typeName(Type type);
+	
+private:
+	static void generateRandom(QImage &map, const Parameters &params);
+	static void generateMaze(QImage &map, const Parameters &params);
+	static void generateRooms(QImage &map, const Parameters &params);
+	static void generateField(QImage &map, const Parameters &params);
+};
+
+#endif // MAPGENERATOR_H
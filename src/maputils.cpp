@@ -0,0 +1,92 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "maputils.h"
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QFileInfo>
+
+QVector<QRgb> MapUtils::colorTable() {
+	QVector<QRgb> colorTable(256);
+	for(unsigned i = 0; i < 256; i++) colorTable[255 - i] = qRgb(i, i, i);
+	return colorTable;
+}
+
+QImage MapUtils::fromImage(const QImage &image, QRgb freeColor, int freeColorTolerance) {
+	if(image.isNull()) return QImage();
+	
+	QImage map(image.size(), QImage::Format_Indexed8);
+	map.setColorTable(colorTable());
+	
+	QImage img = image.convertToFormat(QImage::Format_RGB32);		
+	for(int y = 0; y < img.height(); y++) {
+		unsigned char *pDest = (unsigned char*)map.scanLine(y);
+		const QRgb *pSrc = (const QRgb *)img.scanLine(y);
+		for(int x = 0; x < img.width(); x++) {
+			QRgb clr = *pSrc++;
+			int rDelta = qAbs(qRed(freeColor) - qRed(clr));
+			int gDelta = qAbs(qGreen(freeColor) - qGreen(clr));
+			int bDelta = qAbs(qBlue(freeColor) - qBlue(clr));
+			if(gDelta > rDelta) rDelta = gDelta;
+			if(bDelta > rDelta) rDelta = bDelta;
+			
+			if(rDelta > freeColorTolerance) *pDest = 255;
+			else *pDest = 0;				
+		
+			pDest++;
+		} 			
+	}
+	return map;
+}
+
+QImage MapUtils::loadMovingAI(const QString &fileName) {
+	QFile file(fileName);
+	if(!file.open(QIODevice::ReadOnly)) return QImage();
+	
+	// header: type, height, width (in any order), terminated by "map"
+	int width = -1, height = -1;
+	while(true) {
+		if(file.atEnd()) return QImage();
+		QStringList header = QString(file.readLine()).trimmed().split(' ', QString::SkipEmptyParts);
+		if(header.isEmpty()) continue;
+		if(header[0] == "map") break;
+		if(header.size() != 2) return QImage();
+		if(header[0] == "height") height = header[1].toInt();
+		else if(header[0] == "width") width = header[1].toInt();
+	}
+	if(width <= 0 || height <= 0) return QImage();
+	
+	QImage map(width, height, QImage::Format_Indexed8);
+	map.setColorTable(colorTable());
+	for(int y = 0; y < height; y++) {
+		QByteArray line = file.readLine();
+		if(line.size() < width) return QImage();
+		unsigned char *pDest = (unsigned char*)map.scanLine(y);
+		for(int x = 0; x < width; x++) {
+			char c = line[x];
+			*pDest++ = (c == '.' || c == 'G' || c == 'S') ? 0 : 255;
+		}
+	}
+	return map;
+}
+
+QImage MapUtils::load(const QString &fileName, QRgb freeColor, int freeColorTolerance) {
+	if(QFileInfo(fileName).suffix().toLower() == "map") return loadMovingAI(fileName);
+	return fromImage(QImage(fileName), freeColor, freeColorTolerance);
+}
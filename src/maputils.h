@@ -0,0 +1,44 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPUTILS_H
+#define MAPUTILS_H
+
+#include <QImage>
+#include <QVector>
+class QString;
+
+namespace MapUtils {
+	// color table of planner maps: index 0 = free (white) ... 255 = obstacle (black)
+	QVector<QRgb> colorTable();
+	
+	/* converts an arbitrary image into a planner map (Format_Indexed8): pixels deviating
+	 * by more than freeColorTolerance from freeColor become obstacles (255), all others are free (0)
+	 */
+	QImage fromImage(const QImage &img, QRgb freeColor = qRgb(255, 255, 255), int freeColorTolerance = 10);
+	
+	/* loads a MovingAI benchmark map (.map, "type octile"): '.', 'G' and 'S' are free,
+	 * all other terrain is an obstacle. Returns a null image on failure
+	 */
+	QImage loadMovingAI(const QString &fileName);
+	
+	// loads an image file (or a MovingAI .map file) and converts it as above, returns a null image on failure
+	QImage load(const QString &fileName, QRgb freeColor = qRgb(255, 255, 255), int freeColorTolerance = 10);
+}
+
+#endif // MAPUTILS_H
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metricsexporter.h"
+#include <QFile>
+#include <QTimer>
+#include <QTextStream>
+#include <cstdio>
+
+// upper bounds of the latency histogram buckets in seconds
+const double MetricsExporter::latencyBuckets[NumLatencyBuckets - 1] = {
+	0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5
+};
+
+// label values of AbstractPlanner::MemoryComponent
+static const char *memoryComponentLabel(int component) {
+	switch(component) {
+	case AbstractPlanner::Memory_Cells: return "cells";
+	case AbstractPlanner::Memory_OpenList: return "open_list";
+	case AbstractPlanner::Memory_DebugImages: return "debug_images";
+	case AbstractPlanner::Memory_Tables: return "tables";
+	case AbstractPlanner::Memory_HeatMap: return "heat_map";
+	case AbstractPlanner::Memory_Path: return "path";
+	case AbstractPlanner::Memory_StepHistory: return "step_history";
+	case AbstractPlanner::Memory_CostField: return "cost_field";
+	default: return "other";
+	}
+}
+
+// label value with backslash, double quote and line feed escaped
+static QString labelValue(const QString &value) {
+	QString escaped = value;
+	escaped.replace("\\", "\\\\");
+	escaped.replace("\"", "\\\"");
+	escaped.replace("\n", "\\n");
+	return "\"" + escaped + "\"";
+}
+
+MetricsExporter::PlannerMetrics::PlannerMetrics():
+	queries(0), fullReplans(0), incrementalReplans(0), failures(0), interrupted(0), expansions(0), latencySum(0.0), peakMemory(0)
+{
+	for(int i = 0; i < NumLatencyBuckets; i++) latencyCounts[i] = 0;
+	for(int i = 0; i < AbstractPlanner::NumMemoryComponents; i++) memory[i] = 0;
+}
+
+MetricsExporter::MetricsExporter(QObject *parent):
+	QObject(parent),
+	planner(NULL), lastCallCount(0)
+{
+	timer = new QTimer(this);
+	connect(timer, SIGNAL(timeout()), this, SLOT(write()));
+}
+
+MetricsExporter::~MetricsExporter() {
+	stop();
+}
+
+bool MetricsExporter::start(const QString &fileName, int intervalMs) {
+	stop();
+	_fileName = fileName;
+	if(!write()) {
+		_fileName.clear();
+		return false;
+	}
+	timer->start(intervalMs);
+	return true;
+}
+
+bool MetricsExporter::stop() {
+	if(!isRunning()) return true;
+	timer->stop();
+	bool success = write();
+	_fileName.clear();
+	return success;
+}
+
+void MetricsExporter::setPlanner(AbstractPlanner *planner, const QString &name) {
+	if(this->planner) disconnect(this->planner, SIGNAL(dataChanged()), this, SLOT(plannerDataChanged()));
+	this->planner = planner;
+	plannerName = name;
+	lastCallCount = planner ? planner->callCount() : 0;
+	if(planner) connect(planner, SIGNAL(dataChanged()), this, SLOT(plannerDataChanged()));
+}
+
+void MetricsExporter::plannerDataChanged() {
+	// dataChanged() is also emitted without planner call, e.g. for invalid start or goal poses
+	if(!planner || planner->callCount() == lastCallCount) return;
+	lastCallCount = planner->callCount();
+	recordCall(planner, plannerName);
+}
+
+void MetricsExporter::recordCall(const AbstractPlanner *planner, const QString &name) {
+	if(planner->calcTimeNs() < 0) return;
+	PlannerMetrics &m = metrics[name];
+	m.queries++;
+	if(AbstractPlanner::isFullReplan(planner->lastInputUpdates())) m.fullReplans++;
+	else m.incrementalReplans++;
+	// an interrupted call has no path yet, it has not failed
+	if(!planner->planComplete()) m.interrupted++;
+	else if(planner->path().empty()) m.failures++;
+	m.expansions += planner->counters().expansions;
+	
+	double seconds = planner->calcTimeNs() * 1e-9;
+	int bucket = 0;
+	while(bucket < NumLatencyBuckets - 1 && seconds > latencyBuckets[bucket]) bucket++;
+	m.latencyCounts[bucket]++;
+	m.latencySum += seconds;
+	
+	for(int i = 0; i < AbstractPlanner::NumMemoryComponents; i++) m.memory[i] = planner->memoryUsage((AbstractPlanner::MemoryComponent)i);
+	m.peakMemory = qMax(m.peakMemory, planner->peakMemoryUsage());
+}
+
+QString MetricsExporter::text() const {
+	QString str;
+	QTextStream out(&str);
+	
+	out << "# HELP rastersim_planner_queries_total Planner calls.\n";
+	out << "# TYPE rastersim_planner_queries_total counter\n";
+	for(QMap<QString, PlannerMetrics>::const_iterator it = metrics.constBegin(); it != metrics.constEnd(); ++it) {
+		out << "rastersim_planner_queries_total{planner=" << labelValue(it.key()) << "} " << QString::number(it->queries) << "\n";
+	}
+	
+	out << "# HELP rastersim_planner_replans_total Planner calls by kind: full re-initialization (new goal or map) or incremental.\n";
+	out << "# TYPE rastersim_planner_replans_total counter\n";
+	for(QMap<QString, PlannerMetrics>::const_iterator it = metrics.constBegin(); it != metrics.constEnd(); ++it) {
+		out << "rastersim_planner_replans_total{planner=" << labelValue(it.key()) << ",kind=\"full\"} " << QString::number(it->fullReplans) << "\n";
+		out << "rastersim_planner_replans_total{planner=" << labelValue(it.key()) << ",kind=\"incremental\"} " << QString::number(it->incrementalReplans) << "\n";
+	}
+	
+	out << "# HELP rastersim_planner_failures_total Completed planner calls without path.\n";
+	out << "# TYPE rastersim_planner_failures_total counter\n";
+	for(QMap<QString, PlannerMetrics>::const_iterator it = metrics.constBegin(); it != metrics.constEnd(); ++it) {
+		out << "rastersim_planner_failures_total{planner=" << labelValue(it.key()) << "} " << QString::number(it->failures) << "\n";
+	}
+	
+	out << "# HELP rastersim_planner_interrupted_total Planner calls interrupted by the budget or a cancel request.\n";
+	out << "# TYPE rastersim_planner_interrupted_total counter\n";
+	for(QMap<QString, PlannerMetrics>::const_iterator it = metrics.constBegin(); it != metrics.constEnd(); ++it) {
+		out << "rastersim_planner_interrupted_total{planner=" << labelValue(it.key()) << "} " << QString::number(it->interrupted) << "\n";
+	}
+	
+	out << "# HELP rastersim_planner_latency_seconds Calculation time of the planner calls.\n";
+	out << "# TYPE rastersim_planner_latency_seconds histogram\n";
+	for(QMap<QString, PlannerMetrics>::const_iterator it = metrics.constBegin(); it != metrics.constEnd(); ++it) {
+		QString label = "planner=" + labelValue(it.key());
+		uint64_t count = 0;
+		for(int i = 0; i < NumLatencyBuckets; i++) {
+			count += it->latencyCounts[i];
+			QString le = (i < NumLatencyBuckets - 1) ? QString::number(latencyBuckets[i], 'g', 6) : QString("+Inf");
+			out << "rastersim_planner_latency_seconds_bucket{" << label << ",le=\"" << le << "\"} " << QString::number(count) << "\n";
+		}
+		out << "rastersim_planner_latency_seconds_sum{" << label << "} " << QString::number(it->latencySum, 'g', 12) << "\n";
+		out << "rastersim_planner_latency_seconds_count{" << label << "} " << QString::number(count) << "\n";
+	}
+	
+	if(AbstractPlanner::countersEnabled()) {
+		out << "# HELP rastersim_planner_expansions_total Cells taken from the open list.\n";
+		out << "# TYPE rastersim_planner_expansions_total counter\n";
+		for(QMap<QString, PlannerMetrics>::const_iterator it = metrics.constBegin(); it != metrics.constEnd(); ++it) {
+			out << "rastersim_planner_expansions_total{planner=" << labelValue(it.key()) << "} " << QString::number(it->expansions) << "\n";
+		}
+	}
+	
+	out << "# HELP rastersim_planner_memory_bytes Memory of the planner's data structures after the last call.\n";
+	out << "# TYPE rastersim_planner_memory_bytes gauge\n";
+	for(QMap<QString, PlannerMetrics>::const_iterator it = metrics.constBegin(); it != metrics.constEnd(); ++it) {
+		for(int i = 0; i < AbstractPlanner::NumMemoryComponents; i++) {
+			out << "rastersim_planner_memory_bytes{planner=" << labelValue(it.key()) << ",component=\"" << memoryComponentLabel(i) << "\"} " << QString::number(it->memory[i]) << "\n";
+		}
+	}
+	out << "# HELP rastersim_planner_peak_memory_bytes Peak memory of the planner's data structures.\n";
+	out << "# TYPE rastersim_planner_peak_memory_bytes gauge\n";
+	for(QMap<QString, PlannerMetrics>::const_iterator it = metrics.constBegin(); it != metrics.constEnd(); ++it) {
+		out << "rastersim_planner_peak_memory_bytes{planner=" << labelValue(it.key()) << "} " << QString::number(it->peakMemory) << "\n";
+	}
+	out.flush();
+	return str;
+}
+
+bool MetricsExporter::write() {
+	if(!isRunning()) return false;
+	QString tempName = _fileName + ".tmp";
+	QFile file(tempName);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		_lastError = QString(tr("Could not write \"%1\"")).arg(tempName);
+		return false;
+	}
+	QByteArray data = text().toUtf8();
+	bool success = (file.write(data) == data.size());
+	file.close();
+	// rename() replaces the old file atomically, QFile::rename() does not overwrite
+	if(!success || ::rename(QFile::encodeName(tempName).constData(), QFile::encodeName(_fileName).constData()) != 0) {
+		_lastError = QString(tr("Could not write \"%1\"")).arg(_fileName);
+		return false;
+	}
+	return true;
+}
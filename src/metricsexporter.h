@@ -0,0 +1,93 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QObject>
+#include <QMap>
+#include <QString>
+#include <stdint.h>
+#include "abstractplanner.h"
+class QTimer;
+
+/* Cumulative planner metrics in the Prometheus text exposition format, written periodically to a file
+ * for the textfile collector of node_exporter, so no network listener is needed. The file is written
+ * to "<file>.tmp" and renamed, the collector never sees a partial file. All metrics are labeled with
+ * the planner name and accumulate over planner switches for the lifetime of the exporter:
+ *   rastersim_planner_queries_total                  planner calls
+ *   rastersim_planner_replans_total{kind}            "full" re-initializations (new goal or map, see
+ *                                                    AbstractPlanner::isFullReplan()) and "incremental" replans
+ *   rastersim_planner_failures_total                 completed calls without path
+ *   rastersim_planner_interrupted_total              calls interrupted by the budget or cancel()
+ *                                                    (AbstractPlanner::planComplete() false)
+ *   rastersim_planner_latency_seconds                histogram of the calculation times
+ *   rastersim_planner_expansions_total               (only if AbstractPlanner::countersEnabled())
+ *   rastersim_planner_memory_bytes{component}        memory after the last call (gauge)
+ *   rastersim_planner_peak_memory_bytes
+ */
+class MetricsExporter: public QObject {
+	Q_OBJECT
+public:
+	MetricsExporter(QObject *parent = 0);
+	~MetricsExporter();
+	
+	// writes the file every intervalMs and when stopped; returns false if the file cannot be written
+	bool start(const QString &fileName, int intervalMs = 15000);
+	bool stop(); // returns false if the last write failed
+	bool isRunning() const { return !_fileName.isEmpty(); }
+	const QString &fileName() const { return _fileName; }
+	const QString &lastError() const { return _lastError; }
+	
+	// records the calls of this planner (via AbstractPlanner::dataChanged()) until another planner is set
+	void setPlanner(AbstractPlanner *planner, const QString &name);
+	// records the last call of a planner, for callers without event loop
+	void recordCall(const AbstractPlanner *planner, const QString &name);
+	
+	QString text() const;
+	
+public slots:
+	bool write();
+	
+private slots:
+	void plannerDataChanged();
+	
+private:
+	enum { NumLatencyBuckets = 15 }; // including +Inf
+	static const double latencyBuckets[NumLatencyBuckets - 1];
+	
+	struct PlannerMetrics {
+		PlannerMetrics();
+		uint64_t queries, fullReplans, incrementalReplans, failures, interrupted, expansions;
+		uint64_t latencyCounts[NumLatencyBuckets]; // not cumulative
+		double latencySum;
+		int64_t memory[AbstractPlanner::NumMemoryComponents];
+		int64_t peakMemory;
+	};
+	QMap<QString, PlannerMetrics> metrics;
+	
+	AbstractPlanner *planner;
+	QString plannerName;
+	unsigned lastCallCount;
+	
+	QTimer *timer;
+	QString _fileName;
+	QString _lastError;
+};
+
+#endif // METRICSEXPORTER_H
@@ -0,0 +1,209 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "microbench.h"
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+
+using namespace MicroBench;
+
+static inline int64_t timestampNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+State::State(int64_t iterations):
+	_maxIterations(iterations), _iteration(0),
+	_items(0),
+	_elapsedNs(0), _startNs(0),
+	_running(false)
+{
+	
+}
+
+bool State::keepRunning() {
+	if(_iteration == 0) resumeTiming();
+	if(_iteration++ < _maxIterations) return true;
+	pauseTiming();
+	return false;
+}
+
+void State::pauseTiming() {
+	if(!_running) return;
+	_elapsedNs += timestampNs() - _startNs;
+	_running = false;
+}
+
+void State::resumeTiming() {
+	if(_running) return;
+	_startNs = timestampNs();
+	_running = true;
+}
+
+struct Benchmark {
+	const char *name;
+	Function function;
+};
+
+// function local to avoid static initialization order issues with the registrations
+static QList<Benchmark> &benchmarks() {
+	static QList<Benchmark> list;
+	return list;
+}
+
+Registration::Registration(const char *name, Function function) {
+	Benchmark b = { name, function };
+	benchmarks().push_back(b);
+}
+
+struct Measurement {
+	int64_t iterations;
+	double nsPerIteration, nsPerItem;
+};
+
+static Measurement measure(Function function, int64_t iterations) {
+	State state(iterations);
+	function(state);
+	Measurement m;
+	m.iterations = iterations;
+	m.nsPerIteration = (double)state.elapsedNs() / iterations;
+	m.nsPerItem = state.itemsProcessed() > 0 ? (double)state.elapsedNs() / state.itemsProcessed() : 0.0;
+	return m;
+}
+
+static double median(QVector<double> values) {
+	std::sort(values.begin(), values.end());
+	int n = values.size();
+	return (n & 1) ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+static void printUsage(const char *appName) {
+	printf("Usage: %s [options]\n"
+		   "Runs the planner kernel microbenchmarks.\n\n"
+		   "Options:\n"
+		   "  -f, --filter <text>       run only benchmarks whose name contains text\n"
+		   "  -t, --min-time <s>        minimum run time per measurement (default: 0.2)\n"
+		   "  -r, --repetitions <n>     number of measurements, the median is reported (default: 5)\n"
+		   "      --csv <file>          write the results as CSV\n"
+		   "      --baseline <file>     compare against the CSV results of a previous run\n"
+		   "  -l, --list                list available benchmarks\n"
+		   "  -h, --help                show this help\n", appName);
+}
+
+int MicroBench::run(int argc, char *argv[]) {
+	QString filter, csvFile, baselineFile;
+	double minTime = 0.2;
+	int repetitions = 5;
+	for(int i = 1; i < argc; i++) {
+		bool hasValue = (i + 1 < argc);
+		bool ok = true;
+		if(!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
+			printUsage(argv[0]);
+			return 0;
+		} else if(!strcmp(argv[i], "-l") || !strcmp(argv[i], "--list")) {
+			foreach(const Benchmark &b, benchmarks()) printf("%s\n", b.name);
+			return 0;
+		} else if((!strcmp(argv[i], "-f") || !strcmp(argv[i], "--filter")) && hasValue) {
+			filter = argv[++i];
+		} else if((!strcmp(argv[i], "-t") || !strcmp(argv[i], "--min-time")) && hasValue) {
+			minTime = QString(argv[++i]).toDouble(&ok);
+		} else if((!strcmp(argv[i], "-r") || !strcmp(argv[i], "--repetitions")) && hasValue) {
+			repetitions = QString(argv[++i]).toInt(&ok);
+			if(repetitions < 1) ok = false;
+		} else if(!strcmp(argv[i], "--csv") && hasValue) {
+			csvFile = argv[++i];
+		} else if(!strcmp(argv[i], "--baseline") && hasValue) {
+			baselineFile = argv[++i];
+		} else ok = false;
+		
+		if(!ok) {
+			fprintf(stderr, "Invalid argument \"%s\"\n", argv[i]);
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+	
+	// baseline: name -> ns per iteration
+	QMap<QString, double> baseline;
+	if(!baselineFile.isEmpty()) {
+		QFile file(baselineFile);
+		if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+			fprintf(stderr, "Could not open baseline \"%s\"\n", qPrintable(baselineFile));
+			return 1;
+		}
+		QTextStream in(&file);
+		in.readLine(); // header
+		while(!in.atEnd()) {
+			QStringList fields = in.readLine().split(',');
+			if(fields.size() >= 3) baseline[fields[0]] = fields[2].toDouble();
+		}
+	}
+	
+	QFile csv;
+	QTextStream csvOut;
+	if(!csvFile.isEmpty()) {
+		csv.setFileName(csvFile);
+		if(!csv.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+			fprintf(stderr, "Could not write \"%s\"\n", qPrintable(csvFile));
+			return 1;
+		}
+		csvOut.setDevice(&csv);
+		csvOut << "name,iterations,ns_per_iteration,ns_per_item\n";
+	}
+	
+	printf("%-36s %12s %16s %14s %10s\n", "benchmark", "iterations", "time/iter [ns]", "time/item [ns]", "baseline");
+	foreach(const Benchmark &b, benchmarks()) {
+		if(!filter.isEmpty() && !QString(b.name).contains(filter)) continue;
+		
+		// calibration: grow the number of iterations until the minimum time is reached
+		int64_t iterations = 1;
+		Measurement m = measure(b.function, iterations);
+		while(m.nsPerIteration * iterations < minTime * 1e9 && iterations < ((int64_t)1 << 40)) {
+			double estimate = (minTime * 1e9 * 1.2) / qMax(m.nsPerIteration, 1.0);
+			iterations = qMax(iterations * 2, (int64_t)qMin(estimate, iterations * 100.0));
+			m = measure(b.function, iterations);
+		}
+		
+		QVector<double> perIteration, perItem;
+		for(int r = 0; r < repetitions; r++) {
+			if(r > 0) m = measure(b.function, iterations);
+			perIteration.push_back(m.nsPerIteration);
+			perItem.push_back(m.nsPerItem);
+		}
+		double nsPerIteration = median(perIteration), nsPerItem = median(perItem);
+		
+		QString comparison;
+		if(baseline.contains(b.name) && baseline[b.name] > 0.0) {
+			comparison.sprintf("%+.1f%%", 100.0 * (nsPerIteration / baseline[b.name] - 1.0));
+		}
+		printf("%-36s %12lld %16.1f %14.2f %10s\n", b.name, (long long)iterations, nsPerIteration, nsPerItem, qPrintable(comparison));
+		fflush(stdout);
+		if(csv.isOpen()) csvOut << b.name << ',' << (qlonglong)iterations << ',' << QString::number(nsPerIteration, 'f', 2) << ',' 
+								<< QString::number(nsPerItem, 'f', 3) << '\n';
+	}
+	return 0;
+}
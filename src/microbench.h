@@ -0,0 +1,80 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+#include <stdint.h>
+
+/* Minimal microbenchmark harness in the style of google-benchmark:
+ *
+ *   static void heapInsert(MicroBench::State &state) {
+ *       setup();
+ *       while(state.keepRunning()) {
+ *           state.pauseTiming(); prepare(); state.resumeTiming();
+ *           kernel();
+ *       }
+ *       state.setItemsProcessed(state.iterations() * itemsPerIteration);
+ *   }
+ *   MICROBENCHMARK(HeapInsert, heapInsert)
+ *
+ * MicroBench::run() calibrates the number of iterations to reach a minimum run time, repeats
+ * the measurement and reports the median time per iteration and per item. Results can be saved
+ * as CSV and compared against a previous run (e.g. from another commit).
+ */
+namespace MicroBench {
+	class State {
+	public:
+		State(int64_t iterations);
+		
+		// returns true as long as further iterations are to be run, starts and stops the timer
+		bool keepRunning();
+		void pauseTiming();
+		void resumeTiming();
+		
+		int64_t iterations() const { return _maxIterations; }
+		// number of processed items (e.g. heap operations), used to report the time per item
+		void setItemsProcessed(int64_t items) { _items = items; }
+		int64_t itemsProcessed() const { return _items; }
+		int64_t elapsedNs() const { return _elapsedNs; }
+		
+	private:
+		int64_t _maxIterations, _iteration;
+		int64_t _items;
+		int64_t _elapsedNs, _startNs;
+		bool _running;
+	};
+	
+	typedef void (*Function)(State &state);
+	
+	struct Registration {
+		Registration(const char *name, Function function);
+	};
+	
+	// runs all registered benchmarks, see --help for the command line options
+	int run(int argc, char *argv[]);
+	
+	// keeps the compiler from optimizing away the computation of value
+	template<typename T> inline void doNotOptimize(const T &value) {
+		asm volatile("" : : "g"(&value) : "memory");
+	}
+}
+
+#define MICROBENCHMARK(name, function) static MicroBench::Registration microbench_registration_##name(#name, function);
+
+#endif // MICROBENCH_H
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "perfcounters.h"
+#include <cstring>
+#include <cerrno>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+PerfCounters::PerfCounters() {
+	for(int i = 0; i < NumEvents; i++) fds[i] = -1;
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+	for(int i = 0; i < NumEvents; i++) {
+		if(fds[i] >= 0) close(fds[i]);
+	}
+#endif
+}
+
+QString PerfCounters::eventName(Event event) {
+	switch(event) {
+		case Cycles: return "cycles";
+		case Instructions: return "instructions";
+		case L1DMisses: return "L1D misses";
+		case LLCMisses: return "LLC misses";
+		case BranchMisses: return "branch misses";
+		default: return QString();
+	}
+}
+
+#ifdef __linux__
+
+bool PerfCounters::open() {
+	if(isOpen()) return true;
+	
+	static const struct { uint32_t type; uint64_t config; } events[NumEvents] = {
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+		{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES }
+	};
+	
+	// cycles lead the group, the other events are optional
+	for(int i = 0; i < NumEvents; i++) {
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = events[i].type;
+		attr.config = events[i].config;
+		attr.disabled = (i == Cycles);
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+		
+		fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, i == Cycles ? -1 : fds[Cycles], 0);
+		if(i == Cycles && fds[i] < 0) {
+			_lastError = QString("perf_event_open failed: %1").arg(strerror(errno));
+			return false;
+		}
+	}
+	return true;
+}
+
+void PerfCounters::start() {
+	if(!isOpen()) return;
+	ioctl(fds[Cycles], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(fds[Cycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+PerfCounters::Values PerfCounters::stop() {
+	Values values;
+	if(!isOpen()) return values;
+	ioctl(fds[Cycles], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	
+	// group format: number of events, then value and id of each event
+	uint64_t data[1 + 2 * NumEvents];
+	if(read(fds[Cycles], data, sizeof(data)) < (ssize_t)sizeof(uint64_t)) return values;
+	uint64_t ids[NumEvents];
+	for(int i = 0; i < NumEvents; i++) {
+		ids[i] = (uint64_t)-1;
+		if(fds[i] >= 0) ioctl(fds[i], PERF_EVENT_IOC_ID, &ids[i]);
+	}
+	for(uint64_t j = 0; j < data[0] && j < NumEvents; j++) {
+		for(int i = 0; i < NumEvents; i++) {
+			if(fds[i] >= 0 && ids[i] == data[2 + 2 * j]) values.value[i] = data[1 + 2 * j];
+		}
+	}
+	return values;
+}
+
+#else
+
+bool PerfCounters::open() {
+	_lastError = "hardware counters are only supported on Linux";
+	return false;
+}
+void PerfCounters::start() { }
+PerfCounters::Values PerfCounters::stop() { return Values(); }
+
+#endif
+
+PerfCounters *PerfCounters::forCurrentThread() {
+	static thread_local PerfCounters *counters = NULL;
+	static thread_local bool failed = false;
+	if(!counters && !failed) {
+		counters = new PerfCounters;
+		if(!counters->open()) {
+			delete counters;
+			counters = NULL;
+			failed = true;
+		}
+	}
+	return counters;
+}
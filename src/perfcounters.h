@@ -0,0 +1,67 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <QString>
+#include <stdint.h>
+
+/* Hardware performance counters of the calling thread (Linux perf_event_open, user space only).
+ * All counters are scheduled as one group, so the values of a measurement belong together.
+ * Counters the CPU (or virtual machine) does not support are reported as -1; on other
+ * platforms or with perf_event_paranoid > 2, open() fails and nothing is measured.
+ */
+class PerfCounters {
+public:
+	PerfCounters();
+	~PerfCounters();
+	
+	enum Event {
+		Cycles,
+		Instructions,
+		L1DMisses,		// L1 data cache read misses
+		LLCMisses,		// last level cache misses
+		BranchMisses,
+		NumEvents
+	};
+	static QString eventName(Event event);
+	
+	struct Values {
+		Values() { for(int i = 0; i < NumEvents; i++) value[i] = -1; }
+		bool isValid() const { return value[Cycles] >= 0; }
+		int64_t operator[](Event event) const { return value[event]; }
+		int64_t value[NumEvents];	// -1 if not available
+	};
+	
+	bool open();
+	bool isOpen() const { return fds[Cycles] >= 0; }
+	const QString &lastError() const { return _lastError; }
+	
+	void start();
+	Values stop();
+	
+	// counters of the calling thread, opened on first use; NULL if they are not available
+	static PerfCounters *forCurrentThread();
+
+private:
+	int fds[NumEvents];
+	QString _lastError;
+};
+
+#endif // PERFCOUNTERS_H
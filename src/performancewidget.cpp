@@ -0,0 +1,301 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "performancewidget.h"
+#include "abstractplanner.h"
+#include <QLabel>
+#include <QPainter>
+#include <QTimer>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QVector>
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+
+// calls within this period count for the replanning rate
+static const int64_t rateWindowNs = 5000000000LL;
+
+// resident set size of the process in bytes, -1 if unknown
+static int64_t residentMemory() {
+#ifdef __linux__
+	FILE *f = fopen("/proc/self/statm", "r");
+	if(!f) return -1;
+	long pages = -1, resident = -1;
+	int n = fscanf(f, "%ld %ld", &pages, &resident);
+	fclose(f);
+	return n == 2 ? (int64_t)resident * sysconf(_SC_PAGESIZE) : -1;
+#else
+	return -1;
+#endif
+}
+
+static int64_t percentile(const QVector<int64_t> &sorted, double p) {
+	if(sorted.isEmpty()) return -1;
+	int idx = (int)ceil(p * sorted.size()) - 1;
+	return sorted[qBound(0, idx, sorted.size() - 1)];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class LatencyHistogram
+////////////////////////////////////////////////////////////////////////////////
+
+/* histogram of calculation times with logarithmic bins from 1 µs to 10 s (4 per decade),
+ * the p50/p95/p99 latencies are marked by vertical lines
+ */
+class LatencyHistogram: public QWidget {
+public:
+	enum { binsPerDecade = 4, numDecades = 7, numBins = binsPerDecade * numDecades };
+	
+	LatencyHistogram(QWidget *parent = 0): QWidget(parent) {
+		setMinimumHeight(70);
+		setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Fixed);
+		clear();
+	}
+	void clear() {
+		for(int i = 0; i < numBins; i++) bins[i] = 0;
+		for(int i = 0; i < 3; i++) marks[i] = -1;
+		update();
+	}
+	void setData(const QVector<int64_t> &sortedTimesNs, int64_t p50, int64_t p95, int64_t p99) {
+		for(int i = 0; i < numBins; i++) bins[i] = 0;
+		foreach(int64_t ns, sortedTimesNs) bins[bin(ns)]++;
+		marks[0] = p50;
+		marks[1] = p95;
+		marks[2] = p99;
+		update();
+	}
+	
+protected:
+	void paintEvent(QPaintEvent *) {
+		QPainter painter(this);
+		QRect area = rect().adjusted(1, 1, -1, -fontMetrics().height() - 2);
+		painter.fillRect(area, palette().base());
+		
+		int maxCount = 0;
+		for(int i = 0; i < numBins; i++) maxCount = qMax(maxCount, bins[i]);
+		qreal binWidth = (qreal)area.width() / numBins;
+		if(maxCount) {
+			painter.setPen(Qt::NoPen);
+			painter.setBrush(palette().highlight());
+			for(int i = 0; i < numBins; i++) {
+				if(!bins[i]) continue;
+				qreal h = qMax(1.0, (qreal)area.height() * bins[i] / maxCount);
+				painter.drawRect(QRectF(area.left() + i * binWidth, area.bottom() + 1 - h, binWidth - 1, h));
+			}
+		}
+		
+		static const QColor markColors[3] = { QColor(0, 160, 0), QColor(255, 140, 0), QColor(220, 0, 0) };
+		for(int i = 0; i < 3; i++) {
+			if(marks[i] <= 0) continue;
+			qreal x = area.left() + position(marks[i]) * area.width();
+			painter.setPen(QPen(markColors[i], 0));
+			painter.drawLine(QPointF(x, area.top()), QPointF(x, area.bottom()));
+		}
+		
+		painter.setPen(palette().color(QPalette::WindowText));
+		static const char *decadeLabels[numDecades + 1] = { "1\xc2\xb5s", "10\xc2\xb5s", "100\xc2\xb5s", "1ms", "10ms", "100ms", "1s", "10s" };
+		for(int i = 0; i <= numDecades; i += 2) {
+			int x = area.left() + i * area.width() / numDecades;
+			QString label = QString::fromUtf8(decadeLabels[i]);
+			int w = fontMetrics().width(label);
+			painter.drawText(qBound(0, x - w / 2, width() - w), height() - fontMetrics().descent() - 1, label);
+		}
+	}
+
+private:
+	int bins[numBins];
+	int64_t marks[3];
+	
+	// position of a duration on the logarithmic axis, 0 (1 µs) ... 1 (10 s)
+	static qreal position(int64_t ns) {
+		return qBound(0.0, (log10(qMax<qreal>(ns, 1.0)) - 3.0) / numDecades, 1.0);
+	}
+	static int bin(int64_t ns) {
+		return qMin((int)(position(ns) * numBins), numBins - 1);
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class PerformanceWidget
+////////////////////////////////////////////////////////////////////////////////
+
+PerformanceWidget::PerformanceWidget(QWidget *parent):
+	QWidget(parent),
+	planner(NULL), lastCallCount(0)
+{
+	QVBoxLayout *mainLayout = new QVBoxLayout;
+	
+	QHBoxLayout *calcTimeLayout = new QHBoxLayout;
+	QLabel *calcTimeCaptionLabel = new QLabel(tr("calc. time:"));
+	calcTimeCaptionLabel->setAlignment(Qt::AlignVCenter | Qt::AlignLeft);
+	calcTimeLayout->addWidget(calcTimeCaptionLabel, 0);
+	calcTimeLabel = new QLabel("---");
+	calcTimeLabel->setAlignment(Qt::AlignVCenter | Qt::AlignRight);
+	QFont font = calcTimeLabel->font();
+	font.setPointSize(14);
+	font.setBold(true);
+	calcTimeLabel->setFont(font);
+	calcTimeLayout->addWidget(calcTimeLabel, 1);
+	mainLayout->addLayout(calcTimeLayout, 0);
+	
+	percentileLabel = new QLabel;
+	mainLayout->addWidget(percentileLabel, 0);
+	histogram = new LatencyHistogram;
+	mainLayout->addWidget(histogram, 0);
+	rateLabel = new QLabel;
+	mainLayout->addWidget(rateLabel, 0);
+	
+	phaseTimeLabel = new QLabel;
+	phaseTimeLabel->setAlignment(Qt::AlignLeft | Qt::AlignTop);
+	mainLayout->addWidget(phaseTimeLabel, 1);
+	setLayout(mainLayout);
+	
+	rateTimer = new QTimer(this);
+	rateTimer->setInterval(1000);
+	connect(rateTimer, SIGNAL(timeout()), this, SLOT(updateRates()));
+	rateTimer->start();
+	
+	clock.start();
+	reset();
+}
+
+void PerformanceWidget::setPlanner(AbstractPlanner *planner) {
+	if(this->planner) disconnect(this->planner, SIGNAL(dataChanged()), this, SLOT(updatePlannerData()));
+	this->planner = planner;
+	reset();
+	if(planner) connect(planner, SIGNAL(dataChanged()), this, SLOT(updatePlannerData()));
+}
+
+void PerformanceWidget::reset() {
+	samples.clear();
+	lastCallCount = planner ? planner->callCount() : 0;
+	calcTimeLabel->setText("---");
+	percentileLabel->setText(tr("p50: ---   p95: ---   p99: ---"));
+	phaseTimeLabel->clear();
+	histogram->clear();
+	updateRates();
+}
+
+QString PerformanceWidget::formatBytes(int64_t bytes) {
+	if(bytes >= 1024 * 1024 * 1024) return QString("%1 GiB").arg(bytes / (1024.0 * 1024.0 * 1024.0), 0, 'f', 2);
+	if(bytes >= 1024 * 1024) return QString("%1 MiB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+	if(bytes >= 1024) return QString("%1 KiB").arg(bytes / 1024.0, 0, 'f', 1);
+	return QString("%1 B").arg(bytes);
+}
+
+// formats a duration given in ns with 3 significant digits
+QString PerformanceWidget::formatDuration(int64_t ns) {
+	const char *unit = "ns";
+	qreal value = ns;
+	if(ns >= 1000000000) { value = ns / 1e9; unit = "s"; }
+	else if(ns >= 1000000) { value = ns / 1e6; unit = "ms"; }
+	else if(ns >= 1000) { value = ns / 1e3; unit = "\xc2\xb5s"; }
+	else return QString("%1 ns").arg(ns);
+	return QString("%1 %2").arg(value, 0, 'f', qMax(0, 2 - (int)log10(value))).arg(QString::fromUtf8(unit));
+}
+
+void PerformanceWidget::updatePlannerData() {
+	if(!planner) return;
+	
+	// dataChanged() is also emitted without planner call, e.g. for invalid start or goal poses
+	if(planner->callCount() != lastCallCount) {
+		lastCallCount = planner->callCount();
+		Sample sample;
+		sample.timeNs = clock.nsecsElapsed();
+		sample.calcTimeNs = planner->calcTimeNs();
+		sample.expansions = planner->counters().expansions;
+		samples.push_back(sample);
+		if(samples.size() > maxSamples) samples.removeFirst();
+		
+		QVector<int64_t> times;
+		foreach(const Sample &s, samples) times.push_back(s.calcTimeNs);
+		std::sort(times.begin(), times.end());
+		int64_t p50 = percentile(times, 0.5), p95 = percentile(times, 0.95), p99 = percentile(times, 0.99);
+		percentileLabel->setText(tr("p50: %1   p95: %2   p99: %3").arg(formatDuration(p50)).arg(formatDuration(p95)).arg(formatDuration(p99)));
+		histogram->setData(times, p50, p95, p99);
+		histogram->setToolTip(tr("calculation times of the last %1 planner calls").arg(samples.size()));
+		updateRates();
+	}
+	
+	int64_t calcTime = planner->calcTimeNs();
+	if(calcTime < 0) {
+		calcTimeLabel->setText("---");
+		phaseTimeLabel->clear();
+		return;
+	}
+	calcTimeLabel->setText(formatDuration(calcTime));
+	QStringList phases;
+	for(int i = 0; i < AbstractPlanner::NumTimingPhases; i++) {
+		AbstractPlanner::TimingPhase phase = (AbstractPlanner::TimingPhase)i;
+		phases << QString("%1: %2").arg(AbstractPlanner::phaseName(phase)).arg(formatDuration(planner->phaseTimeNs(phase)));
+	}
+	const PerfCounters::Values &hw = planner->hardwareCounters();
+	if(hw.isValid()) {
+		phases << QString();
+		for(int i = 0; i < PerfCounters::NumEvents; i++) {
+			PerfCounters::Event event = (PerfCounters::Event)i;
+			if(hw[event] >= 0) phases << QString("%1: %2").arg(PerfCounters::eventName(event)).arg(hw[event]);
+		}
+		if(hw[PerfCounters::Cycles] > 0 && hw[PerfCounters::Instructions] >= 0) {
+			phases << QString("IPC: %1").arg((double)hw[PerfCounters::Instructions] / hw[PerfCounters::Cycles], 0, 'f', 2);
+		}
+	}
+	if(AllocationCounters::available()) {
+		const AllocationCounters::Values &allocations = planner->allocations();
+		phases << QString() << tr("allocations: %1 (%2)").arg(allocations.allocations).arg(formatBytes(allocations.bytes));
+	}
+	phaseTimeLabel->setText(phases.join("\n"));
+}
+
+/* replans/s over the last seconds, expansions per second of calculation time over all samples;
+ * also called by a timer, so the replanning rate decays when the planner is idle
+ */
+void PerformanceWidget::updateRates() {
+	int64_t now = clock.nsecsElapsed();
+	int numRecent = 0;
+	int64_t calcTimeNs = 0;
+	uint64_t expansions = 0;
+	foreach(const Sample &s, samples) {
+		if(now - s.timeNs <= rateWindowNs) numRecent++;
+		calcTimeNs += s.calcTimeNs;
+		expansions += s.expansions;
+	}
+	
+	QStringList lines;
+	lines << tr("replans/s: %1").arg(numRecent * 1e9 / rateWindowNs, 0, 'f', 1);
+	if(!AbstractPlanner::countersEnabled()) lines << tr("expansions/s: n/a (counters disabled)");
+	else if(calcTimeNs <= 0) lines << tr("expansions/s: ---");
+	else lines << tr("expansions/s: %1 M").arg(expansions * 1e3 / calcTimeNs, 0, 'f', 2);
+	// not while the planning thread calculates a path (see AbstractPlanner::setBackgroundPlanning())
+	if(planner && planner->dataMutex()->tryLock()) {
+		lines << tr("memory: %1 (peak %2)").arg(formatBytes(planner->memoryUsage())).arg(formatBytes(planner->peakMemoryUsage()));
+		for(int i = 0; i < AbstractPlanner::NumMemoryComponents; i++) {
+			AbstractPlanner::MemoryComponent component = (AbstractPlanner::MemoryComponent)i;
+			if(planner->peakMemoryUsage(component) > 0) {
+				lines << QString("  %1: %2").arg(AbstractPlanner::memoryComponentName(component)).arg(formatBytes(planner->memoryUsage(component)));
+			}
+		}
+		planner->dataMutex()->unlock();
+	}
+	int64_t memory = residentMemory();
+	lines << tr("memory (process): %1").arg(memory < 0 ? QString("---") : formatBytes(memory));
+	rateLabel->setText(lines.join("\n"));
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PERFORMANCEWIDGET_H
+#define PERFORMANCEWIDGET_H
+
+#include <QWidget>
+#include <QList>
+#include <QElapsedTimer>
+#include <stdint.h>
+class QLabel;
+class QTimer;
+class AbstractPlanner;
+class LatencyHistogram;
+
+/* Contents of the performance dock: calculation time of the last planner call and rolling statistics 
+ * of the recent calls (latency percentiles and histogram, expansions per second of calculation time,
+ * replans per second, planner and process memory); the statistics are reset when another planner is set
+ */
+class PerformanceWidget: public QWidget {
+	Q_OBJECT
+public:
+	PerformanceWidget(QWidget *parent = 0);
+	
+	void setPlanner(AbstractPlanner *planner);
+	
+	static QString formatDuration(int64_t ns);
+	static QString formatBytes(int64_t bytes);
+	
+public slots:
+	void reset();
+	
+private slots:
+	void updatePlannerData();
+	void updateRates();
+	
+private:
+	struct Sample {
+		int64_t timeNs;		// end of the call, relative to clock
+		int64_t calcTimeNs;
+		uint64_t expansions;
+	};
+	QList<Sample> samples; // the most recent maxSamples calls
+	enum { maxSamples = 500 };
+	
+	AbstractPlanner *planner;
+	unsigned lastCallCount;
+	QElapsedTimer clock;
+	QTimer *rateTimer;
+	
+	QLabel *calcTimeLabel;
+	QLabel *percentileLabel;
+	LatencyHistogram *histogram;
+	QLabel *rateLabel;
+	QLabel *phaseTimeLabel;
+};
+
+#endif // PERFORMANCEWIDGET_H
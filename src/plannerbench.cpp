@@ -0,0 +1,194 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "plannerbench.h"
+#include "abstractplanner.h"
+#include "plannerfactory.h"
+#include "metricsexporter.h"
+#include "xorshift.h"
+#include <QElapsedTimer>
+#include <QMap>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+
+MetricsExporter *PlannerBench::metricsExporter = NULL;
+int64_t PlannerBench::budgetNs = 0;
+uint64_t PlannerBench::budgetExpansions = 0;
+
+PlannerBench::PlannerBench(PlannerFactoryBase *factory):
+	_planner(factory->create()),
+	_name(factory->name()),
+	startCallCount(0), maxCallNs(0)
+{
+	_planner->setBudget(budgetNs, budgetExpansions);
+}
+
+PlannerBench::~PlannerBench() {
+	delete _planner;
+}
+
+void PlannerBench::setMap(const QImage &map) {
+	_planner->setMap(map);
+}
+
+PlannerBench::Result PlannerBench::run(const Query &query) {
+	QElapsedTimer timer;
+	timer.start();
+	startCallCount = _planner->callCount();
+	_planner->setStartGoal(QPointF(query.start), QPointF(query.goal));
+	completePlan();
+	return collectResult(timer.nsecsElapsed());
+}
+
+PlannerBench::Result PlannerBench::update(const QImage &map, const QRect &updateRegion) {
+	QElapsedTimer timer;
+	timer.start();
+	startCallCount = _planner->callCount();
+	_planner->updateMap(map, updateRegion);
+	completePlan();
+	return collectResult(timer.nsecsElapsed());
+}
+
+PlannerBench::Result PlannerBench::load(const QImage &map, const Pose2D &start, const Pose2D &goal) {
+	QElapsedTimer timer;
+	timer.start();
+	startCallCount = _planner->callCount();
+	_planner->setMap(map);
+	if(start.isValid()) _planner->setStart(start);
+	if(goal.isValid()) _planner->setGoal(goal);
+	completePlan();
+	return collectResult(timer.nsecsElapsed());
+}
+
+PlannerBench::Result PlannerBench::setStart(const Pose2D &start) {
+	QElapsedTimer timer;
+	timer.start();
+	startCallCount = _planner->callCount();
+	_planner->setStart(start);
+	completePlan();
+	return collectResult(timer.nsecsElapsed());
+}
+
+PlannerBench::Result PlannerBench::setGoal(const Pose2D &goal) {
+	QElapsedTimer timer;
+	timer.start();
+	startCallCount = _planner->callCount();
+	_planner->setGoal(goal);
+	completePlan();
+	return collectResult(timer.nsecsElapsed());
+}
+
+// resumes an incomplete plan and sums up the counters of the calls since startCallCount
+void PlannerBench::completePlan() {
+	counters = _planner->counters();
+	maxCallNs = 0;
+	if(_planner->callCount() == startCallCount) return;
+	maxCallNs = _planner->calcTimeNs();
+	while(!_planner->planComplete()) {
+		// the interrupted calls are exported as such, collectResult() records the last call
+		if(metricsExporter) metricsExporter->recordCall(_planner, _name);
+		unsigned callCount = _planner->callCount();
+		_planner->continuePlanning();
+		if(_planner->callCount() == callCount) break;
+		maxCallNs = qMax(maxCallNs, _planner->calcTimeNs());
+		counters += _planner->counters();
+	}
+}
+
+PlannerBench::Result PlannerBench::collectResult(int64_t timeNs) const {
+	Result result;
+	result.timeNs = timeNs;
+	result.plannerCalls = _planner->callCount() - startCallCount;
+	result.maxCallNs = maxCallNs;
+	
+	const Path &path = _planner->path();
+	result.pathCells = path.size();
+	result.pathLength = pathLength(path);
+	result.pathCost = path.empty() ? -1 : pathCost(path);
+	result.counters = counters;
+	result.hardwareCounters = _planner->hardwareCounters();
+	result.memoryBytes = _planner->memoryUsage();
+	result.allocations = _planner->allocations();
+	for(int i = 0; i < AbstractPlanner::NumTimingPhases; i++) result.phaseNs[i] = _planner->phaseTimeNs((AbstractPlanner::TimingPhase)i);
+	if(path.empty()) result.error = _planner->lastError();
+	if(metricsExporter) metricsExporter->recordCall(_planner, _name);
+	return result;
+}
+
+qreal PlannerBench::pathLength(const Path &path) {
+	qreal length = 0.0;
+	for(int i = 1; i < path.size(); i++) {
+		qreal dx = path[i].x() - path[i - 1].x();
+		qreal dy = path[i].y() - path[i - 1].y();
+		length += sqrt(dx * dx + dy * dy);
+	}
+	return length;
+}
+
+qint64 PlannerBench::pathCost(const Path &path) {
+	qint64 cost = 0;
+	for(int i = 1; i < path.size(); i++) {
+		qreal dx = fabs(path[i].x() - path[i - 1].x());
+		qreal dy = fabs(path[i].y() - path[i - 1].y());
+		if(dx <= 1.0 && dy <= 1.0) cost += (dx > 0.0 && dy > 0.0) ? 7 : 5;
+		else cost += qRound64(5.0 * sqrt(dx * dx + dy * dy)); // not a grid step
+	}
+	return cost;
+}
+
+PlannerBench::Queries PlannerBench::randomQueries(const QImage &map, int count, unsigned seed) {
+	Queries queries;
+	
+	// count free cells; the cells are only looked up for the drawn indices, so large maps need no list of all free cells
+	qint64 numFree = 0;
+	for(int y = 0; y < map.height(); y++) {
+		const unsigned char *pCost = (const unsigned char *)map.scanLine(y);
+		for(int x = 0; x < map.width(); x++) {
+			if(*pCost++ == 0) numFree++;
+		}
+	}
+	if(numFree < 2) return queries;
+	
+	XorShift32 rng(seed);
+	QVector<qint64> indices;
+	for(int i = 0; i < count; i++) {
+		qint64 idx[2];
+		do {
+			for(unsigned j = 0; j < 2; j++) idx[j] = rng.bounded((unsigned)numFree);
+		} while(idx[0] == idx[1]);
+		indices << idx[0] << idx[1];
+	}
+	
+	// find the cells of the sorted indices in a second pass
+	QVector<qint64> sorted = indices;
+	std::sort(sorted.begin(), sorted.end());
+	QMap<qint64, QPoint> cells;
+	qint64 freeIdx = 0;
+	int next = 0;
+	for(int y = 0; y < map.height() && next < sorted.size(); y++) {
+		const unsigned char *pCost = (const unsigned char *)map.scanLine(y);
+		for(int x = 0; x < map.width() && next < sorted.size(); x++) {
+			if(pCost[x] != 0) continue;
+			while(next < sorted.size() && sorted[next] == freeIdx) cells[sorted[next++]] = QPoint(x, y);
+			freeIdx++;
+		}
+	}
+	for(int i = 0; i < count; i++) queries.push_back(Query(cells[indices[2 * i]], cells[indices[2 * i + 1]]));
+	return queries;
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PLANNERBENCH_H
+#define PLANNERBENCH_H
+
+#include <QImage>
+#include <QPoint>
+#include <QList>
+#include <QString>
+#include <stdint.h>
+#include "data.h"
+#include "abstractplanner.h"
+class PlannerFactoryBase;
+class MetricsExporter;
+
+/* Runs start/goal queries on a single planner instance without any GUI
+ * and measures the wall time of each query
+ */
+class PlannerBench {
+public:
+	PlannerBench(PlannerFactoryBase *factory);
+	~PlannerBench();
+	
+	struct Query {
+		Query(): bucket(-1), optimalLength(0.0) { }
+		Query(const QPoint &start, const QPoint &goal, int bucket = -1, qreal optimalLength = 0.0):
+			start(start), goal(goal), bucket(bucket), optimalLength(optimalLength) { }
+		QPoint start, goal;
+		int bucket; // scenario bucket, -1 for generated queries
+		qreal optimalLength; // reference length, 0 if unknown
+	};
+	typedef QList<Query> Queries;
+	
+	struct Result {
+		Result(): timeNs(-1), plannerCalls(0), maxCallNs(0), pathCells(0), pathLength(0.0), pathCost(-1), memoryBytes(0) { 
+			for(int i = 0; i < AbstractPlanner::NumTimingPhases; i++) phaseNs[i] = 0;
+		}
+		bool success() const { return pathCells > 0; }
+		/* ratio of the found path length to the reference, 0 if there is no reference or no path;
+		 * MovingAI references forbid cutting corners, so values slightly below 1 are possible
+		 */
+		qreal suboptimality(const Query &query) const { return (success() && query.optimalLength > 0.0) ? pathLength / query.optimalLength : 0.0; }
+		int64_t timeNs;
+		int plannerCalls; // more than one if the plan has been resumed (planner budget)
+		int64_t maxCallNs; // calculation time of the longest planner call
+		int64_t phaseNs[AbstractPlanner::NumTimingPhases];
+		int pathCells;
+		qreal pathLength;
+		qint64 pathCost; // see pathCost(), -1 if there is no path
+		AbstractPlanner::Counters counters; // of all calls
+		PerfCounters::Values hardwareCounters; // of calculatePath(), if enabled
+		int64_t memoryBytes; // AbstractPlanner::memoryUsage() after the call
+		AllocationCounters::Values allocations; // of the planner call, if AllocationCounters::available()
+		QString error;
+	};
+	
+	/* with a planner budget (see AbstractPlanner::setBudget()), incomplete plans are resumed until they are
+	 * complete; the results cover all calls
+	 */
+	AbstractPlanner *planner() { return _planner; }
+	const QString &plannerName() const { return _name; }
+	
+	void setMap(const QImage &map);
+	Result run(const Query &query);
+	// passes a modified map to the planner (see AbstractPlanner::updateMap()) and measures the replanning
+	Result update(const QImage &map, const QRect &updateRegion);
+	
+	/* the planner calls of the GUI for a new map or planner: setMap(), then setStart() and setGoal()
+	 * for valid poses (see VisualizationWidget); measured as a whole
+	 */
+	Result load(const QImage &map, const Pose2D &start, const Pose2D &goal);
+	Result setStart(const Pose2D &start);
+	Result setGoal(const Pose2D &goal);
+	
+	// picks <count> pairs of distinct free cells, the same seed always gives the same queries
+	static Queries randomQueries(const QImage &map, int count, unsigned seed);	
+	static qreal pathLength(const Path &path);
+	/* sum of the step costs on the 5/7 scale of FD* and D* Lite (A* and D* use 10/14, i.e. the same costs doubled),
+	 * so path costs of all planners can be compared exactly
+	 */
+	static qint64 pathCost(const Path &path);
+	
+	// every measured planner call is recorded by this exporter if not NULL
+	static void setMetricsExporter(MetricsExporter *exporter) { metricsExporter = exporter; }
+	// budget of the planners created afterwards, see AbstractPlanner::setBudget()
+	static void setPlannerBudget(int64_t timeNs, uint64_t expansions) { budgetNs = timeNs; budgetExpansions = expansions; }
+	static bool plannerBudgetSet() { return budgetNs > 0 || budgetExpansions > 0; }
+
+private:
+	void completePlan();
+	Result collectResult(int64_t timeNs) const;
+	
+	AbstractPlanner *_planner;
+	QString _name;
+	// calls of the last measurement, see completePlan()
+	unsigned startCallCount;
+	int64_t maxCallNs;
+	AbstractPlanner::Counters counters;
+	
+	static MetricsExporter *metricsExporter;
+	static int64_t budgetNs;
+	static uint64_t budgetExpansions;
+};
+
+#endif // PLANNERBENCH_H
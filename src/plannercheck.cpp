@@ -0,0 +1,241 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "plannercheck.h"
+#include <QFile>
+#include <QHash>
+#include <QStringList>
+#include <QTextStream>
+#include <cstdio>
+
+static const char *baselineHeader = "rastersim check baseline 1";
+
+// differences below this are not reported as time regressions, single queries on small maps are too noisy
+static const int64_t minTimeRegressionNs = 1000000;
+
+PlannerCheck::PlannerCheck():
+	_timeTolerance(0.2), _expansionTolerance(0.05)
+{
+	
+}
+
+void PlannerCheck::setTolerances(qreal time, qreal expansions) {
+	_timeTolerance = time;
+	_expansionTolerance = expansions;
+}
+
+static QString rowName(const BenchReport::Row &row) {
+	return QString("%1 %2 %3").arg(row.map).arg(row.updateRegion.isEmpty() ? "query" : "update").arg(row.index);
+}
+
+static bool sameQuery(const BenchReport::Row &r1, const BenchReport::Row &r2) {
+	return r1.map == r2.map && r1.index == r2.index && r1.updateRegion == r2.updateRegion &&
+		r1.query.start == r2.query.start && r1.query.goal == r2.query.goal;
+}
+
+int PlannerCheck::checkEquivalence(const BenchReport &report) {
+	QStringList planners;
+	QHash<QString, QList<const BenchReport::Row *> > rows;
+	foreach(const BenchReport::Row &r, report.rows()) {
+		if(!rows.contains(r.planner)) planners.push_back(r.planner);
+		rows[r.planner].push_back(&r);
+	}
+	QStringList optimal;
+	foreach(const QString &planner, planners) if(_optimalPlanners.contains(planner)) optimal.push_back(planner);
+	int numRows = planners.isEmpty() ? 0 : rows[planners.first()].size();
+	
+	printf("\n### check: path costs of %d planners (%d optimal) on %d queries\n", planners.size(), optimal.size(), numRows);
+	foreach(const QString &planner, planners) {
+		if(rows[planner].size() != numRows) {
+			printf("FAIL %s ran %d instead of %d queries, results are not comparable\n", qPrintable(planner), rows[planner].size(), numRows);
+			return 1;
+		}
+	}
+	
+	/* a planner call without path sets the reason as error, "No Path set" is what AbstractPlanner sets if it
+	 * has not (e.g. a planner that has lost track of an interrupted search)
+	 */
+	int unexplained = 0;
+	foreach(const QString &planner, planners) {
+		foreach(const BenchReport::Row *r, rows[planner]) {
+			if(r->result.pathCost >= 0 || r->result.error != "No Path set") continue;
+			unexplained++;
+			printf("FAIL %s: %s returned neither a path nor an error\n", qPrintable(rowName(*r)), qPrintable(planner));
+		}
+	}
+	if(unexplained) printf("check: %d results without path and error\n", unexplained);
+	if(optimal.isEmpty()) {
+		printf("no optimal planner selected, path costs are only checked against a baseline\n");
+		return unexplained;
+	}
+	
+	int failures = 0;
+	for(int i = 0; i < numRows; i++) {
+		const BenchReport::Row &ref = *rows[optimal.first()][i];
+		foreach(const QString &planner, planners) {
+			const BenchReport::Row &r = *rows[planner][i];
+			if(!sameQuery(r, ref)) {
+				printf("FAIL %s ran %s where %s ran %s, results are not comparable\n", qPrintable(planner), qPrintable(rowName(r)),
+					   qPrintable(ref.planner), qPrintable(rowName(ref)));
+				return failures + 1;
+			}
+			qint64 cost = r.result.pathCost, refCost = ref.result.pathCost;
+			bool fail;
+			if(optimal.contains(planner)) fail = (cost != refCost);
+			else fail = (refCost < 0) ? (cost >= 0) : (cost < 0 || cost < refCost);
+			if(!fail) continue;
+			failures++;
+			printf("FAIL %s: %s cost %lld, %s cost %lld%s\n", qPrintable(rowName(r)), qPrintable(planner), (long long)cost, 
+				   qPrintable(ref.planner), (long long)refCost, (cost >= 0 && cost < refCost) ? " (cheaper than optimal)" : "");
+		}
+	}
+	printf("check: %d path cost mismatches\n", failures);
+	return failures + unexplained;
+}
+
+QList<PlannerCheck::Totals> PlannerCheck::totals(const BenchReport &report) {
+	QList<Totals> result;
+	QHash<QString, int> index;
+	foreach(const BenchReport::Row &r, report.rows()) {
+		QString key = r.planner + '\t' + r.map;
+		if(!index.contains(key)) {
+			index[key] = result.size();
+			result.push_back(Totals());
+			result.last().planner = r.planner;
+			result.last().map = r.map;
+		}
+		Totals &t = result[index[key]];
+		t.timeNs += r.result.timeNs;
+		t.expansions += r.result.counters.expansions;
+		t.costs.push_back(r.result.pathCost);
+	}
+	return result;
+}
+
+static QString change(double now, double base) {
+	return base > 0.0 ? QString().sprintf("%+.1f%%", 100.0 * (now - base) / base) : QString("-");
+}
+
+int PlannerCheck::checkBaseline(const BenchReport &report) {
+	QHash<QString, const Totals *> baseline;
+	foreach(const Totals &t, _baseline) baseline[t.planner + '\t' + t.map] = &t;
+	
+	printf("\n### check: baseline (tolerances: time %+.0f%%, expansions %+.0f%%)\n", 100.0 * _timeTolerance, 100.0 * _expansionTolerance);
+	printf("%-22s %-32s %12s %12s %8s %12s %12s %8s %s\n", "planner", "map", "base [ms]", "time [ms]", "change", 
+		   "base exp.", "expanded", "change", "status");
+	QStringList messages;
+	int failures = 0;
+	foreach(const Totals &t, totals(report)) {
+		const Totals *base = baseline.value(t.planner + '\t' + t.map);
+		if(!base) {
+			printf("%-22s %-32s %12s %12.3f %8s %12s %12llu %8s %s\n", qPrintable(t.planner), qPrintable(t.map), "-", t.timeNs * 1e-6, "", 
+				   "-", (unsigned long long)t.expansions, "", "no baseline");
+			continue;
+		}
+		QStringList problems;
+		if(t.costs.size() != base->costs.size()) {
+			problems << "queries";
+			messages << QString("FAIL %1 on %2: %3 queries, baseline has %4").arg(t.planner).arg(t.map).arg(t.costs.size()).arg(base->costs.size());
+		} else {
+			int numChanged = 0;
+			for(int i = 0; i < t.costs.size(); i++) {
+				if(t.costs[i] == base->costs[i]) continue;
+				if(numChanged++ < 10) {
+					messages << QString("FAIL %1 on %2: path cost of query %3 changed from %4 to %5").arg(t.planner).arg(t.map).arg(i)
+						.arg(base->costs[i]).arg(t.costs[i]);
+				}
+			}
+			if(numChanged > 10) messages << QString("FAIL %1 on %2: %3 more path costs changed").arg(t.planner).arg(t.map).arg(numChanged - 10);
+			if(numChanged) problems << "path cost";
+		}
+		if(t.timeNs > base->timeNs * (1.0 + _timeTolerance) && t.timeNs - base->timeNs > minTimeRegressionNs) problems << "time";
+		if(base->expansions > 0 && t.expansions > base->expansions * (1.0 + _expansionTolerance)) problems << "expansions";
+		if(!problems.isEmpty()) failures++;
+		
+		printf("%-22s %-32s %12.3f %12.3f %8s %12llu %12llu %8s %s\n", qPrintable(t.planner), qPrintable(t.map), 
+			   base->timeNs * 1e-6, t.timeNs * 1e-6, qPrintable(change(t.timeNs, base->timeNs)), 
+			   (unsigned long long)base->expansions, (unsigned long long)t.expansions, qPrintable(change(t.expansions, base->expansions)),
+			   problems.isEmpty() ? "ok" : qPrintable("FAIL (" + problems.join(", ") + ")"));
+	}
+	foreach(const QString &message, messages) printf("%s\n", qPrintable(message));
+	printf("check: %d regressions against the baseline\n", failures);
+	return failures;
+}
+
+bool PlannerCheck::loadBaseline(const QString &fileName) {
+	_baseline.clear();
+	_lastError.clear();
+	
+	QFile file(fileName);
+	if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		_lastError = QString("Could not open baseline file \"%1\"").arg(fileName);
+		return false;
+	}
+	QTextStream in(&file);
+	if(in.readLine() != baselineHeader) {
+		_lastError = QString("\"%1\" is not a check baseline").arg(fileName);
+		return false;
+	}
+	int lineNo = 1;
+	while(!in.atEnd()) {
+		QString line = in.readLine();
+		lineNo++;
+		if(line.trimmed().isEmpty()) continue;
+		
+		QStringList fields = line.split('\t');
+		bool ok = (fields.size() == 6);
+		Totals t;
+		int numRuns = 0;
+		if(ok) {
+			t.planner = fields[0];
+			t.map = fields[1];
+			numRuns = fields[2].toInt(&ok);
+		}
+		if(ok) t.timeNs = fields[3].toLongLong(&ok);
+		if(ok) t.expansions = fields[4].toULongLong(&ok);
+		if(ok && numRuns > 0) {
+			QStringList costs = fields[5].split(',');
+			ok = (costs.size() == numRuns);
+			for(int i = 0; ok && i < costs.size(); i++) t.costs.push_back(costs[i].toLongLong(&ok));
+		}
+		if(!ok) {
+			_lastError = QString("%1:%2: invalid baseline entry").arg(fileName).arg(lineNo);
+			_baseline.clear();
+			return false;
+		}
+		_baseline.push_back(t);
+	}
+	return true;
+}
+
+bool PlannerCheck::saveBaseline(const BenchReport &report, const QString &fileName) {
+	QFile file(fileName);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+		_lastError = QString("Could not write \"%1\"").arg(fileName);
+		return false;
+	}
+	QTextStream out(&file);
+	out << baselineHeader << '\n';
+	foreach(const Totals &t, totals(report)) {
+		QStringList costs;
+		foreach(qint64 cost, t.costs) costs << QString::number(cost);
+		out << t.planner << '\t' << t.map << '\t' << t.costs.size() << '\t' << (qlonglong)t.timeNs << '\t' 
+			<< (qulonglong)t.expansions << '\t' << costs.join(",") << '\n';
+	}
+	return true;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PLANNERCHECK_H
+#define PLANNERCHECK_H
+
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <stdint.h>
+#include "benchreport.h"
+
+/* Cross-planner equivalence and regression checks on the results of a benchmark run (--check):
+ * - for each query (or map update), all optimal planners (see AbstractPlanner::isOptimal()) must find paths 
+ *   of the same cost; the other planners must not find cheaper paths or fail where an optimal planner succeeded
+ * - every result without path must come with the planner's reason (e.g. "No Path found"), also with a budget
+ *   whose interruptions are resumed
+ * - against a baseline saved by an earlier run, no path cost may change and the total time and expansions
+ *   of each planner on each map may not exceed the baseline by more than the tolerances
+ * Path costs are compared on the 5/7 scale (see PlannerBench::pathCost()). Failures are printed to stdout.
+ */
+class PlannerCheck {
+public:
+	PlannerCheck();
+	
+	void setOptimalPlanners(const QSet<QString> &planners) { _optimalPlanners = planners; }
+	// relative tolerances, e.g. 0.2 allows 20% more time than the baseline
+	void setTolerances(qreal time, qreal expansions);
+	
+	// all planners must have run the same queries in the same order, returns the number of failures
+	int checkEquivalence(const BenchReport &report);
+	int checkBaseline(const BenchReport &report);
+	
+	/* baseline file (text, one line per planner and map, fields separated by tabs):
+	 *   rastersim check baseline 1
+	 *   <planner> <map> <runs> <total time [ns]> <expansions> <path costs, comma separated>
+	 */
+	bool loadBaseline(const QString &fileName);
+	bool saveBaseline(const BenchReport &report, const QString &fileName);
+	const QString &lastError() const { return _lastError; }
+	
+private:
+	// the results of one planner on one map
+	struct Totals {
+		Totals(): timeNs(0), expansions(0) { }
+		QString planner, map;
+		int64_t timeNs;
+		uint64_t expansions;
+		QVector<qint64> costs;
+	};
+	static QList<Totals> totals(const BenchReport &report);
+	
+	QSet<QString> _optimalPlanners;
+	qreal _timeTolerance, _expansionTolerance;
+	QList<Totals> _baseline;
+	QString _lastError;
+};
+
+#endif // PLANNERCHECK_H
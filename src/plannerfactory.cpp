@@ -0,0 +1,42 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "plannerfactory.h"
+#include "astarplanner.h"
+#include "dstarplanner.h"
+#include "fdstarplanner.h"
+#include "dstarliteplanner.h"
+#include "hdastarplanner.h"
+#include "bidirectionalastarplanner.h"
+
+class FullInitFocussedDStarPlanner: public FocussedDStarPlanner {
+public: 
+	FullInitFocussedDStarPlanner(QObject *parent = 0): FocussedDStarPlanner(parent) { setFullInit(true); }
+};
+
+PlannerFactories createPlannerFactories() {
+	PlannerFactories factories;
+	factories.push_back(new GenericPlannerFactory<AStarPlanner>("A-Star (A*)"));
+	factories.push_back(new GenericPlannerFactory<DStarPlanner>("D-Star (D*)"));
+	factories.push_back(new GenericPlannerFactory<FocussedDStarPlanner>("Focussed D* (FD*)"));
+	factories.push_back(new GenericPlannerFactory<FullInitFocussedDStarPlanner>("FD* with full init."));
+	factories.push_back(new GenericPlannerFactory<DStarLitePlanner>("D* Lite"));
+	factories.push_back(new GenericPlannerFactory<HdaStarPlanner>("Hash-distributed A* (HDA*)"));
+	factories.push_back(new GenericPlannerFactory<BidirectionalAStarPlanner>("Bidirectional A*"));
+	return factories;
+}
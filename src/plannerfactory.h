@@ -0,0 +1,51 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PLANNERFACTORY_H
+#define PLANNERFACTORY_H
+
+#include <QString>
+#include <QList>
+class QObject;
+class AbstractPlanner;
+
+class PlannerFactoryBase {
+public:
+	PlannerFactoryBase(const QString &name = QString()): _name(name) { }
+	virtual ~PlannerFactoryBase() { }
+	const QString &name() const { return _name; }
+	virtual AbstractPlanner *create(QObject * = 0) = 0;		
+private:
+	QString _name;
+};
+
+template <typename T>
+class GenericPlannerFactory: public PlannerFactoryBase {
+public:
+	GenericPlannerFactory(const QString &name = QString()): PlannerFactoryBase(name) { }
+	AbstractPlanner *create(QObject *parent = 0) { return new T(parent); }
+};
+
+typedef QList<PlannerFactoryBase *> PlannerFactories;
+
+/* returns one factory for each available planner (in the order shown in the GUI),
+ * the caller takes ownership of the factories
+ */
+PlannerFactories createPlannerFactories();
+
+#endif // PLANNERFACTORY_H
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Microbenchmarks of the planners' hot kernels (heaps, processState, neighborhood iteration, path extraction),
+ * run on deterministic synthetic maps so results of different commits can be compared
+ */
+
+#include <QApplication>
+#include <QVector>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include "microbench.h"
+#include "astarplanner.h"
+#include "dstarplanner.h"
+#include "fdstarplanner.h"
+#include "dstarliteplanner.h"
+#include "maputils.h"
+#include "xorshift.h"
+
+// square map with scattered 3x3 obstacles (about 12% of the cells), the corners are kept free
+static QImage benchmarkMap(int size) {
+	QImage map(size, size, QImage::Format_Indexed8);
+	map.setColorTable(MapUtils::colorTable());
+	map.fill(0);
+	XorShift32 rng(1);
+	for(int i = 0; i < size * size / 64; i++) {
+		int x = rng.bounded(size - 2), y = rng.bounded(size - 2);
+		for(int dy = 0; dy < 3; dy++) memset(map.scanLine(y + dy) + x, 255, 3);
+	}
+	for(int i = 0; i < 2; i++) {
+		for(int dy = 0; dy < 3; dy++) {
+			memset(map.scanLine(i ? size - 1 - dy : dy), 0, 3);
+			memset(map.scanLine(i ? size - 1 - dy : dy) + size - 3, 0, 3);
+		}
+	}
+	return map;
+}
+
+static QVector<unsigned> randomKeys(int count, unsigned max, unsigned seed) {
+	QVector<unsigned> keys(count);
+	XorShift32 rng(seed);
+	for(int i = 0; i < count; i++) keys[i] = rng.bounded(max);
+	return keys;
+}
+
+// random permutation of 0 ... count - 1
+static QVector<int> randomOrder(int count, unsigned seed) {
+	QVector<int> order(count);
+	for(int i = 0; i < count; i++) order[i] = i;
+	XorShift32 rng(seed);
+	for(int i = count - 1; i > 0; i--) std::swap(order[i], order[rng.bounded(i + 1)]);
+	return order;
+}
+
+static const int heapMapSize = 64; // 4096 heap elements
+static const int searchMapSize = 256;
+static const unsigned dStarLiteObstacleCost = UINT_MAX - 10000000; // OBSTACLE_COST of dstarliteplanner.cpp
+
+class PlannerMicrobench {
+public:
+	// A*: inline binary heap (openListInsert/openListPop/openListDecreaseKey)
+	static void aStarHeapInsertPop(MicroBench::State &state) {
+		AStarPlanner planner;
+		planner.setMap(benchmarkMap(heapMapSize));
+		int n = heapMapSize * heapMapSize;
+		QVector<unsigned> keys = randomKeys(n, 100000, 1);
+		AStarPlanner::RasterElement *elements = planner.context.rasterElements;
+		
+		while(state.keepRunning()) {
+			planner.context.openListLength = 0;
+			for(int i = 0; i < n; i++) {
+				elements[i].f_cost = keys[i];
+				planner.context.openListInsert(elements + i);
+			}
+			while(planner.context.openListLength) planner.context.openListPop();
+		}
+		state.setItemsProcessed(state.iterations() * 2 * n);
+	}
+	
+	static void aStarHeapDecreaseKey(MicroBench::State &state) {
+		AStarPlanner planner;
+		planner.setMap(benchmarkMap(heapMapSize));
+		int n = heapMapSize * heapMapSize;
+		QVector<unsigned> keys = randomKeys(n, 100000, 1);
+		QVector<int> order = randomOrder(n, 2);
+		AStarPlanner::RasterElement *elements = planner.context.rasterElements;
+		
+		while(state.keepRunning()) {
+			state.pauseTiming();
+			planner.context.openListLength = 0;
+			for(int i = 0; i < n; i++) {
+				elements[i].f_cost = keys[i];
+				planner.context.openListInsert(elements + i);
+			}
+			state.resumeTiming();
+			for(int i = 0; i < n; i++) {
+				AStarPlanner::RasterElement *pRE = elements + order[i];
+				pRE->f_cost >>= 1;
+				planner.context.openListDecreaseKey(pRE);
+			}
+		}
+		state.setItemsProcessed(state.iterations() * n);
+	}
+	
+	// D* Lite: insert/remove/heapUp/heapDown
+	static void resetDStarLiteHeap(DStarLitePlanner &planner, const QVector<unsigned> &keys, bool insert) {
+		int n = planner.mapWidth() * planner.mapHeight();
+		planner.openListLength = 0;
+		for(int i = 0; i < n; i++) {
+			DStarLitePlanner::Cell &cell = planner.cells[i];
+			cell.heapIndex = 0;
+			cell.key = DStarLitePlanner::Key(keys[i], keys[i] >> 4);
+			if(insert) planner.insert(cell);
+		}
+	}
+	
+	static void dStarLiteHeapInsert(MicroBench::State &state) {
+		DStarLitePlanner planner;
+		planner.setMap(benchmarkMap(heapMapSize));
+		int n = heapMapSize * heapMapSize;
+		QVector<unsigned> keys = randomKeys(n, 100000, 1);
+		
+		while(state.keepRunning()) {
+			state.pauseTiming();
+			resetDStarLiteHeap(planner, keys, false);
+			state.resumeTiming();
+			for(int i = 0; i < n; i++) planner.insert(planner.cells[i]);
+		}
+		state.setItemsProcessed(state.iterations() * n);
+	}
+	
+	static void dStarLiteHeapUpdate(MicroBench::State &state) {
+		DStarLitePlanner planner;
+		planner.setMap(benchmarkMap(heapMapSize));
+		int n = heapMapSize * heapMapSize;
+		QVector<unsigned> keys = randomKeys(n, 100000, 1);
+		QVector<unsigned> newKeys = randomKeys(n, 100000, 3);
+		QVector<int> order = randomOrder(n, 2);
+		
+		while(state.keepRunning()) {
+			state.pauseTiming();
+			resetDStarLiteHeap(planner, keys, true);
+			state.resumeTiming();
+			// key changes in both directions: exercises heapUp and heapDown
+			for(int i = 0; i < n; i++) {
+				DStarLitePlanner::Cell &cell = planner.cells[order[i]];
+				cell.key = DStarLitePlanner::Key(newKeys[i], newKeys[i] >> 4);
+				planner.insert(cell);
+			}
+		}
+		state.setItemsProcessed(state.iterations() * n);
+	}
+	
+	static void dStarLiteHeapRemove(MicroBench::State &state) {
+		DStarLitePlanner planner;
+		planner.setMap(benchmarkMap(heapMapSize));
+		int n = heapMapSize * heapMapSize;
+		QVector<unsigned> keys = randomKeys(n, 100000, 1);
+		QVector<int> order = randomOrder(n, 2);
+		
+		while(state.keepRunning()) {
+			state.pauseTiming();
+			resetDStarLiteHeap(planner, keys, true);
+			state.resumeTiming();
+			for(int i = 0; i < n; i++) planner.remove(planner.cells[order[i]]);
+		}
+		state.setItemsProcessed(state.iterations() * n);
+	}
+	
+	// D*: processState until the open list is empty, i.e. a full expansion of the map from the goal
+	static void dStarProcessState(MicroBench::State &state) {
+		DStarPlanner planner;
+		planner.setMap(benchmarkMap(searchMapSize));
+		int n = searchMapSize * searchMapSize;
+		DStarPlanner::Cell *pGoal = planner.cells + n - 1;
+		int64_t calls = 0;
+		
+		while(state.keepRunning()) {
+			state.pauseTiming();
+			// same initialization as in DStarPlanner::doCalculatePath()
+			for(DStarPlanner::Cell *pCell = planner.cells; pCell < planner.cells + n; pCell++) {
+				pCell->list = DStarPlanner::List_New;
+				pCell->backPtr = NULL;
+				pCell->heapIndex = 0;
+				pCell->h_cost = 0;
+			}
+			planner.openListLength = 1;
+			pGoal->k_cost = pGoal->h_cost = 0;
+			pGoal->list = DStarPlanner::List_Open;
+			pGoal->heapIndex = 1;
+			planner.openHeap[1] = pGoal;
+			state.resumeTiming();
+			
+			while(planner.openListLength) {
+				planner.processState<false>(false);
+				calls++;
+			}
+		}
+		state.setItemsProcessed(calls);
+	}
+	
+	// Focussed D*: getMinState with a moving robot, which requires refocussing open cells
+	static void fdStarGetMinState(MicroBench::State &state) {
+		FocussedDStarPlanner planner;
+		planner.setMap(benchmarkMap(searchMapSize));
+		planner.setStartGoal(QPointF(1, 1), QPointF(searchMapSize - 2, searchMapSize - 2));
+		FocussedDStarPlanner::Cell *robots[2] = { planner.cells + searchMapSize + 1, planner.cells + 2 * searchMapSize - 2 };
+		
+		unsigned i = 0;
+		while(state.keepRunning()) {
+			planner.pRobot = robots[i++ & 1];
+			MicroBench::doNotOptimize(planner.getMinState());
+		}
+		state.setItemsProcessed(state.iterations());
+	}
+	
+	// D* Lite: rhs calculation over all cells, neighborhoods accessed with at() (as in the planner) or operator[]
+	template<bool checked> static void dStarLiteNeighborhoods(MicroBench::State &state) {
+		DStarLitePlanner planner;
+		planner.setMap(benchmarkMap(searchMapSize));
+		planner.setStartGoal(QPointF(1, 1), QPointF(searchMapSize - 2, searchMapSize - 2));
+		int n = searchMapSize * searchMapSize;
+		
+		while(state.keepRunning()) {
+			unsigned sum = 0;
+			for(const DStarLitePlanner::Cell *pCell = planner.cells; pCell < planner.cells + n; pCell++) {
+				const DStarLitePlanner::Neighborhood &neighborhood = checked ? planner.neighborhoods.at(pCell->neighborhoodIndex) 
+																			 : planner.neighborhoods[pCell->neighborhoodIndex];
+				unsigned minCost = dStarLiteObstacleCost;
+				for(unsigned j = 1; j < neighborhood.size(); j++) {
+					const DStarLitePlanner::Cell *pNeighbor = pCell + neighborhood[j].ptrOffset;
+					if(pNeighbor->blocked) continue;
+					unsigned cost = pNeighbor->g_cost;
+					if(cost < dStarLiteObstacleCost) cost += neighborhood[j].baseCost;
+					if(cost < minCost) minCost = cost;
+				}
+				sum += minCost;
+			}
+			MicroBench::doNotOptimize(sum);
+		}
+		state.setItemsProcessed(state.iterations() * n);
+	}
+	
+	// D* Lite: debug layer update and gradient descent path extraction
+	static void dStarLitePathExtract(MicroBench::State &state) {
+		DStarLitePlanner planner;
+		planner.setMap(benchmarkMap(searchMapSize));
+		planner.setStartGoal(QPointF(1, 1), QPointF(searchMapSize - 2, searchMapSize - 2));
+		
+		while(state.keepRunning()) planner.doDebugAndPathExtract(true);
+		state.setItemsProcessed(state.iterations() * planner.path().size());
+	}
+};
+
+MICROBENCHMARK(AStar_HeapInsertPop, PlannerMicrobench::aStarHeapInsertPop)
+MICROBENCHMARK(AStar_HeapDecreaseKey, PlannerMicrobench::aStarHeapDecreaseKey)
+MICROBENCHMARK(DStarLite_HeapInsert, PlannerMicrobench::dStarLiteHeapInsert)
+MICROBENCHMARK(DStarLite_HeapUpdate, PlannerMicrobench::dStarLiteHeapUpdate)
+MICROBENCHMARK(DStarLite_HeapRemove, PlannerMicrobench::dStarLiteHeapRemove)
+MICROBENCHMARK(DStar_ProcessState, PlannerMicrobench::dStarProcessState)
+MICROBENCHMARK(FDStar_GetMinState, PlannerMicrobench::fdStarGetMinState)
+MICROBENCHMARK(DStarLite_NeighborhoodsAt, PlannerMicrobench::dStarLiteNeighborhoods<true>)
+MICROBENCHMARK(DStarLite_NeighborhoodsIndex, PlannerMicrobench::dStarLiteNeighborhoods<false>)
+MICROBENCHMARK(DStarLite_PathExtract, PlannerMicrobench::dStarLitePathExtract)
+
+int main(int argc, char *argv[]) {
+	QApplication app(argc, argv, false); // no GUI, planners only need QtGui's image and action classes
+	return MicroBench::run(argc, argv);
+}
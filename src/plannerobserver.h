@@ -0,0 +1,59 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PLANNEROBSERVER_H
+#define PLANNEROBSERVER_H
+
+#include <QImage>
+
+/* Receives the search events of a planner, see AbstractPlanner::addObserver(). Planners instantiate their
+ * search loops with and without events, so events cost nothing while no observer is attached.
+ * Only the search loops report events, map updates do not.
+ */
+class PlannerObserver {
+public:
+	virtual ~PlannerObserver() { }
+	virtual void expanded(int /*x*/, int /*y*/) { }		// taken from the open list
+	virtual void opened(int /*x*/, int /*y*/) { }		// added to the open list
+	virtual void closed(int /*x*/, int /*y*/) { }		// removed from the open list (A*, D*, FD*: when expanded)
+	virtual void keyUpdated(int /*x*/, int /*y*/) { }	// key of a cell on the open list changed
+};
+
+// marks the cells of the selected events in a debug image (Format_Indexed8) with a color index
+class DebugImageObserver: public PlannerObserver {
+public:
+	enum Event {
+		Expanded = 1,
+		Opened = 2,
+		Closed = 4,
+		KeyUpdated = 8
+	};
+	DebugImageObserver(QImage &image, int events, uint colorIndex): image(image), events(events), colorIndex(colorIndex) { }
+	
+	void expanded(int x, int y) { if(events & Expanded) image.setPixel(x, y, colorIndex); }
+	void opened(int x, int y) { if(events & Opened) image.setPixel(x, y, colorIndex); }
+	void closed(int x, int y) { if(events & Closed) image.setPixel(x, y, colorIndex); }
+	void keyUpdated(int x, int y) { if(events & KeyUpdated) image.setPixel(x, y, colorIndex); }
+	
+private:
+	QImage &image;
+	int events;
+	uint colorIndex;
+};
+
+#endif // PLANNEROBSERVER_H
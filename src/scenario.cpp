@@ -0,0 +1,87 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scenario.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTextStream>
+#include <QStringList>
+
+bool Scenario::load(const QString &fileName) {
+	_entries.clear();
+	_lastError.clear();
+	
+	QFile file(fileName);
+	if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		_lastError = QString("Could not open scenario file \"%1\"").arg(fileName);
+		return false;
+	}
+	QDir scenarioDir = QFileInfo(fileName).dir();
+	
+	QTextStream in(&file);
+	int lineNo = 0;
+	while(!in.atEnd()) {
+		QString line = in.readLine().trimmed();
+		lineNo++;
+		if(line.isEmpty()) continue;
+		if(lineNo == 1 && line.startsWith("version")) continue;
+		
+		QStringList fields = line.split(QRegExp("\\s+"));
+		bool ok = (fields.size() == 9);
+		Entry entry;
+		if(ok) entry.bucket = fields[0].toInt(&ok);
+		if(ok) entry.mapSize.setWidth(fields[2].toInt(&ok));
+		if(ok) entry.mapSize.setHeight(fields[3].toInt(&ok));
+		if(ok) entry.start.setX(fields[4].toInt(&ok));
+		if(ok) entry.start.setY(fields[5].toInt(&ok));
+		if(ok) entry.goal.setX(fields[6].toInt(&ok));
+		if(ok) entry.goal.setY(fields[7].toInt(&ok));
+		if(ok) entry.optimalLength = fields[8].toDouble(&ok);
+		if(!ok) {
+			_lastError = QString("%1:%2: invalid scenario entry").arg(fileName).arg(lineNo);
+			_entries.clear();
+			return false;
+		}
+		
+		// MovingAI scenarios store the map path relative to the benchmark root, try a few locations
+		entry.mapFile = fields[1];
+		if(!QFileInfo(entry.mapFile).exists()) {
+			if(QFileInfo(scenarioDir.filePath(entry.mapFile)).exists()) entry.mapFile = scenarioDir.filePath(entry.mapFile);
+			else if(QFileInfo(scenarioDir.filePath(QFileInfo(entry.mapFile).fileName())).exists()) {
+				entry.mapFile = scenarioDir.filePath(QFileInfo(entry.mapFile).fileName());
+			}
+		}
+		_entries.push_back(entry);
+	}
+	return true;
+}
+
+bool Scenario::save(const QString &fileName) const {
+	QFile file(fileName);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return false;
+	
+	QTextStream out(&file);
+	out << "version 1\n";
+	foreach(const Entry &e, _entries) {
+		out << e.bucket << '\t' << e.mapFile << '\t' << e.mapSize.width() << '\t' << e.mapSize.height() << '\t'
+			<< e.start.x() << '\t' << e.start.y() << '\t' << e.goal.x() << '\t' << e.goal.y() << '\t'
+			<< QString::number(e.optimalLength, 'f', 8) << '\n';
+	}
+	return true;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <QList>
+#include <QPoint>
+#include <QSize>
+#include <QString>
+
+/* List of start/goal queries in the MovingAI benchmark format (.scen, version 1):
+ *   version 1
+ *   <bucket> <map file> <map width> <map height> <start x> <start y> <goal x> <goal y> <optimal length>
+ * Map files are resolved relative to the scenario file if they are not found as given.
+ */
+class Scenario {
+public:
+	struct Entry {
+		Entry(): bucket(0), optimalLength(0.0) { }
+		int bucket;
+		QString mapFile;
+		QSize mapSize;
+		QPoint start, goal;
+		qreal optimalLength; // reference length with diagonal cost sqrt(2), 0 if unknown
+	};
+	typedef QList<Entry> Entries;
+	
+	bool load(const QString &fileName);
+	bool save(const QString &fileName) const;
+	
+	const Entries &entries() const { return _entries; }
+	void addEntry(const Entry &entry) { _entries.push_back(entry); }
+	void clear() { _entries.clear(); }
+	
+	const QString &lastError() const { return _lastError; }
+
+private:
+	Entries _entries;
+	QString _lastError;
+};
+
+#endif // SCENARIO_H
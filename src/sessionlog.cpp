@@ -0,0 +1,225 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sessionlog.h"
+#include "maputils.h"
+#include <QFile>
+#include <QDataStream>
+#include <cstring>
+
+/* file format (QDataStream, big endian):
+ *   header: quint32 magic, quint16 version
+ *   event:  quint8 type, qint64 timeNs, qint64 calcTimeNs, payload
+ *   payload of map loaded:     QString file name, qint32 x, y, width, height, QByteArray compressed pixels
+ *           of map updated:    qint32 x, y, width, height, QByteArray compressed pixels
+ *           of start/goal:     double x, y, angle
+ *           of planner change: QString planner name
+ * Pixels are stored row by row without padding, compressed with qCompress().
+ */
+#define SESSIONLOG_MAGIC		0x52534c47 // "RSLG"
+#define SESSIONLOG_VERSION		1
+
+SessionLog::SessionLog():
+	file(NULL), stream(NULL)
+{
+	
+}
+
+SessionLog::~SessionLog() {
+	stopRecording();
+}
+
+QString SessionLog::eventName(EventType type) {
+	switch(type) {
+		case Event_MapLoaded: return "map loaded";
+		case Event_StartChanged: return "start";
+		case Event_GoalChanged: return "goal";
+		case Event_MapUpdated: return "map update";
+		case Event_PlannerChanged: return "planner";
+	}
+	return QString();
+}
+
+void SessionLog::Event::applyTo(QImage &map) const {
+	if(type == Event_MapLoaded) {
+		map = pixels;
+	} else if(type == Event_MapUpdated && !map.isNull() && map.rect().contains(region)) {
+		for(int y = 0; y < region.height(); y++) memcpy(map.scanLine(region.top() + y) + region.left(), pixels.constScanLine(y), region.width());
+	}
+}
+
+bool SessionLog::startRecording(const QString &fileName) {
+	stopRecording();
+	file = new QFile(fileName);
+	if(!file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		_lastError = QString("Could not write \"%1\"").arg(fileName);
+		delete file;
+		file = NULL;
+		return false;
+	}
+	stream = new QDataStream(file);
+	stream->setVersion(QDataStream::Qt_4_6);
+	*stream << (quint32)SESSIONLOG_MAGIC << (quint16)SESSIONLOG_VERSION;
+	timer.start();
+	return true;
+}
+
+void SessionLog::stopRecording() {
+	delete stream;
+	stream = NULL;
+	delete file;
+	file = NULL;
+}
+
+void SessionLog::recordMapLoaded(const QString &fileName, const QImage &map, qint64 calcTimeNs) {
+	Event event(Event_MapLoaded);
+	event.calcTimeNs = calcTimeNs;
+	event.name = fileName;
+	event.region = map.rect();
+	event.pixels = map;
+	record(event);
+}
+
+void SessionLog::recordStart(const Pose2D &start, qint64 calcTimeNs) {
+	Event event(Event_StartChanged);
+	event.calcTimeNs = calcTimeNs;
+	event.pose = start;
+	record(event);
+}
+
+void SessionLog::recordGoal(const Pose2D &goal, qint64 calcTimeNs) {
+	Event event(Event_GoalChanged);
+	event.calcTimeNs = calcTimeNs;
+	event.pose = goal;
+	record(event);
+}
+
+void SessionLog::recordMapUpdate(const QImage &map, const QRect &region, qint64 calcTimeNs) {
+	Event event(Event_MapUpdated);
+	event.calcTimeNs = calcTimeNs;
+	event.region = region.intersected(map.rect());
+	event.pixels = map.copy(event.region);
+	record(event);
+}
+
+void SessionLog::recordPlanner(const QString &name, qint64 calcTimeNs) {
+	Event event(Event_PlannerChanged);
+	event.calcTimeNs = calcTimeNs;
+	event.name = name;
+	record(event);
+}
+
+void SessionLog::record(Event &event) {
+	if(!stream) return;
+	event.timeNs = timer.nsecsElapsed();
+	
+	QDataStream &out = *stream;
+	out << (quint8)event.type << (qint64)event.timeNs << (qint64)event.calcTimeNs;
+	switch(event.type) {
+		case Event_MapLoaded:
+			out << event.name;
+			// fall through
+		case Event_MapUpdated: 
+			{
+				const QRect &r = event.region;
+				QByteArray pixels;
+				pixels.resize(r.width() * r.height());
+				for(int y = 0; y < r.height(); y++) memcpy(pixels.data() + y * r.width(), event.pixels.constScanLine(y), r.width());
+				out << (qint32)r.x() << (qint32)r.y() << (qint32)r.width() << (qint32)r.height() << qCompress(pixels);
+			}
+			break;
+		case Event_StartChanged:
+		case Event_GoalChanged:
+			out << (double)event.pose.x() << (double)event.pose.y() << (double)event.pose.angle();
+			break;
+		case Event_PlannerChanged:
+			out << event.name;
+			break;
+	}
+	file->flush();
+}
+
+bool SessionLog::load(const QString &fileName) {
+	_events.clear();
+	QFile in(fileName);
+	if(!in.open(QIODevice::ReadOnly)) {
+		_lastError = QString("Could not open session log \"%1\"").arg(fileName);
+		return false;
+	}
+	QDataStream stream(&in);
+	stream.setVersion(QDataStream::Qt_4_6);
+	quint32 magic;
+	quint16 version;
+	stream >> magic >> version;
+	if(stream.status() != QDataStream::Ok || magic != SESSIONLOG_MAGIC || version != SESSIONLOG_VERSION) {
+		_lastError = QString("\"%1\" is no session log (or of an unsupported version)").arg(fileName);
+		return false;
+	}
+	
+	while(!stream.atEnd()) {
+		quint8 type;
+		qint64 timeNs, calcTimeNs;
+		stream >> type >> timeNs >> calcTimeNs;
+		Event event((EventType)type);
+		event.timeNs = timeNs;
+		event.calcTimeNs = calcTimeNs;
+		
+		bool valid = true;
+		switch(type) {
+			case Event_MapLoaded:
+				stream >> event.name;
+				// fall through
+			case Event_MapUpdated:
+				{
+					qint32 x, y, w, h;
+					QByteArray compressed;
+					stream >> x >> y >> w >> h >> compressed;
+					QByteArray pixels = qUncompress(compressed);
+					event.region = QRect(x, y, w, h);
+					valid = (w >= 0 && h >= 0 && pixels.size() == w * h);
+					if(valid) {
+						event.pixels = QImage(w, h, QImage::Format_Indexed8);
+						event.pixels.setColorTable(MapUtils::colorTable());
+						for(int row = 0; row < h; row++) memcpy(event.pixels.scanLine(row), pixels.constData() + row * w, w);
+					}
+				}
+				break;
+			case Event_StartChanged:
+			case Event_GoalChanged:
+				{
+					double x, y, angle;
+					stream >> x >> y >> angle;
+					event.pose = Pose2D(x, y, angle);
+				}
+				break;
+			case Event_PlannerChanged:
+				stream >> event.name;
+				break;
+			default:
+				valid = false;
+		}
+		// a truncated last event (e.g. after a crash while recording) is dropped
+		if(stream.status() != QDataStream::Ok) break;
+		if(!valid) {
+			_lastError = QString("Corrupt event %1 in session log \"%2\"").arg(_events.size()).arg(fileName);
+			return false;
+		}
+		_events.push_back(event);
+	}
+	return true;
+}
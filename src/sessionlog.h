@@ -0,0 +1,89 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SESSIONLOG_H
+#define SESSIONLOG_H
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QList>
+#include <QRect>
+#include <QString>
+#include "data.h"
+class QFile;
+class QDataStream;
+
+/* Compact binary log of an interactive session: map loads, start/goal changes, map updates
+ * (region and edited pixels) and planner switches. Replaying the events in order reproduces
+ * the exact sequence of planner calls of the session without GUI (see rastersim-bench --session).
+ */
+class SessionLog {
+public:
+	SessionLog();
+	~SessionLog();
+	
+	enum EventType {
+		Event_MapLoaded = 1,
+		Event_StartChanged,
+		Event_GoalChanged,
+		Event_MapUpdated,
+		Event_PlannerChanged
+	};
+	static QString eventName(EventType type);
+	
+	struct Event {
+		Event(EventType type = Event_MapLoaded): type(type), timeNs(0), calcTimeNs(-1) { }
+		EventType type;
+		qint64 timeNs;		// since the start of the recording
+		qint64 calcTimeNs;	// planner calc. time measured while recording, -1 if unknown
+		QString name;		// map file (map loaded) or planner name (planner changed)
+		Pose2D pose;		// start or goal
+		QRect region;		// updated region, the whole map for map loaded
+		QImage pixels;		// contents of region after the event (Format_Indexed8)
+		
+		// copies the pixels of a map event into map (map loaded replaces the whole map)
+		void applyTo(QImage &map) const;
+	};
+	
+	// recording, every event is written immediately so the log survives a crash
+	bool startRecording(const QString &fileName);
+	void stopRecording();
+	bool isRecording() const { return stream != NULL; }
+	
+	void recordMapLoaded(const QString &fileName, const QImage &map, qint64 calcTimeNs = -1);
+	void recordStart(const Pose2D &start, qint64 calcTimeNs = -1);
+	void recordGoal(const Pose2D &goal, qint64 calcTimeNs = -1);
+	void recordMapUpdate(const QImage &map, const QRect &region, qint64 calcTimeNs = -1);
+	void recordPlanner(const QString &name, qint64 calcTimeNs = -1);
+	
+	// loading for replay
+	bool load(const QString &fileName);
+	const QList<Event> &events() const { return _events; }
+	const QString &lastError() const { return _lastError; }
+
+private:
+	void record(Event &event);
+	
+	QFile *file;
+	QDataStream *stream;
+	QElapsedTimer timer;
+	QList<Event> _events;
+	QString _lastError;
+};
+
+#endif // SESSIONLOG_H
@@ -22,6 +22,7 @@
 #include <QKeySequence>
 #include <QShortcut>
 #include <QLabel>
+#include <QStringList>
 #include <QLineEdit>
 #include <QComboBox>
 #include <QSettings>
@@ -39,16 +40,18 @@
 #include <QSpinBox>
 #include "visualizationwidget.h"
 #include <cmath>
-#include "astarplanner.h"
-#include "dstarplanner.h"
-#include "fdstarplanner.h"
-#include "dstarliteplanner.h"
+#include "abstractplanner.h"
+#include "maputils.h"
+#include "trace.h"
 #include <QDockWidget>
 #include <QListView>
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QToolButton>
 #include "flowlayout.h"
+#include "performancewidget.h"
+#include "comparisonwidget.h"
+#include "metricsexporter.h"
 #include "rlcpens.h"
 
 #define INI_FILEPATH				"rastersim.ini"
@@ -72,26 +75,22 @@
 #define REGKEY_GOAL_ANGLE			"goal/angle"
 
 #define REGKEY_PLANNER				"planner"
-
-class FullInitFocussedDStarPlanner: public FocussedDStarPlanner {
-public: 
-	FullInitFocussedDStarPlanner(QObject *parent = 0): FocussedDStarPlanner(parent) { setFullInit(true); }
-};
+#define REGKEY_STEP_HISTORY_BUDGET	"planner/stepHistoryMiB"
+#define REGKEY_BACKGROUND_PLANNING	"planner/background"
+#define REGKEY_METRICS_FILE			"metrics/file"
 
 SimMainWindow::SimMainWindow(QWidget *parent):
 	QMainWindow(parent), 
-	planner(NULL)
+	planner(NULL), stepHistoryBudget(64 << 20)
 {
 	setWindowTitle(qApp->applicationName());
+	Trace::setThreadName("GUI");
 	//setWindowIcon(QIcon(tr(":/images/???.svg")));
 
 	visualization = new VisualizationWidget;
 
-	plannerFactories.push_back(new GenericPlannerFactory<AStarPlanner>("A-Star (A*)"));
-	plannerFactories.push_back(new GenericPlannerFactory<DStarPlanner>("D-Star (D*)"));
-	plannerFactories.push_back(new GenericPlannerFactory<FocussedDStarPlanner>("Focussed D* (FD*)"));
-	plannerFactories.push_back(new GenericPlannerFactory<FullInitFocussedDStarPlanner>("FD* with full init."));
-	plannerFactories.push_back(new GenericPlannerFactory<DStarLitePlanner>("D* Lite"));
+	plannerFactories = createPlannerFactories();
+	metricsExporter = new MetricsExporter(this);
 
 	createActions();
 	createToolbars();
@@ -117,6 +116,9 @@ SimMainWindow::SimMainWindow(QWidget *parent):
 	statusBar()->addWidget(startGoalLabel);
 	connect(visualization, SIGNAL(startPoseChanged()), this, SLOT(updateStartGoal()));
 	connect(visualization, SIGNAL(goalPoseChanged()), this, SLOT(updateStartGoal()));		
+	connect(visualization, SIGNAL(startPoseChanged()), this, SLOT(recordStartChange()));
+	connect(visualization, SIGNAL(goalPoseChanged()), this, SLOT(recordGoalChange()));
+	connect(visualization, SIGNAL(mapEdited(const QRect &)), this, SLOT(recordMapEdit(const QRect &)));
 	
 	// restore settings
 	QSettings settings(INI_FILEPATH, QSettings::IniFormat);
@@ -144,6 +146,14 @@ SimMainWindow::SimMainWindow(QWidget *parent):
 	penStyleCombo->setCurrentIndex(settings.value(REGKEY_EDIT_PENSHAPE, 0).toInt());
 	updatePenFromControls();
 	
+	backgroundPlanningAction->setChecked(settings.value(REGKEY_BACKGROUND_PLANNING, true).toBool());
+	stepHistoryBudget = settings.value(REGKEY_STEP_HISTORY_BUDGET, 64).toLongLong() << 20;
+	if(planner) planner->setStepHistoryBudget(stepHistoryBudget);
+	
+	// metrics export continues across restarts
+	QString metricsFile = settings.value(REGKEY_METRICS_FILE).toString();
+	if(!metricsFile.isEmpty() && metricsExporter->start(metricsFile)) exportMetricsAction->setChecked(true);
+	
 	mapFreeColor = qRgb(255, 255, 255);
 	mapFreeColorTolerance = 10;
 		
@@ -168,6 +178,7 @@ SimMainWindow::SimMainWindow(QWidget *parent):
 }
 
 SimMainWindow::~SimMainWindow() {
+	if(planner) planner->setBackgroundPlanning(false);
 	qDeleteAll(plannerFactories);
 }
 
@@ -192,6 +203,9 @@ void SimMainWindow::closeEvent(QCloseEvent *) {
 	settings.setValue(REGKEY_GOAL_Y, visualization->goal().y());
 	settings.setValue(REGKEY_GOAL_ANGLE, visualization->goal().angle());	
 	settings.setValue(REGKEY_PLANNER, plannerCombo->currentIndex());
+	settings.setValue(REGKEY_BACKGROUND_PLANNING, backgroundPlanningAction->isChecked());
+	settings.setValue(REGKEY_STEP_HISTORY_BUDGET, stepHistoryBudget >> 20);
+	settings.setValue(REGKEY_METRICS_FILE, metricsExporter->fileName());
 }
 
 void SimMainWindow::createActions() {
@@ -199,6 +213,30 @@ void SimMainWindow::createActions() {
 	openMapAction->setShortcut(Qt::CTRL + Qt::Key_O);
 	connect(openMapAction, SIGNAL(triggered(bool)), this, SLOT(openMap()));	
 	
+	recordSessionAction = new QAction(tr("Record Session..."), this);
+	recordSessionAction->setCheckable(true);
+	connect(recordSessionAction, SIGNAL(triggered(bool)), this, SLOT(recordSession(bool)));
+	
+	traceAction = new QAction(tr("Trace Events"), this);
+	traceAction->setCheckable(true);
+	connect(traceAction, SIGNAL(toggled(bool)), this, SLOT(enableTracing(bool)));
+	saveTraceAction = new QAction(tr("Save Trace..."), this);
+	connect(saveTraceAction, SIGNAL(triggered(bool)), this, SLOT(saveTrace()));
+	exportMetricsAction = new QAction(tr("Export Metrics..."), this);
+	exportMetricsAction->setCheckable(true);
+	connect(exportMetricsAction, SIGNAL(triggered(bool)), this, SLOT(exportMetrics(bool)));
+	hardwareCountersAction = new QAction(tr("Hardware Counters"), this);
+	hardwareCountersAction->setCheckable(true);
+	connect(hardwareCountersAction, SIGNAL(toggled(bool)), this, SLOT(enableHardwareCounters(bool)));
+	
+	backgroundPlanningAction = new QAction(tr("Background Planning"), this);
+	backgroundPlanningAction->setCheckable(true);
+	backgroundPlanningAction->setToolTip(tr("Plan on a separate thread, the GUI stays responsive during long searches"));
+	connect(backgroundPlanningAction, SIGNAL(toggled(bool)), this, SLOT(setBackgroundPlanning(bool)));
+	cancelPlanningAction = new QAction(tr("Cancel Planning"), this);
+	cancelPlanningAction->setShortcut(Qt::Key_Escape);
+	connect(cancelPlanningAction, SIGNAL(triggered(bool)), this, SLOT(cancelPlanning()));
+	
 	minCostAction = new QAction(QIcon(tr(":images/color_white.svg")), trUtf8("Draw Free Space"), this);
 	minCostAction->setCheckable(true);
 	maxCostAction = new QAction(QIcon(tr(":images/color_black.svg")), trUtf8("Draw Obstacles"), this);
@@ -319,19 +357,6 @@ void SimMainWindow::createDocks() {
 	plannerActionsLayout = new FlowLayout;
 	optMainLayout->addLayout(plannerActionsLayout);
 	
-	QHBoxLayout *optCalcTimeLayout = new QHBoxLayout;
-	QLabel *calcTimeCaptionLabel = new QLabel(tr("calc. time:"));
-	calcTimeCaptionLabel->setAlignment(Qt::AlignVCenter | Qt::AlignLeft);
-	optCalcTimeLayout->addWidget(calcTimeCaptionLabel, 0);
-	calcTimeLabel = new QLabel("---");
-	calcTimeLabel->setAlignment(Qt::AlignVCenter | Qt::AlignRight);
-	QFont font = calcTimeLabel->font();
-	font.setPointSize(14);
-	font.setBold(true);
-	calcTimeLabel->setFont(font);
-	optCalcTimeLayout->addWidget(calcTimeLabel, 1);
-	optMainLayout->addLayout(optCalcTimeLayout, 0);
-	
 	cellDetailLabel = new QLabel;
 	cellDetailLabel->setMinimumHeight(100);
 	cellDetailLabel->setAlignment(Qt::AlignLeft | Qt::AlignTop);
@@ -343,10 +368,28 @@ void SimMainWindow::createDocks() {
 	optionsDock->setObjectName("options_dock");
 	optionsDock->setWidget(optionsWidget);	
 	addDockWidget(Qt::RightDockWidgetArea, optionsDock);
+	
+	performanceWidget = new PerformanceWidget;
+	performanceDock = new QDockWidget(tr("Performance"));
+	performanceDock->setObjectName("performance_dock");
+	performanceDock->setWidget(performanceWidget);
+	addDockWidget(Qt::RightDockWidgetArea, performanceDock);
+	
+	comparisonWidget = new ComparisonWidget(plannerFactories);
+	comparisonDock = new QDockWidget(tr("Planner Comparison"));
+	comparisonDock->setObjectName("comparison_dock");
+	comparisonDock->setWidget(comparisonWidget);
+	comparisonDock->hide();
+	connect(comparisonDock->toggleViewAction(), SIGNAL(toggled(bool)), comparisonWidget, SLOT(setRunning(bool)));
+	addDockWidget(Qt::BottomDockWidgetArea, comparisonDock);
 }
 void SimMainWindow::createMenus() {
 	QMenu *fileMenu = new QMenu(tr("File"), this);
 	fileMenu->addAction(openMapAction);
+	fileMenu->addAction(recordSessionAction);
+	fileMenu->addAction(traceAction);
+	fileMenu->addAction(saveTraceAction);
+	fileMenu->addAction(exportMetricsAction);
 	fileMenu->addSeparator();
 	fileMenu->addAction(tr("Quit"), this, SLOT(close()), Qt::ALT + Qt::Key_F4);
 	menuBar()->addMenu(fileMenu); 
@@ -354,8 +397,18 @@ void SimMainWindow::createMenus() {
 	QMenu *viewMenu = new QMenu(tr("View"), this);
 	viewMenu->addAction(mapToolBar->toggleViewAction());
 	viewMenu->addAction(viewToolBar->toggleViewAction());
+	viewMenu->addAction(optionsDock->toggleViewAction());
+	viewMenu->addAction(performanceDock->toggleViewAction());
+	viewMenu->addAction(comparisonDock->toggleViewAction());
+	viewMenu->addSeparator();
+	viewMenu->addAction(hardwareCountersAction);
 	menuBar()->addMenu(viewMenu);
 	
+	QMenu *plannerMenu = new QMenu(tr("Planner"), this);
+	plannerMenu->addAction(backgroundPlanningAction);
+	plannerMenu->addAction(cancelPlanningAction);
+	menuBar()->addMenu(plannerMenu);
+	
 	QMenu *infoMenu = new QMenu(tr("&?"));
 	infoMenu->addAction(tr("About..."), this, SLOT(showAbout()), Qt::Key_F1);
 	infoMenu->addAction(tr("About Qt..."), qApp, SLOT(aboutQt()), Qt::CTRL + Qt::Key_F1);
@@ -366,7 +419,11 @@ void SimMainWindow::updateMouseCoords(QPointF pt) {
 	QPoint pt_i = pt.toPoint();
 	mouseCoordsLabel->setText(QString("X = %1, Y = %2").arg(pt_i.x()).arg(pt_i.y()));
 	
-	if(planner) cellDetailLabel->setText(planner->cellDetails(pt_i));
+	// keeps the last details while the planning thread calculates a path
+	if(planner && planner->dataMutex()->tryLock()) {
+		cellDetailLabel->setText(planner->cellDetails(pt_i));
+		planner->dataMutex()->unlock();
+	}
 }
 void SimMainWindow::updateZoomFactor(qreal factor) {
 	factor *= 100;
@@ -386,17 +443,6 @@ void SimMainWindow::updateStartGoal() {
 	startGoalLabel->setText(startString + " -> " + goalString);	
 }
 
-void SimMainWindow::updatePlannerData() {
-	if(planner) {
-		int64_t calcTime = planner->calcTimeMs();
-		if(calcTime < 0) calcTimeLabel->setText("---");
-		else if(calcTime < 1000) calcTimeLabel->setText(QString("%1 ms").arg(calcTime));
-		else {
-			qreal calcTimef = (qreal)calcTime / 1000.0;
-			calcTimeLabel->setText(QString("%1 s").arg(calcTimef, 0, 'f', qMax(0, 2  - (int)log10(calcTimef))));
-		}
-	}
-}
 void SimMainWindow::rotateLeft() {
 	switch(visualization->rotation()) {
 	case ZoomableWidget::Rotate_90CCW: visualization->setRotation(ZoomableWidget::Rotate_180); break;
@@ -420,38 +466,17 @@ void SimMainWindow::openMap() {
 }
 
 bool SimMainWindow::loadMap(const QString &fileName) {
+	TRACE_SCOPE("loadMap");
 	bool success = false;
-	QImage img(fileName);
-	if(!img.isNull()) {
-		QImage map(img.size(), QImage::Format_Indexed8);
-		QVector<QRgb> colorTable(256);
-		for(unsigned i = 0; i < 256; i++) colorTable[255 - i] = qRgb(i, i, i);
-		map.setColorTable(colorTable);
-		
-		img = img.convertToFormat(QImage::Format_RGB32);		
-		for(int y = 0; y < img.height(); y++) {
-			unsigned char *pDest = (unsigned char*)map.scanLine(y);
-			const QRgb *pSrc = (const QRgb *)img.scanLine(y);
-			for(int x = 0; x < img.width(); x++) {
-				QRgb clr = *pSrc++;
-				int rDelta = qAbs(qRed(mapFreeColor) - qRed(clr));
-				int gDelta = qAbs(qGreen(mapFreeColor) - qGreen(clr));
-				int bDelta = qAbs(qBlue(mapFreeColor) - qBlue(clr));
-				if(gDelta > rDelta) rDelta = gDelta;
-				if(bDelta > rDelta) rDelta = bDelta;
-				
-				if(rDelta > mapFreeColorTolerance) *pDest = 255;
-				else *pDest = 0;				
-			
-				pDest++;
-			} 			
-		}
-		
+	QImage map = MapUtils::load(fileName, mapFreeColor, mapFreeColorTolerance);
+	if(!map.isNull()) {
 		visualization->setMap(map);		
+		comparisonWidget->setMap(visualization->map(), visualization->start(), visualization->goal());
 			
 		QFileInfo fi(fileName);
 		lastMapDir = fi.path();
 		lastMapFile = fi.fileName();
+		if(sessionLog.isRecording()) sessionLog.recordMapLoaded(fileName, visualization->map(), planner ? planner->calcTimeNs() : -1);
 
 		success = true;
 	} else QMessageBox::warning(this, qApp->applicationName(), QString(tr("Could not load map file \"%1\"")).arg(fileName));
@@ -459,15 +484,99 @@ bool SimMainWindow::loadMap(const QString &fileName) {
 	return success;
 }
 
+/* starts recording with a snapshot of the current state (map, start, goal and planner),
+ * so that the recorded session can be replayed on its own
+ */
+void SimMainWindow::recordSession(bool record) {
+	if(!record) {
+		sessionLog.stopRecording();
+		return;
+	}
+	QString fileName = QFileDialog::getSaveFileName(this, tr("record session to..."), QDir(lastMapDir).filePath("session.rslog"), 
+													tr("session logs (*.rslog)\nall files (*.*)"));
+	if(fileName.isEmpty() || !sessionLog.startRecording(fileName)) {
+		if(!fileName.isEmpty()) QMessageBox::warning(this, qApp->applicationName(), sessionLog.lastError());
+		recordSessionAction->setChecked(false);
+		return;
+	}
+	
+	if(!visualization->map().isNull()) sessionLog.recordMapLoaded(QDir(lastMapDir).filePath(lastMapFile), visualization->map());
+	if(visualization->start().isValid()) sessionLog.recordStart(visualization->start());
+	if(visualization->goal().isValid()) sessionLog.recordGoal(visualization->goal());
+	if(planner) sessionLog.recordPlanner(plannerCombo->currentText());
+}
+
+// traces planner calls and repaints on one timeline, see trace.h
+void SimMainWindow::enableTracing(bool enable) {
+	if(enable) Trace::clear();
+	Trace::setEnabled(enable);
+}
+
+// counts cycles, cache and branch misses of each planner call, see perfcounters.h
+void SimMainWindow::enableHardwareCounters(bool enable) {
+	if(enable) {
+		PerfCounters perf;
+		if(!perf.open()) {
+			QMessageBox::warning(this, qApp->applicationName(), QString(tr("Hardware counters are not available:\n%1")).arg(perf.lastError()));
+			hardwareCountersAction->setChecked(false);
+			return;
+		}
+	}
+	AbstractPlanner::setHardwareCountersEnabled(enable);
+}
+
+void SimMainWindow::saveTrace() {
+	QString fileName = QFileDialog::getSaveFileName(this, tr("save trace to..."), QDir(lastMapDir).filePath("trace.json"), 
+													tr("Chrome trace files (*.json)\nall files (*.*)"));
+	if(!fileName.isEmpty() && !Trace::writeJson(fileName)) {
+		QMessageBox::warning(this, qApp->applicationName(), QString(tr("Could not write \"%1\"")).arg(fileName));
+	}
+}
+
+// writes planner metrics for the textfile collector of node_exporter every 15 s, see metricsexporter.h
+void SimMainWindow::exportMetrics(bool enable) {
+	if(!enable) {
+		metricsExporter->stop();
+		return;
+	}
+	QString fileName = QFileDialog::getSaveFileName(this, tr("export metrics to..."), QDir(lastMapDir).filePath("rastersim.prom"), 
+													tr("Prometheus text files (*.prom)\nall files (*.*)"));
+	if(fileName.isEmpty() || !metricsExporter->start(fileName)) {
+		if(!fileName.isEmpty()) QMessageBox::warning(this, qApp->applicationName(), metricsExporter->lastError());
+		exportMetricsAction->setChecked(false);
+	}
+}
+
+void SimMainWindow::recordStartChange() {
+	comparisonWidget->setStart(visualization->start());
+	if(sessionLog.isRecording()) sessionLog.recordStart(visualization->start(), planner ? planner->calcTimeNs() : -1);
+}
+void SimMainWindow::recordGoalChange() {
+	comparisonWidget->setGoal(visualization->goal());
+	if(sessionLog.isRecording()) sessionLog.recordGoal(visualization->goal(), planner ? planner->calcTimeNs() : -1);
+}
+void SimMainWindow::recordMapEdit(const QRect &region) {
+	comparisonWidget->updateMap(visualization->map(), region);
+	if(sessionLog.isRecording()) sessionLog.recordMapUpdate(visualization->map(), region, planner ? planner->calcTimeNs() : -1);
+}
+
 void SimMainWindow::setPlanner(int index) {
 	if(index < 0 || index >= plannerFactories.size()) return;
 	
 	AbstractPlanner *oldPlanner = planner;
-	if(oldPlanner) oldPlanner->disconnect();
+	if(oldPlanner) {
+		oldPlanner->disconnect();
+		oldPlanner->setBackgroundPlanning(false);
+	}
 	
 	planner = plannerFactories[index]->create(this);	
-	connect(planner, SIGNAL(dataChanged()), this, SLOT(updatePlannerData()));
+	planner->setSearchLayersEnabled(true);
+	planner->setStepHistoryBudget(stepHistoryBudget);
+	planner->setBackgroundPlanning(backgroundPlanningAction->isChecked());
+	performanceWidget->setPlanner(planner);
+	metricsExporter->setPlanner(planner, plannerFactories[index]->name());
 	visualization->setPlanner(planner);
+	if(sessionLog.isRecording()) sessionLog.recordPlanner(plannerFactories[index]->name(), planner->calcTimeNs());
 	
 	for(int i = plannerActionsLayout->count() - 1; i >= 0; i--) {
 		plannerActionsLayout->itemAt(i)->widget()->deleteLater();
@@ -483,6 +592,18 @@ void SimMainWindow::setPlanner(int index) {
 	delete oldPlanner;	
 }
 
+// see AbstractPlanner::setBackgroundPlanning()
+void SimMainWindow::setBackgroundPlanning(bool enable) {
+	if(!planner) return;
+	planner->setBackgroundPlanning(enable);
+	// pending inputs are dropped when switching back, pass map, start and goal again
+	if(!enable) visualization->setPlanner(planner);
+}
+
+void SimMainWindow::cancelPlanning() {
+	if(planner) planner->cancel();
+}
+
 void SimMainWindow::changeTool(QAction *toolAction) {
 	visualization->setTool(toolAction == penToolAction ? VisualizationWidget::Tool_Pen :
 						   toolAction == lineToolAction ? VisualizationWidget::Tool_Line :
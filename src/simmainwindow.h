@@ -20,6 +20,8 @@
 #define SIMMAINWINDOW_H
 
 #include <QMainWindow>
+#include "plannerfactory.h"
+#include "sessionlog.h"
 
 class QAction;
 class QActionGroup;
@@ -33,6 +35,9 @@ class AbstractPlanner;
 class QDockWidget;
 class QListView;
 class FlowLayout;
+class PerformanceWidget;
+class ComparisonWidget;
+class MetricsExporter;
 
 class SimMainWindow: public QMainWindow{
 	Q_OBJECT
@@ -45,21 +50,31 @@ protected:
 
 private slots:
 	void openMap();	
+	void recordSession(bool record);
+	void enableTracing(bool enable);
+	void saveTrace();
+	void exportMetrics(bool enable);
+	void enableHardwareCounters(bool enable);
 	void showAbout();
 
 	void rotateLeft();
 	void rotateRight();
 
 	void setPlanner(int index);
+	void setBackgroundPlanning(bool enable);
+	void cancelPlanning();
 	void updateMouseCoords(QPointF pt);
 	void updateZoomFactor(qreal factor);
 	void updateStartGoal();
-	void updatePlannerData();
 	
 	void changeTool(QAction *);
 	void changeCost(QAction *);
 	void updatePenFromControls();
 	
+	void recordStartChange();
+	void recordGoalChange();
+	void recordMapEdit(const QRect &region);
+	
 private:
 	void createActions();
 	void createToolbars();
@@ -71,6 +86,15 @@ private:
 	
 	QAction *openMapAction;
 	bool loadMap(const QString &fileName);
+	
+	QAction *recordSessionAction;
+	SessionLog sessionLog;
+	
+	QAction *traceAction;
+	QAction *saveTraceAction;
+	QAction *hardwareCountersAction;
+	QAction *exportMetricsAction;
+	MetricsExporter *metricsExporter;
 		
 	QLabel *cursorPosLabel;
 	QLabel *zoomLabel;
@@ -89,31 +113,24 @@ private:
 	QAction *showOverlaysAction;
 	
 	AbstractPlanner *planner;
+	QAction *backgroundPlanningAction;
+	QAction *cancelPlanningAction;
+	int64_t stepHistoryBudget; // bytes, see AbstractPlanner::setStepHistoryBudget()
 	
 	QDockWidget *optionsDock;
 	QComboBox *plannerCombo;
 	QListView *layerView;
-	QLabel *calcTimeLabel;
 	QLabel *cellDetailLabel;
 	FlowLayout *plannerActionsLayout;
 	
-	class PlannerFactoryBase {
-	public:
-		PlannerFactoryBase(const QString &name = QString()): _name(name) { }
-		virtual ~PlannerFactoryBase() { }
-		const QString &name() const { return _name; }
-		virtual AbstractPlanner *create(QObject * = 0) = 0;		
-	private:
-		QString _name;
-	};
-	template <typename T>
-	class GenericPlannerFactory: public PlannerFactoryBase {
-	public:
-		GenericPlannerFactory(const QString &name = QString()): PlannerFactoryBase(name) { }
-		AbstractPlanner *create(QObject *parent = 0) { return new T(parent); }
-	};
+	QDockWidget *performanceDock;
+	PerformanceWidget *performanceWidget;
+	
+	// all planners on the same inputs, running while the dock is shown
+	QDockWidget *comparisonDock;
+	ComparisonWidget *comparisonWidget;
 	
-	QList<PlannerFactoryBase *> plannerFactories;	
+	PlannerFactories plannerFactories;	
 	
 	QActionGroup *costActions;
 	QAction *minCostAction;
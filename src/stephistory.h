@@ -0,0 +1,183 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STEPHISTORY_H
+#define STEPHISTORY_H
+
+#include <QVector>
+#include <stdint.h>
+
+/* Per-step deltas of a planner's cell array, recorded while single stepping so that the search can be
+ * scrubbed backward and forward without re-planning.
+ * Within a step, save() stores the complete state of a cell before its first modification. Stepping back
+ * or forward swaps the stored with the current states, so a delta holds whichever state is not applied.
+ * The open heap is not recorded: every heap slot written during a step receives a cell whose heapIndex
+ * changes, so restoring the cells and setting openHeap[heapIndex] for them restores the heap. This
+ * requires heapIndex == 0 for all cells that are not on the open list.
+ * Cells saved in the current step are marked with the step's stamp, so each save() takes constant time.
+ * The oldest steps are dropped when the deltas exceed the memory budget.
+ */
+template<class Cell> class StepHistory {
+public:
+	StepHistory(): _cells(NULL), _openHeap(NULL), _numCells(0), _stamp(0), _budget(64 << 20), _recording(false), _position(0),
+		_dropped(0) { }
+
+	// attaches to the planner's runtime data (after allocating), drops all steps
+	void reset(Cell *cells, Cell **openHeap, int numCells) {
+		_cells = cells;
+		_openHeap = openHeap;
+		_numCells = numCells;
+		clear();
+	}
+	// drops all steps and frees the stamps, which are allocated with the first recorded step
+	void clear() {
+		_steps.clear();
+		_deltas.clear();
+		_stamps.clear();
+		_stamp = 0;
+		_recording = false;
+		_position = _dropped = 0;
+	}
+	// the budget applies to the recorded deltas, the vectors may reserve up to twice as much
+	void setBudget(int64_t bytes) { _budget = bytes; }
+	int64_t memoryUsage() const {
+		return (int64_t)_steps.capacity() * sizeof(Step) + (int64_t)_deltas.capacity() * sizeof(Delta) +
+			   (int64_t)_stamps.capacity() * sizeof(unsigned);
+	}
+
+	// step numbers count from the last clear(), steps before firstStep() have been dropped
+	unsigned firstStep() const { return _dropped; }
+	unsigned lastStep() const { return _dropped + _steps.size(); }
+	unsigned position() const { return _dropped + _position; }
+
+	// recording: steps after the current position are discarded
+	bool isRecording() const { return _recording; }
+	void beginStep(unsigned openListLength) {
+		_steps.resize(_position);
+		_deltas.resize(_steps.isEmpty() ? 0 : _steps.last().end);
+		if(_stamps.size() != _numCells) _stamps.fill(0, _numCells);
+		if(++_stamp == 0) {
+			// wrapped around, stamps of earlier steps could match again
+			_stamps.fill(0);
+			_stamp = 1;
+		}
+		Step step;
+		step.begin = step.end = _deltas.size();
+		step.openListLength[0] = openListLength;
+		_steps.push_back(step);
+		_recording = true;
+	}
+	inline void save(const Cell *pCell) {
+		if(!_recording) return;
+		unsigned index = pCell - _cells;
+		if(_stamps[index] == _stamp) return;
+		_stamps[index] = _stamp;
+		_deltas.push_back(Delta(index, *pCell));
+	}
+	void endStep(unsigned openListLength) {
+		if(!_recording) return;
+		_recording = false;
+		_steps.last().end = _deltas.size();
+		_steps.last().openListLength[1] = openListLength;
+		_position = _steps.size();
+		if(bytes() > _budget) dropSteps();
+	}
+
+	// move up to count steps back or forward, restoring the cells, the open heap and its length; returns the number of steps moved
+	unsigned stepBack(unsigned count, unsigned &openListLength) {
+		unsigned moved = 0;
+		for(; moved < count && _position > 0; moved++) {
+			const Step &step = _steps[--_position];
+			for(unsigned i = step.end; i > step.begin; i--) swap(_deltas[i - 1]);
+			relink(step);
+			openListLength = step.openListLength[0];
+		}
+		return moved;
+	}
+	unsigned stepForward(unsigned count, unsigned &openListLength) {
+		unsigned moved = 0;
+		for(; moved < count && _position < (unsigned)_steps.size(); moved++) {
+			const Step &step = _steps[_position++];
+			for(unsigned i = step.begin; i < step.end; i++) swap(_deltas[i]);
+			relink(step);
+			openListLength = step.openListLength[1];
+		}
+		return moved;
+	}
+
+private:
+	struct Step {
+		unsigned begin, end;		// range in _deltas
+		unsigned openListLength[2];	// before and after the step
+	};
+	struct Delta {
+		Delta(): index(0) { }
+		Delta(unsigned index, const Cell &cell): index(index), cell(cell) { }
+		unsigned index;
+		Cell cell;
+	};
+
+	inline void swap(Delta &delta) {
+		Cell *pCell = _cells + delta.index;
+		Cell temp = *pCell;
+		*pCell = delta.cell;
+		delta.cell = temp;
+	}
+	void relink(const Step &step) {
+		for(unsigned i = step.begin; i < step.end; i++) {
+			Cell *pCell = _cells + _deltas[i].index;
+			if(pCell->heapIndex > 0) _openHeap[pCell->heapIndex] = pCell;
+		}
+	}
+
+	int64_t bytes() const { return (int64_t)_steps.size() * sizeof(Step) + (int64_t)_deltas.size() * sizeof(Delta); }
+	
+	// drops the oldest steps down to 3/4 of the budget, so the deltas are not moved on every step
+	void dropSteps() {
+		unsigned drop = 0;
+		int64_t bytes = this->bytes();
+		while(drop < (unsigned)_steps.size() && bytes > _budget * 3 / 4) {
+			bytes -= sizeof(Step) + (int64_t)(_steps[drop].end - _steps[drop].begin) * sizeof(Delta);
+			drop++;
+		}
+		if(!drop) return;
+		unsigned deltaOffset = _steps[drop - 1].end;
+		_deltas.remove(0, deltaOffset);
+		_steps.remove(0, drop);
+		for(int i = 0; i < _steps.size(); i++) {
+			_steps[i].begin -= deltaOffset;
+			_steps[i].end -= deltaOffset;
+		}
+		_position -= drop;
+		_dropped += drop;
+	}
+
+	Cell *_cells;
+	Cell **_openHeap;
+	int _numCells;
+	QVector<Step> _steps;
+	QVector<Delta> _deltas;
+	QVector<unsigned> _stamps; // per cell, the stamp of the step which has saved it last
+	unsigned _stamp; // of the current step
+	int64_t _budget;
+	bool _recording;
+	unsigned _position;	// index into _steps
+	unsigned _dropped;
+};
+
+#endif // STEPHISTORY_H
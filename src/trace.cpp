@@ -0,0 +1,172 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trace.h"
+#include <QFile>
+#include <QTextStream>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace Trace {
+	std::atomic<bool> _enabled(false);
+	
+	struct Event {
+		const char *name, *detail;
+		int64_t startNs, endNs;
+	};
+	
+	/* single producer ring buffer: only the owning thread writes, head is published after
+	 * an event is complete, so a reader copies the events below head and afterwards discards
+	 * those that may have been overwritten meanwhile
+	 */
+	struct Buffer {
+		Buffer(int tid, const char *threadName): tid(tid), threadName(threadName), head(0), exited(false), events(bufferCapacity) { }
+		int tid;
+		const char *threadName;
+		std::atomic<uint64_t> head;
+		std::atomic<bool> exited; // the owning thread has ended, the buffer is freed by the next clear()
+		std::vector<Event> events;
+	};
+	
+	/* a thread's buffer is registered with its first event, i.e. only while tracing is enabled; it is kept after
+	 * the thread has ended, as its events may still be written, until clear() discards them
+	 */
+	static std::mutex buffersMutex;
+	static std::vector<Buffer *> buffers;
+	static int nextTid = 1;
+	
+	struct ThreadBuffer {
+		ThreadBuffer(): buffer(NULL), name(NULL) { }
+		~ThreadBuffer() { if(buffer) buffer->exited.store(true); }
+		Buffer *buffer;
+		const char *name;
+	};
+	static thread_local ThreadBuffer threadBuffer;
+	
+	static Buffer *currentBuffer() {
+		if(!threadBuffer.buffer) {
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			threadBuffer.buffer = new Buffer(nextTid++, threadBuffer.name);
+			buffers.push_back(threadBuffer.buffer);
+		}
+		return threadBuffer.buffer;
+	}
+	
+	void setEnabled(bool enabled) {
+		_enabled.store(enabled);
+	}
+	
+	void setThreadName(const char *name) {
+		threadBuffer.name = name;
+		if(threadBuffer.buffer) threadBuffer.buffer->threadName = name;
+	}
+	
+	void clear() {
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		// not synchronized with writers, which is fine: events recorded meanwhile are kept or lost
+		size_t kept = 0;
+		for(size_t i = 0; i < buffers.size(); i++) {
+			if(buffers[i]->exited.load()) {
+				delete buffers[i];
+				continue;
+			}
+			buffers[i]->head.store(0, std::memory_order_release);
+			buffers[kept++] = buffers[i];
+		}
+		buffers.resize(kept);
+	}
+	
+	int64_t Scope::now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+	
+	void Scope::record(const char *name, const char *detail, int64_t startNs, int64_t endNs) {
+		Buffer *buffer = currentBuffer();
+		uint64_t head = buffer->head.load(std::memory_order_relaxed);
+		Event &e = buffer->events[head % bufferCapacity];
+		e.name = name;
+		e.detail = detail;
+		e.startNs = startNs;
+		e.endNs = endNs;
+		buffer->head.store(head + 1, std::memory_order_release);
+	}
+	
+	static QString escape(const char *str) {
+		QString s = QString::fromUtf8(str);
+		s.replace("\\", "\\\\");
+		s.replace("\"", "\\\"");
+		return s;
+	}
+	
+	bool writeJson(const QString &fileName) {
+		QFile file(fileName);
+		if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return false;
+		QTextStream out(&file);
+		
+		// the buffers of ended threads may be freed by clear(), their events are copied while holding the lock
+		std::vector<int> tids;
+		std::vector<const char *> threadNames;
+		std::vector<std::vector<Event> > threadEvents;
+		{
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			threadEvents.resize(buffers.size());
+			for(size_t t = 0; t < buffers.size(); t++) {
+				Buffer *b = buffers[t];
+				tids.push_back(b->tid);
+				threadNames.push_back(b->threadName);
+				uint64_t head = b->head.load(std::memory_order_acquire);
+				uint64_t first = head > bufferCapacity ? head - bufferCapacity : 0;
+				std::vector<Event> &events = threadEvents[t];
+				for(uint64_t i = first; i < head; i++) events.push_back(b->events[i % bufferCapacity]);
+				uint64_t headAfter = b->head.load(std::memory_order_acquire);
+				if(headAfter > bufferCapacity && headAfter - bufferCapacity > first) {
+					events.erase(events.begin(), events.begin() + qMin<uint64_t>(events.size(), headAfter - bufferCapacity - first));
+				}
+			}
+		}
+		
+		// timestamps relative to the oldest event, in microseconds as expected by the trace viewers
+		int64_t origin = std::numeric_limits<int64_t>::max();
+		for(size_t t = 0; t < threadEvents.size(); t++) {
+			for(size_t i = 0; i < threadEvents[t].size(); i++) origin = qMin(origin, threadEvents[t][i].startNs);
+		}
+		
+		out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+		bool firstEvent = true;
+		for(size_t t = 0; t < threadEvents.size(); t++) {
+			if(threadNames[t]) {
+				out << (firstEvent ? "" : ",\n") << QString("{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %1, \"args\": {\"name\": \"%2\"}}")
+					.arg(tids[t]).arg(escape(threadNames[t]));
+				firstEvent = false;
+			}
+			const std::vector<Event> &events = threadEvents[t];
+			for(size_t i = 0; i < events.size(); i++) {
+				const Event &e = events[i];
+				out << (firstEvent ? "" : ",\n") << QString("{\"name\": \"%1\", \"cat\": \"rastersim\", \"ph\": \"X\", \"pid\": 1, \"tid\": %2, \"ts\": %3, \"dur\": %4")
+					.arg(escape(e.name)).arg(tids[t]).arg((e.startNs - origin) * 1e-3, 0, 'f', 3).arg((e.endNs - e.startNs) * 1e-3, 0, 'f', 3);
+				if(e.detail) out << QString(", \"args\": {\"detail\": \"%1\"}").arg(escape(e.detail));
+				out << "}";
+				firstEvent = false;
+			}
+		}
+		out << "\n]}\n";
+		return true;
+	}
+}
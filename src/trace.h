@@ -0,0 +1,71 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <atomic>
+#include <stdint.h>
+
+/* Scoped trace events (Chrome trace / Perfetto format) for planner and render paths.
+ * Every thread writes into its own ring buffer without locking, allocated with its first event, the most
+ * recent events of all threads can be written as JSON at any time and opened in chrome://tracing or ui.perfetto.dev.
+ * Tracing is disabled by default, a disabled scope costs a single relaxed atomic load.
+ *
+ *   void VisualizationWidget::paintContent(QPainter &painter) {
+ *       TRACE_SCOPE("paintContent");
+ *       ...
+ */
+namespace Trace {
+	extern std::atomic<bool> _enabled;
+	inline bool isEnabled() { return _enabled.load(std::memory_order_relaxed); }
+	void setEnabled(bool enabled);
+	
+	// shown as thread name in the trace, name must stay valid (e.g. a string literal); does not allocate
+	void setThreadName(const char *name);
+	// discards the recorded events of all threads and frees the buffers of threads that have ended
+	void clear();
+	bool writeJson(const QString &fileName);
+	
+	// events per thread kept in the ring buffer, older events are overwritten
+	static const unsigned bufferCapacity = 1 << 16;
+	
+	// records a complete event from construction to destruction; name and detail must stay valid (e.g. string literals)
+	class Scope {
+	public:
+		Scope(const char *name, const char *detail = NULL): name(name), detail(detail), startNs(isEnabled() ? now() : -1) { }
+		~Scope() { if(startNs >= 0) record(name, detail, startNs, now()); }
+		
+	private:
+		static int64_t now();
+		static void record(const char *name, const char *detail, int64_t startNs, int64_t endNs);
+		
+		const char *name, *detail;
+		int64_t startNs;
+	};
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+// traces the enclosing scope
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+// traces the enclosing scope with additional information, e.g. the planner class
+#define TRACE_SCOPE_DETAIL(name, detail) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name, detail)
+
+#endif // TRACE_H
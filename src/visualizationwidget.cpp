@@ -21,6 +21,7 @@
 #include <QImage>
 #include <cstdio>
 #include "abstractplanner.h"
+#include "trace.h"
 #include <QBitmap>
 
 VisualizationWidget::VisualizationWidget(QWidget *parent):
@@ -95,6 +96,8 @@ void VisualizationWidget::setPlanner(AbstractPlanner *planner) {
 	}
 	
 	_planner = planner;
+	plannerPath.clear();
+	plannerError.clear();
 	if(_planner) {
 		if(!_planner->debugLayers().isEmpty()) {
 			int idx = -1;
@@ -117,6 +120,8 @@ void VisualizationWidget::setPlanner(AbstractPlanner *planner) {
 }
 
 void VisualizationWidget::updatePlannerData() {
+	plannerPath = _planner->path();
+	plannerError = _planner->lastError();
 	updateContent();
 }
 void VisualizationWidget::handlePlannerConfigChanged(AbstractPlanner::ConfigElement element, AbstractPlanner::ConfigChange type, int index) {
@@ -154,6 +159,7 @@ void VisualizationWidget::handlePlannerConfigChanged(AbstractPlanner::ConfigElem
 }
 
 void VisualizationWidget::paintContent(QPainter &painter) {
+	TRACE_SCOPE("paintContent");
 	for(int i = 0; i < layers.size(); i++) {
 		const Layer &l = layers[i];
 		if(l.visible) {
@@ -170,7 +176,7 @@ void VisualizationWidget::paintContent(QPainter &painter) {
 				case Layer_Path:
 					// paint path
 					if(_planner) {
-						const Path &path = _planner->path();
+						const Path &path = plannerPath;
 						if(path.count() > 0) {
 							QPen pathPen(QPen(QColor(255, 0, 0), 3));
 							pathPen.setCosmetic(true);
@@ -209,7 +215,8 @@ void VisualizationWidget::paintContent(QPainter &painter) {
 				{
 					qreal zoom = zoomFactor();
 					AbstractPlanner::DebugLayer *debug = l.plannerDebugLayer;
-					if(zoom >= debug->minimumZoomFactor() && zoom <= debug->maximumZoomFactor()) {
+					// skipped while the planning thread calculates a path, repainted when it is published
+					if(zoom >= debug->minimumZoomFactor() && zoom <= debug->maximumZoomFactor() && _planner->dataMutex()->tryLock()) {
 						QTransform t = painter.transform().inverted();
 						QRectF area = t.mapRect(QRectF(rect())).normalized();
 						area.setLeft((int)area.left());
@@ -217,6 +224,7 @@ void VisualizationWidget::paintContent(QPainter &painter) {
 						area.setWidth(ceil(area.width()));
 						area.setHeight(ceil(area.height()));
 						debug->draw(painter, area.toRect().intersected(_map.rect()), zoom);
+						_planner->dataMutex()->unlock();
 					}
 				}
 				break;
@@ -251,10 +259,10 @@ void VisualizationWidget::paintContent(QPainter &painter) {
 
 void VisualizationWidget::paintOverlays(QPainter &painter, const QRect &area) {
 	if(_planner) {
-		if(_planner->path().isEmpty()) {
+		if(plannerPath.isEmpty()) {
 			painter.setPen(QPen(QColor(255, 0, 0)));
 			painter.setFont(QFont("Verdana", 36));
-			painter.drawText(area, Qt::AlignCenter, _planner->lastError());
+			painter.drawText(area, Qt::AlignCenter, plannerError);
 		}
 	}
 }
@@ -372,16 +380,19 @@ void VisualizationWidget::worldMouseReleaseEvent(const QPointF &, Qt::MouseButto
 			addLine(toolBoundingRect.topLeft(), toolBoundingRect.bottomRight(), mouseReleaseButton != Qt::LeftButton);
 			toolBoundingRect = _map.rect().intersected(toolBoundingRect);
 			if(_planner) _planner->updateMap(_map, toolBoundingRect);
+			emit mapEdited(toolBoundingRect);
 			updateContent();
 			break;
 		
 		case Tool_Pen:
 			toolBoundingRect = _map.rect().intersected(toolBoundingRect);
 			if(_planner) _planner->updateMap(_map, toolBoundingRect);
+			emit mapEdited(toolBoundingRect);
 			break;
 		case Tool_Rect:
 			addRect(toolBoundingRect, mouseReleaseButton == Qt::LeftButton ? _toolCost : 255 - _toolCost);
 			if(_planner) _planner->updateMap(_map, toolBoundingRect);
+			emit mapEdited(toolBoundingRect);
 			updateContent();
 			break;
 			
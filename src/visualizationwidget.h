@@ -33,6 +33,7 @@ public:
 	VisualizationWidget(QWidget *parent = NULL);
 	
 	void setMap(const QImage &map);
+	const QImage &map() const { return _map; }
 	void setPlanner(AbstractPlanner *planner);
 	
 	const Pose2D &start() const { return _start; }
@@ -91,6 +92,8 @@ public slots:
 signals:
 	void startPoseChanged();
 	void goalPoseChanged();
+	// emitted after the planner was updated with a map edit of the pen, line or rectangle tool
+	void mapEdited(const QRect &region);
 	
 protected:
 	void paintContent(QPainter &painter);
@@ -108,6 +111,9 @@ private slots:
 private:
 	QImage _map;
 	AbstractPlanner *_planner;
+	// copied on AbstractPlanner::dataChanged(), the planner may be working on the next path (background planning)
+	Path plannerPath;
+	QString plannerError;
 	
 	Pose2D _start, _goal;
 	QPointF mouseDownPos;
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2016 Martin Seeman, IfA, TU Dresden, Germany
+ * Copyright 2016 Chao Yao, IfA, TU Dresden, Germany
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XORSHIFT_H
+#define XORSHIFT_H
+
+#include <stdint.h>
+
+/* xorshift32 pseudo random number generator: unlike rand(), it gives the same sequence
+ * on every platform, so generated benchmark inputs are reproducible from their seed
+ */
+class XorShift32 {
+public:
+	XorShift32(uint32_t seed = 1): state(seed ? seed : 0x9e3779b9) { }
+	
+	inline uint32_t next() {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+	// uniformly distributed in [0, n)
+	inline unsigned bounded(unsigned n) { return n ? next() % n : 0; }
+	// uniformly distributed in [min, max]
+	inline int range(int min, int max) { return min + (int)bounded(max - min + 1); }
+	// uniformly distributed in [0, 1)
+	inline double uniform() { return next() * (1.0 / 4294967296.0); }
+
+private:
+	uint32_t state;
+};
+
+#endif // XORSHIFT_H